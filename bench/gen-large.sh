@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# gen-large.sh N
+#
+# Writes a large DwiSlpy source to stdout: N generated `def`s followed
+# by a main script that calls each of them once. It exercises the
+# parser, checker, and compiler on a big input rather than the run
+# time of any one loop.
+#
+n=${1:-2000}
+
+echo "# Generated by gen-large.sh $n; do not edit."
+echo
+i=0
+while [ $i -lt $n ]; do
+    cat <<DEFN
+def f$i(a : int, b : int) -> int:
+    t : int = a * $((i % 13 + 1)) + b
+    while t < 500:
+        t += (a + 1) * 3
+    if (t % 2) == 0:
+        return t // 2
+    else:
+        return t - b
+
+DEFN
+    i=$((i + 1))
+done
+
+echo "s : int = 0"
+i=0
+while [ $i -lt $n ]; do
+    echo "s = (s + f$i(s % 100, $i)) % 100000"
+    i=$((i + 1))
+done
+echo "print(s)"
@@ -8,15 +8,20 @@
 #include <exception>
 #include <algorithm>
 #include <sstream>
+#include <chrono>
 
 #include "dwislpy-ast.hh"
 #include "dwislpy-util.hh"
 #include "dwislpy-check.hh"
+#include "dwislpy-prof.hh"
+#include "dwislpy-trace.hh"
+#include "dwislpy-io.hh"
+#include "dwislpy-jit.hh"
 
 //
 // predicate function for Valu
 //
-bool predicate(Valu e) {
+bool predicate(const Valu& e) {
     if (std::holds_alternative<int>(e)) {
         int i = std::get<int>(e);
         return (bool)i;
@@ -26,8 +31,7 @@ bool predicate(Valu e) {
         return b;
     }
     if (std::holds_alternative<std::string>(e)) {
-        std::string s = std::get<std::string>(e);
-        return !(s.compare("") == 0);
+        return !std::get<std::string>(e).empty();
     }
     return false;
 }
@@ -69,6 +73,26 @@ std::string to_string(Valu v) {
     }
 }
 
+//
+// write_valu
+//
+// Outputs a DwiSlpy value as `to_string` would convert it, but without
+// building the string. Used by `print`.
+//
+void write_valu(std::ostream& os, const Valu& v) {
+    if (std::holds_alternative<int>(v)) {
+        os << std::get<int>(v);
+    } else if (std::holds_alternative<std::string>(v)) {
+        os << std::get<std::string>(v);
+    } else if (std::holds_alternative<bool>(v)) {
+        os << (std::get<bool>(v) ? "True" : "False");
+    } else if (std::holds_alternative<none>(v)) {
+        os << "None";
+    } else {
+        os << "<unknown>";
+    }
+}
+
 //
 // to_repr
 //
@@ -106,49 +130,184 @@ std::string to_repr(Valu v) {
 //    variables to their current values.
 //
 
+trace_ring* trace_active = nullptr;
+
 void Prgm::run(void) const {
+    Perf::counting = perfs;
+    Perf::reset();
     Ctxt main_ctxt { };
-    main->exec(defs,main_ctxt);
+    Valu rslt { None };
+    main->exec(defs,main_ctxt,rslt);
 }
 
-std::optional<Valu> Defn::call(const Defs& defs,
-                               const Expn_vec& args,
-                               const Ctxt& ctxt) {
+// find_callee
+//
+// Looks up the definition a call names, checking that it exists and
+// takes as many arguments as the call gives it. Calls are bound to
+// their definition by `chck`, so this is only needed to run a program
+// that was never checked.
+//
+static Defn* find_callee(const Defs& defs, const Name& name, size_t num_args, Locn locn) {
+    if (defs.count(name) == 0) {
+        std::string msg = "Run-time error: procedure '" + name +"'";
+        msg += " is not defined.";
+        throw DwislpyError { locn, msg };
+    }
+
+    Defn_ptr def = defs.at(name);
+
+    if (def->symt.get_frmls_size() != num_args) {
+        std::string msg = "Incorrect number of args found for function " 
+            + name + ": expected " + std::to_string(def->symt.get_frmls_size()) + ", saw " 
+            + std::to_string(num_args) + ".";
+        throw DwislpyError { locn, msg };
+    }
+    return def.get();
+}
+
+bool Defn::memoizing = false;
+size_t Defn::memo_size = 1 << 16;
+
+Flow Defn::call(const Defs& defs,
+                const Expn_vec& args,
+                const Ctxt& ctxt,
+                Valu& rslt) {
     Ctxt locals {};
     int i=0;
     for (Expn_ptr expn : args) {
         std::string local = formal(i)->name;
         i++;
-        Valu value = expn->eval(defs,ctxt);
-        locals[local] = value;
+        locals[local] = expn->eval(defs,ctxt);
     }
-    return blck->exec(defs, locals);
+    return exec_body(defs, locals, rslt);
 }
 
-std::optional<Valu> Blck::exec(const Defs& defs, Ctxt& ctxt) const {
-    for (Stmt_ptr s : stmts) {
-        std::optional<Valu> rv = s->exec(defs,ctxt);
-        if (rv.has_value()) {
-            return rv;
-        } 
+// call_memo
+//
+// Calls a pure definition, reusing the value it returned when last
+// called with the same arguments. When its table reaches `memo_size`
+// entries, it is emptied.
+//
+Flow Defn::call_memo(const Defs& defs,
+                     const Expn_vec& args,
+                     const Ctxt& ctxt,
+                     Valu& rslt) {
+    std::vector<Valu> values {};
+    for (Expn_ptr expn : args) {
+        values.push_back(expn->eval(defs,ctxt));
+    }
+    Memo::const_iterator found = memo.find(values);
+    if (found != memo.end()) {
+        rslt = found->second;
+        return RETN;
+    }
+    Ctxt locals {};
+    for (size_t i = 0; i < values.size(); i++) {
+        locals[formal(i)->name] = values[i];
+    }
+    Flow flow = exec_body(defs, locals, rslt);
+    if (flow == RETN) {
+        if (memo.size() >= memo_size) {
+            memo.clear();
+        }
+        memo.emplace(std::move(values), rslt);
     }
-    return std::nullopt;
+    return flow;
+}
+
+Flow Defn::exec_body(const Defs& defs, Ctxt& locals, Valu& rslt) {
+    if (Jit::threshold > 0 && !Prof::active && !trace_active) {
+        if (native == nullptr && !jit_never
+            && ++jit_calls >= Jit::threshold) {
+            Jit::compile(*this);
+        }
+        if (native != nullptr) {
+            if (Jit::call(*this, locals, rslt)) {
+                return RETN;
+            }
+        }
+    }
+    Prof_scope scope {*this};
+    if (trace_active) {
+        trace_record(trace_active, TRACE_CALL, line());
+        Flow flow = blck->exec(defs, locals, rslt);
+        trace_record(trace_active, TRACE_RETURN, line());
+        return flow;
+    }
+    return blck->exec(defs, locals, rslt);
+}
+
+size_t Args_hash::operator()(const std::vector<Valu>& args) const {
+    size_t h = args.size();
+    for (const Valu& v : args) {
+        size_t vh = v.index();
+        if (std::holds_alternative<int>(v)) {
+            vh = std::hash<int>{}(std::get<int>(v));
+        } else if (std::holds_alternative<bool>(v)) {
+            vh = std::hash<bool>{}(std::get<bool>(v)) + 2;
+        } else if (std::holds_alternative<std::string>(v)) {
+            vh = std::hash<std::string>{}(std::get<std::string>(v));
+        }
+        h = h * 1000003 ^ vh;
+    }
+    return h;
+}
+
+bool Args_equal::operator()(const std::vector<Valu>& args1,
+                            const std::vector<Valu>& args2) const {
+    if (args1.size() != args2.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < args1.size(); i++) {
+        const Valu& v1 = args1[i];
+        const Valu& v2 = args2[i];
+        if (v1.index() != v2.index()) {
+            return false;
+        }
+        if (std::holds_alternative<int>(v1)
+            && std::get<int>(v1) != std::get<int>(v2)) {
+            return false;
+        }
+        if (std::holds_alternative<bool>(v1)
+            && std::get<bool>(v1) != std::get<bool>(v2)) {
+            return false;
+        }
+        if (std::holds_alternative<std::string>(v1)
+            && std::get<std::string>(v1) != std::get<std::string>(v2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Flow Blck::exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const {
+    for (const Stmt_ptr& s : stmts) {
+        Prof_scope scope {*s};
+        if (Perf::counting) {
+            Perf::statements++;
+        }
+        if (s->exec(defs,ctxt,rslt) == RETN) {
+            return RETN;
+        }
+    }
+    return FALL;
 }
 
 // ??? change this
-std::optional<Valu> Ntro::exec(const Defs& defs, Ctxt& ctxt) const {
+Flow Ntro::exec(const Defs& defs, Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
     ctxt[name] = expn->eval(defs,ctxt);
-    return std::nullopt;
+    return FALL;
 }
 
-std::optional<Valu> Asgn::exec(const Defs& defs,
-                               Ctxt& ctxt) const {
+Flow Asgn::exec(const Defs& defs, Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
     ctxt[name] = expn->eval(defs,ctxt);
-    return std::nullopt;
+    return FALL;
 }
 
-std::optional<Valu> PlEq::exec(const Defs& defs,
-                               Ctxt& ctxt) const {
+Flow PlEq::exec(const Defs& defs, Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
     // from Lkup
     if (ctxt.count(name) <= 0) {
         std::string msg = "Run-time error: variable '" + name +"'";
@@ -156,28 +315,26 @@ std::optional<Valu> PlEq::exec(const Defs& defs,
         throw DwislpyError { where(), msg };
     }
 
-    Valu n = ctxt.at(name);
     Valu e = expn->eval(defs,ctxt);
-    
+    apply(ctxt.at(name),e);
+    return FALL;
+}
+
+void PlEq::apply(Valu& n, const Valu& e) const {
     if (std::holds_alternative<int>(e) &&
         std::holds_alternative<int>(n)) {
-        int in = std::get<int>(n);
-        int ie = std::get<int>(e);
-        ctxt[name] = Valu {in + ie};
+        std::get<int>(n) += std::get<int>(e);
     } else if (std::holds_alternative<std::string>(e) &&
                std::holds_alternative<std::string>(n)) {
-        std::string sn = std::get<std::string>(n);
-        std::string se = std::get<std::string>(e);
-        ctxt[name] = Valu {sn + se};
+        std::get<std::string>(n) += std::get<std::string>(e);
     } else {
         std::string msg = "Run-time error: wrong operand type for plus equals.";
         throw DwislpyError { where(), msg };
     }        
-    return std::nullopt;
 }
 
-std::optional<Valu> MiEq::exec(const Defs& defs,
-                               Ctxt& ctxt) const {
+Flow MiEq::exec(const Defs& defs, Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
     // from Lkup
     if (ctxt.count(name) <= 0) {
         std::string msg = "Run-time error: variable '" + name +"'";
@@ -185,23 +342,23 @@ std::optional<Valu> MiEq::exec(const Defs& defs,
         throw DwislpyError { where(), msg };
     }
 
-    Valu n = ctxt.at(name);
     Valu e = expn->eval(defs,ctxt);
-    
+    apply(ctxt.at(name),e);
+    return FALL;
+}
+
+void MiEq::apply(Valu& n, const Valu& e) const {
     if (std::holds_alternative<int>(e) &&
         std::holds_alternative<int>(n)) {
-        int in = std::get<int>(n);
-        int ie = std::get<int>(e);
-        ctxt[name] = Valu {in - ie};
+        std::get<int>(n) -= std::get<int>(e);
     } else {
         std::string msg = "Run-time error: wrong operand type for minus equals.";
         throw DwislpyError { where(), msg };
     }        
-    return std::nullopt;
 }
 
-std::optional<Valu> TiEq::exec(const Defs& defs,
-                               Ctxt& ctxt) const {
+Flow TiEq::exec(const Defs& defs, Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
     // from Lkup
     if (ctxt.count(name) <= 0) {
         std::string msg = "Run-time error: variable '" + name +"'";
@@ -209,91 +366,79 @@ std::optional<Valu> TiEq::exec(const Defs& defs,
         throw DwislpyError { where(), msg };
     }
 
-    Valu n = ctxt.at(name);
     Valu e = expn->eval(defs,ctxt);
-    
+    apply(ctxt.at(name),e);
+    return FALL;
+}
+
+void TiEq::apply(Valu& n, const Valu& e) const {
     if (std::holds_alternative<int>(e) &&
         std::holds_alternative<int>(n)) {
-        int in = std::get<int>(n);
-        int ie = std::get<int>(e);
-        ctxt[name] = Valu {in * ie};
+        std::get<int>(n) *= std::get<int>(e);
     } else {
         std::string msg = "Run-time error: wrong operand type for times equals.";
         throw DwislpyError { where(), msg };
     }        
-    return std::nullopt;
 }
 
-std::optional<Valu> Pass::exec([[maybe_unused]] const Defs& defs,
-                               [[maybe_unused]] Ctxt& ctxt) const {
+Flow Pass::exec([[maybe_unused]] const Defs& defs,
+                [[maybe_unused]] Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
     // does nothing!
-    return std::nullopt;
+    return FALL;
 }
   
-std::optional<Valu> Prnt::exec(const Defs& defs, Ctxt& ctxt) const {
+Flow Prnt::exec(const Defs& defs, Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
+    if (trace_active) trace_record(trace_active, TRACE_PRINT, line());
+    Perf::io_calls++;
     if (prms.empty()) {
-        std::cout << std::endl;
-        return std::nullopt;
+        std::cout << '\n';
+        return FALL;
     }
 
-    for (Expn_ptr expn : prms) {
-        std::cout << to_string(expn->eval(defs,ctxt)) << std::endl;
+    for (const Expn_ptr& expn : prms) {
+        write_valu(std::cout, expn->eval(defs,ctxt));
+        std::cout << '\n';
     }
-    return std::nullopt;
+    return FALL;
 }
 
-std::optional<Valu> Proc::exec(const Defs& defs, Ctxt& ctxt) const {
-
-    if (defs.count(name) == 0) {
-        std::string msg = "Run-time error: procedure '" + name +"'";
-        msg += " is not defined.";
-        throw DwislpyError { where(), msg };
-    }
-
-    Defn_ptr def = defs.at(name);
-
-    if (def->symt.get_frmls_size() != args.size()) {
-        std::string msg = "Incorrect number of args found for function " 
-            + name + ": expected " + std::to_string(def->symt.get_frmls_size()) + ", saw " 
-            + std::to_string(args.size()) + ".";
-        throw DwislpyError { where(), msg };
-    }
-
-    def->call(defs,args,ctxt);
-    return std::nullopt;
+Flow Proc::exec(const Defs& defs, Ctxt& ctxt,
+                [[maybe_unused]] Valu& rslt) const {
+    Defn* def = defn ? defn : find_callee(defs,name,args.size(),where());
+    Valu proc_rslt { None };
+    def->call(defs,args,ctxt,proc_rslt);
+    return FALL;
 }
 
-std::optional<Valu> Whle::exec(const Defs& defs, Ctxt& ctxt) const {
+Flow Whle::exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const {
     while (predicate(expn->eval(defs,ctxt))) {
-        std::optional<Valu> rv = blck->exec(defs,ctxt);
-        if (rv.has_value()) {
-            return rv;
-        } 
+        if (trace_active) trace_record(trace_active, TRACE_LOOP, line());
+        if (blck->exec(defs,ctxt,rslt) == RETN) {
+            return RETN;
+        }
     }
-    return std::nullopt;
+    return FALL;
 }
 
-std::optional<Valu> Tern::exec(const Defs& defs, Ctxt& ctxt) const {
+Flow Tern::exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const {
     if (predicate(expn->eval(defs,ctxt))) {
-        std::optional<Valu> rv = if_blck->exec(defs,ctxt);
-        if (rv.has_value()) {
-            return rv;
-        } 
+        return if_blck->exec(defs,ctxt,rslt);
     } else {
-        std::optional<Valu> rv = else_blck->exec(defs,ctxt);
-        if (rv.has_value()) {
-            return rv;
-        } 
+        return else_blck->exec(defs,ctxt,rslt);
     }
-    return std::nullopt;
 }
 
-std::optional<Valu> Retn::exec([[maybe_unused]] const Defs& defs, [[maybe_unused]] Ctxt& ctxt) const {
-    return std::optional<Valu> { Valu { None } };
+Flow Retn::exec([[maybe_unused]] const Defs& defs,
+                [[maybe_unused]] Ctxt& ctxt, Valu& rslt) const {
+    rslt = Valu { None };
+    return RETN;
 }
 
-std::optional<Valu> RetE::exec(const Defs& defs, Ctxt& ctxt) const {
-    return std::optional<Valu> { expn->eval(defs, ctxt) };
+Flow RetE::exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const {
+    rslt = expn->eval(defs, ctxt);
+    return RETN;
 }
 
 //
@@ -304,34 +449,29 @@ std::optional<Valu> RetE::exec(const Defs& defs, Ctxt& ctxt) const {
 //
 
 Valu Func::eval(const Defs& defs, const Ctxt& ctxt) const {
-
-    if (defs.count(name) == 0) {
-        std::string msg = "Run-time error: procedure '" + name +"'";
-        msg += " is not defined.";
-        throw DwislpyError { where(), msg };
+    if (builtin) {
+        return builtin->eval(defs,ctxt);
     }
-
-    Defn_ptr def = defs.at(name);
-
-    if (def->symt.get_frmls_size() != args.size()) {
-        std::string msg = "Incorrect number of args found for function " 
-            + name + ": expected " + std::to_string(def->symt.get_frmls_size()) + ", saw " 
-            + std::to_string(args.size()) + ".";
-        throw DwislpyError { where(), msg };
-    }
-
-    std::optional<Valu> result = def->call(defs,args,ctxt);
-    if (!result.has_value()) {
+    Defn* def = defn ? defn : find_callee(defs,name,args.size(),where());
+    Valu rslt { None };
+    Flow flow = (Defn::memoizing && def->pure)
+        ? def->call_memo(defs,args,ctxt,rslt)
+        : def->call(defs,args,ctxt,rslt);
+    if (flow != RETN) {
         std::string msg = "Run-time error: no value returned from ";
         msg += "function '" + name +"'.";
         throw DwislpyError { where(), msg };
     }
-    return result.value();
+    return rslt;
 }
 
 Valu Plus::eval(const Defs& defs, const Ctxt& ctxt) const {
     Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu Plus::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -348,21 +488,32 @@ Valu Plus::eval(const Defs& defs, const Ctxt& ctxt) const {
     }        
 }
 
+// Conj::eval, Disj::eval
+//
+// Short-circuit: the right side is only evaluated if the left side
+// does not decide the result, as in the code from Conj::trans_cndn.
+//
 Valu Conj::eval(const Defs& defs, const Ctxt& ctxt) const {
-    Valu lv = left->eval(defs,ctxt);
-    Valu rv = rght->eval(defs,ctxt);
-    return Valu { predicate(lv) && predicate(rv) };
+    if (!predicate(left->eval(defs,ctxt))) {
+        return Valu { false };
+    }
+    return Valu { predicate(rght->eval(defs,ctxt)) };
 }
 
 Valu Disj::eval(const Defs& defs, const Ctxt& ctxt) const {
-    Valu lv = left->eval(defs,ctxt);
-    Valu rv = rght->eval(defs,ctxt);
-    return Valu { predicate(lv) || predicate(rv) };
+    if (predicate(left->eval(defs,ctxt))) {
+        return Valu { true };
+    }
+    return Valu { predicate(rght->eval(defs,ctxt)) };
 }
 
 Valu Less::eval(const Defs& defs, const Ctxt& ctxt) const {
     Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu Less::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -375,8 +526,12 @@ Valu Less::eval(const Defs& defs, const Ctxt& ctxt) const {
 }
 
 Valu LtEq::eval(const Defs& defs, const Ctxt& ctxt) const {
-       Valu lv = left->eval(defs,ctxt);
+    Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu LtEq::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -391,6 +546,10 @@ Valu LtEq::eval(const Defs& defs, const Ctxt& ctxt) const {
 Valu Eqal::eval(const Defs& defs, const Ctxt& ctxt) const {
     Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu Eqal::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -416,6 +575,10 @@ Valu Negt::eval(const Defs& defs, const Ctxt& ctxt) const {
 Valu Mnus::eval(const Defs& defs, const Ctxt& ctxt) const {
     Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu Mnus::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -430,6 +593,10 @@ Valu Mnus::eval(const Defs& defs, const Ctxt& ctxt) const {
 Valu Tmes::eval(const Defs& defs, const Ctxt& ctxt) const {
     Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu Tmes::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -445,6 +612,10 @@ Valu Tmes::eval(const Defs& defs, const Ctxt& ctxt) const {
 Valu IDiv::eval(const Defs& defs, const Ctxt& ctxt) const {
     Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu IDiv::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -463,6 +634,10 @@ Valu IDiv::eval(const Defs& defs, const Ctxt& ctxt) const {
 Valu IMod::eval(const Defs& defs, const Ctxt& ctxt) const {
     Valu lv = left->eval(defs,ctxt);
     Valu rv = rght->eval(defs,ctxt);
+    return apply(lv,rv);
+}
+
+Valu IMod::apply(const Valu& lv, const Valu& rv) const {
     if (std::holds_alternative<int>(lv)
         && std::holds_alternative<int>(rv)) {
         int ln = std::get<int>(lv);
@@ -493,14 +668,23 @@ Valu Lkup::eval([[maybe_unused]] const Defs& defs, const Ctxt& ctxt) const {
 }
 
 Valu Inpt::eval([[maybe_unused]] const Defs& defs, const Ctxt& ctxt) const {
-    Valu v = expn->eval(defs,ctxt);
+    return apply(expn->eval(defs,ctxt));
+}
+
+Valu Inpt::apply(const Valu& v) const {
     if (std::holds_alternative<std::string>(v)) {
         //
-        std::string prompt = std::get<std::string>(v);
-        std::cout << prompt;
+        std::cout << std::get<std::string>(v);
+        std::cout.flush(); // So that the prompt appears.
         //
         std::string vl;
-        std::cin >> vl;
+        if (Inbuf::active) {
+            Inbuf::active->read_line(vl);
+        } else {
+            std::getline(std::cin, vl);
+        }
+        if (trace_active) trace_record(trace_active, TRACE_INPUT, line());
+        Perf::io_calls++;
         //
         return Valu {vl};
     } else {
@@ -509,12 +693,55 @@ Valu Inpt::eval([[maybe_unused]] const Defs& defs, const Ctxt& ctxt) const {
     }
 }
 
+bool Perf::counting = false;
+long long Perf::statements = 0;
+long long Perf::io_calls = 0;
+static std::chrono::steady_clock::time_point perf_started;
+
+void Perf::reset(void) {
+    statements = 0;
+    io_calls = 0;
+    perf_started = std::chrono::steady_clock::now();
+}
+
+Valu Perf::eval(const Defs& defs, const Ctxt& ctxt) const {
+    return apply(expn->eval(defs,ctxt));
+}
+
+Valu Perf::apply(const Valu& v) const {
+    if (!std::holds_alternative<int>(v)) {
+        std::string msg = "Run-time error: counter is not an int.";
+        throw DwislpyError { where(), msg };
+    }
+    long long count;
+    switch (std::get<int>(v)) {
+    case INSTRUCTIONS:
+        count = statements;
+        break;
+    case CYCLES:
+        count = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - perf_started).count();
+        break;
+    case SYSCALLS:
+        count = io_calls;
+        break;
+    default:
+        std::string msg = "Run-time error: no counter ";
+        msg += std::to_string(std::get<int>(v)) + ".";
+        throw DwislpyError { where(), msg };
+    }
+    return Valu {(int)count};
+}
+
 Valu IntC::eval([[maybe_unused]] const Defs& defs, const Ctxt& ctxt) const {
+    return apply(expn->eval(defs,ctxt));
+}
+
+Valu IntC::apply(const Valu& v) const {
     //
     // The integer conversion operation does nothing in this
     // version of DWISLPY.
     //
-    Valu v = expn->eval(defs,ctxt);
     if (std::holds_alternative<int>(v)) {
         return Valu {v};
     } else if (std::holds_alternative<std::string>(v)) {
@@ -822,6 +1049,12 @@ void IntC::output(std::ostream& os) const {
     os << ")";
 }
 
+void Perf::output(std::ostream& os) const {
+    os << "perf(";
+    expn->output(os);
+    os << ")";
+}
+
 void StrC::output(std::ostream& os) const {
     os << "str(";
     expn->output(os);
@@ -1076,6 +1309,12 @@ void IntC::dump(int level) const {
     expn->dump(level+1);
 }
 
+void Perf::dump(int level) const {
+    dump_indent(level);
+    std::cout << "PERF" << std::endl;
+    expn->dump(level+1);
+}
+
 void StrC::dump(int level) const {
     dump_indent(level);
     std::cout << "STRC" << std::endl;
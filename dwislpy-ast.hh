@@ -27,10 +27,13 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <set>
 #include <memory>
 #include <utility>
 #include <iostream>
 #include <variant>
+#include <optional>
+#include <functional>
 #include "dwislpy-util.hh"
 #include "dwislpy-check.hh"
 #include "dwislpy-inst.hh"
@@ -43,6 +46,62 @@
 typedef std::variant<int, bool, std::string, none> Valu;
 typedef std::optional<Valu> RtnO;
 
+// Helpers on values, defined in dwislpy-ast.cc.
+//
+bool predicate(const Valu& e);              // Its truth, as a condition.
+std::string to_string(Valu v);              // As `str` converts it.
+void write_valu(std::ostream& os, const Valu& v); // As `print` outputs it.
+
+// Flow
+//
+// The return type of `exec`: whether a statement finished normally,
+// so that execution falls through to the next one (FALL), or executed
+// a `return` (RETN). In the latter case the returned value has been
+// written to the `rslt` slot of the frame of the definition's call.
+//
+enum Flow { FALL, RETN };
+
+// Frame, Valu_fn, Int_fn, Cndn_fn, Stmt_fn
+//
+// Used by the closure-compiled engine, `Prgm::run_compiled` (see
+// dwislpy-closure.cc). The `clos` methods turn the checked code into a
+// tree of C++ closures once, which then run without walking the AST.
+// A definition's variables live in the slots of a `Frame`, at indices
+// fixed when it is compiled, rather than in a `Ctxt` keyed by their
+// names. A slot is `set` once the variable's introduction has run.
+//
+struct Slot {
+    Valu valu;
+    bool set = false;
+};
+typedef std::vector<Slot> Frame;
+typedef std::function<Valu(Frame&)> Valu_fn;      // An expression's value.
+typedef std::function<int(Frame&)> Int_fn;        // ... known to be an int.
+typedef std::function<bool(Frame&)> Cndn_fn;      // ... as a condition.
+typedef std::function<Flow(Frame&,Valu&)> Stmt_fn; // A statement, as `exec`.
+class Scope;
+
+// Memo
+//
+// A table of the values returned by a pure definition, keyed by the
+// values of the arguments it was called with. Used by `--memoize`.
+//
+struct Args_hash {
+    size_t operator()(const std::vector<Valu>& args) const;
+};
+struct Args_equal {
+    bool operator()(const std::vector<Valu>& args1,
+                    const std::vector<Valu>& args2) const;
+};
+typedef std::unordered_map<std::vector<Valu>,Valu,Args_hash,Args_equal> Memo;
+
+// Native_fn
+//
+// A definition compiled to machine code by the JIT (see dwislpy-jit.hh),
+// taking its int and bool arguments in order.
+//
+typedef long (*Native_fn)(long,long,long,long,long,long);
+
 //
 // We "pre-declare" each AST subclass for mutually recursive definitions.
 //
@@ -84,6 +143,7 @@ class Equl;
 class Inpt;
 class IntC;
 class StrC;
+class Perf;
 class Lkup;
 class Ltrl;
 
@@ -93,12 +153,14 @@ class Ltrl;
 
 typedef std::string Name;
 typedef std::unordered_map<Name,Valu> Ctxt;
+typedef std::unordered_map<Name,std::set<Name>> Call_graph;
 //
 typedef std::shared_ptr<Lkup> Lkup_ptr; 
 typedef std::shared_ptr<Ltrl> Ltrl_ptr; 
 typedef std::shared_ptr<IntC> IntC_ptr; 
 typedef std::shared_ptr<StrC> StrC_ptr; 
 typedef std::shared_ptr<Inpt> Inpt_ptr; 
+typedef std::shared_ptr<Perf> Perf_ptr; 
 typedef std::shared_ptr<Plus> Plus_ptr; 
 typedef std::shared_ptr<Mnus> Mnus_ptr; 
 typedef std::shared_ptr<Tmes> Tmes_ptr;
@@ -165,6 +227,7 @@ public:
     virtual void output(std::ostream& os) const = 0;
     virtual void dump(int level = 0) const = 0;
     Locn where(void) const { return locn; }
+    int line(void) const { return locn.line; } // Cheaper than where().
 };
 
 //
@@ -182,6 +245,12 @@ public:
 // the Blck::exec, Stmt::exec, and Expn::eval methods of the various
 // syntactic components that constitute the Prgm object.
 //
+// Checking also builds the program's call graph, `calls`, which maps
+// the name of each definition (and "main", for the main script) to the
+// names of the definitions it calls. From it, `Prgm::chck` marks each
+// definition as `pure` or not and as `live` or not; only the live ones,
+// those reachable from the main script, are translated and compiled.
+//
 
 class Prgm : public AST {
 public:
@@ -191,6 +260,9 @@ public:
     SymT main_symt;
     SymT_ptr glbl_symt_ptr; // New for Homework 5.
     INST_vec main_code;     // New for Homework 5.
+    bool translated = false; // => `trans` has been done.
+    Call_graph calls;       // Who calls whom. Built by Prgm::chck.
+    bool perfs = false;     // => it calls `perf`. Set by Prgm::chck.
     //
     Prgm(Defs ds, Blck_ptr mn, Locn lo) :
         AST {lo}, defs {ds}, main {mn} { 
@@ -201,9 +273,15 @@ public:
     virtual void chck(void);                     // Verify the code.
     virtual void dump(int level = 0) const;
     virtual void run(void) const;                // Execute the program.
+    virtual void run_compiled(void);             // ... as closures.
+    virtual void run_ir(void);                   // ... as IR, on a VM.
     virtual void output(std::ostream& os) const; // Output formatted code.
     virtual void trans(void);                    // Translate to IR. (HW5)
     virtual void compile(std::ostream& os);      // Generate MIPS. (HW5)
+    virtual void compile_x86(std::ostream& os);  // ... or x86-64.
+    void build_call_graph(void);                 // Fill in `calls`.
+    void find_pure_defns(void);                  // Set each Defn's `pure`.
+    void find_live_defns(void);                  // Set each Defn's `live`.
 };
 
 
@@ -221,6 +299,17 @@ public:
     Type rety;
     Blck_ptr blck;
     INST_vec code; // New for Homework 5.
+    bool pure = false; // No I/O, even by its callees. Set by Prgm::chck.
+    bool live = true;  // Reachable from the main script. Set by Prgm::chck.
+    Memo memo;         // Results of calls, when memoizing.
+    Stmt_fn body_fn;   // The body as a closure. Set by Defn::clos.
+    size_t frame_size = 0; // Slots in its frame. Set by Defn::clos.
+    size_t jit_calls = 0;  // Calls so far, counted when tiering.
+    Native_fn native = nullptr; // Its machine code. Set by Jit::compile.
+    bool jit_never = false;     // => it can't be compiled by the JIT.
+    //
+    static bool memoizing;   // Set by `--memoize`.
+    static size_t memo_size; // Bound on the entries in each `memo`.
     //
     Defn(Name nm, SymT sy, Type rt, Blck_ptr bk, Locn lo) : 
         AST {lo}, name {nm}, symt {sy}, rety {rt}, blck {bk} { }
@@ -230,7 +319,12 @@ public:
     Type returns(void) const;
     SymInfo_ptr formal(int i) const;
     //
-    std::optional<Valu> call(const Defs& defs, const Expn_vec& args, const Ctxt& ctxt);
+    Flow call(const Defs& defs, const Expn_vec& args, const Ctxt& ctxt, Valu& rslt);
+    Flow call_memo(const Defs& defs, const Expn_vec& args, const Ctxt& ctxt, Valu& rslt);
+    Flow exec_body(const Defs& defs, Ctxt& locals, Valu& rslt);
+    Flow call_compiled(const std::vector<Valu_fn>& args, Frame& frame, Valu& rslt);
+    Flow call_memo_compiled(const std::vector<Valu_fn>& args, Frame& frame, Valu& rslt);
+    void clos(void);       // Compile to closures.
     virtual void chck(Defs& defs);
     virtual void dump(int level = 0) const;
     virtual void output(std::ostream& os) const; // Output formatted code.
@@ -247,12 +341,13 @@ public:
     Stmt_vec stmts;
     virtual ~Blck(void) = default;
     Blck(Stmt_vec ss, Locn lo) : AST {lo}, stmts {ss}  { }
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 
@@ -270,7 +365,9 @@ public:
 //
 // These each support the methods:
 //
-//  * exec(ctxt): execute the statement within the stack frame
+//  * exec(defs,ctxt,rslt): execute the statement within the stack frame
+//        `ctxt`, reporting whether it executed a `return` (writing the
+//        returned value into `rslt`)
 //
 //  * output(os), output(os,indent): output formatted DwiSlpy code of
 //        the statement to the output stream `os`. The `indent` string
@@ -279,15 +376,19 @@ public:
 //
 //  * dump: output the syntax tree of the expression
 //
+//  * clos(scope): build a closure that does what `exec` does, within
+//        a frame laid out by `scope`
+//
 class Stmt : public AST {
 public:
     Stmt(Locn lo) : AST {lo} { }
     virtual ~Stmt(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const = 0;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const = 0;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt) = 0;
     virtual void output(std::ostream& os, std::string indent) const = 0;
     virtual void output(std::ostream& os) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code) = 0; // Generate IR code. (HW5)
+    virtual Stmt_fn clos(Scope& scope) const = 0; // Compile to a closure.
 };
 
 //
@@ -302,10 +403,11 @@ public:
         Stmt {l}, name {x}, type {t}, expn {e} { }
     virtual ~Ntro(void) = default;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 //
@@ -315,13 +417,15 @@ class Proc : public Stmt {
 public:
     Name name;
     Expn_vec args;
+    Defn* defn = nullptr; // The callee. Set by Proc::chck.
     Proc(Name x, Expn_vec a, Locn l) : Stmt {l}, name {x}, args {a} { }
     virtual ~Proc(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 //
@@ -333,11 +437,12 @@ public:
     Expn_ptr expn;
     Asgn(Name x, Expn_ptr e, Locn l) : Stmt {l}, name {x}, expn {e} { }
     virtual ~Asgn(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 //
@@ -348,11 +453,12 @@ public:
     Expn_vec prms;
     Prnt(Expn_vec a, Locn l) : Stmt {l}, prms {a} { }
     virtual ~Prnt(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 //
@@ -366,11 +472,12 @@ public:
     //
     Whle(Expn_ptr e, Blck_ptr n, Locn l) : Stmt {l}, expn {e}, blck {n} { }
     virtual ~Whle(void) = default; // default destructor i guess
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const; 
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 
 };
 
@@ -386,11 +493,12 @@ public:
     //
     Tern(Expn_ptr e, Blck_ptr i, Blck_ptr el, Locn l) : Stmt {l}, expn {e}, if_blck {i}, else_blck {el} { }
     virtual ~Tern(void) = default; // default destructor i guess
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 
 };
 
@@ -402,11 +510,12 @@ class Pass : public Stmt {
 public:
     Pass(Locn l) : Stmt {l} { }
     virtual ~Pass(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 
@@ -419,11 +528,13 @@ public:
     Expn_ptr expn;
     PlEq(Name n, Expn_ptr e, Locn lo) : Stmt {lo}, name {n}, expn {e} { }
     virtual ~PlEq(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
+    void apply(Valu& valu, const Valu& by) const;
 };
 
 //
@@ -435,11 +546,13 @@ public:
     Expn_ptr expn;
     MiEq(Name n, Expn_ptr e, Locn lo) : Stmt {lo}, name {n}, expn {e} { }
     virtual ~MiEq(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
+    void apply(Valu& valu, const Valu& by) const;
 };
 
 //
@@ -451,11 +564,13 @@ public:
     Expn_ptr expn;
     TiEq(Name n, Expn_ptr e, Locn lo) : Stmt {lo}, name {n}, expn {e} { }
     virtual ~TiEq(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
+    void apply(Valu& valu, const Valu& by) const;
 };
 
 //
@@ -465,11 +580,12 @@ class Retn : public Stmt {
 public:
     Retn(Locn lo) : Stmt {lo} { }
     virtual ~Retn(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 //
@@ -480,11 +596,12 @@ public:
     Expn_ptr expn;
     RetE(Expn_ptr e, Locn lo) : Stmt {lo}, expn {e} { }
     virtual ~RetE(void) = default;
-    virtual std::optional<Valu> exec(const Defs& defs, Ctxt& ctxt) const;
+    virtual Flow exec(const Defs& defs, Ctxt& ctxt, Valu& rslt) const;
     virtual Rtns chck(Rtns expd, Defs& defs, SymT& symt);
     virtual void output(std::ostream& os, std::string indent) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string exit, SymT& symt, INST_vec& code);
+    virtual Stmt_fn clos(Scope& scope) const;
 };
 
 
@@ -504,12 +621,16 @@ public:
 //   Inpt - obtains a string of input (after output of a prompt)
 //   IntC - converts a value to an integer value
 //   StrC - converts a value to a string value
+//   Perf - reads one of the program's performance counters
 //
 // These each support the methods:
 //
 //  * eval(ctxt): evaluate the expression; return its result
 //  * output(os): output formatted DwiSlpy code of the expression.
 //  * dump: output the syntax tree of the expression
+//  * clos(scope): build a closure that does what `eval` does. The
+//        `clos_int` and `clos_cndn` variants build one that yields an
+//        int, or the `predicate` of the value, without making a Valu.
 //
 class Expn : public AST {
 public:
@@ -519,6 +640,9 @@ public:
     virtual Type chck(Defs& defs, SymT& symt) = 0;
     virtual Valu eval(const Defs& defs, const Ctxt& ctxt) const = 0;
     virtual void trans(Name dest, SymT& symt, INST_vec& code) = 0;
+    virtual Valu_fn clos(Scope& scope) const = 0; // Compile to a closure,
+    virtual Int_fn clos_int(Scope& scope) const;   // ... one for an int value,
+    virtual Cndn_fn clos_cndn(Scope& scope) const; // ... or one for a condition.
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code); // Generate IR (HW5)
           
 };
@@ -526,10 +650,16 @@ public:
 //
 // Func - expression call for a function
 //
+// A call `perf(n)`, where the program defines no `perf` of its own, is
+// of the builtin instead. `Func::chck` sets `builtin` for it, and the
+// call then does whatever that `Perf` does.
+//
 class Func : public Expn {
 public:
     Name name;
     Expn_vec args;
+    Defn* defn = nullptr; // The callee. Set by Func::chck.
+    Perf_ptr builtin;     // Or the builtin `perf`. Set by Func::chck.
     Func(Name x, Expn_vec a, Locn l) : Expn {l}, name {x}, args {a} { }
     virtual ~Func(void) = default;
     virtual Valu eval(const Defs& defs, const Ctxt& ctxt) const;
@@ -537,6 +667,8 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -555,6 +687,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
 };
 
 //
@@ -572,6 +707,8 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -587,6 +724,8 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -602,6 +741,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -617,6 +759,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -632,6 +777,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -645,6 +793,8 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -663,6 +813,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
 };
 
 //
@@ -680,6 +833,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
 };
 
 //
@@ -697,6 +853,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
 };
 
 //
@@ -714,6 +873,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
+    Valu apply(const Valu& lv, const Valu& rv) const;
 };
 
 //
@@ -730,6 +892,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -747,6 +912,9 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    virtual Int_fn clos_int(Scope& scope) const;
+    virtual Cndn_fn clos_cndn(Scope& scope) const;
     virtual void trans_cndn(std::string then_lbl, std::string else_lbl, SymT& symt, INST_vec& code);
 };
 
@@ -763,6 +931,8 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    Valu apply(const Valu& v) const;
 };
 
 //
@@ -778,6 +948,8 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    Valu apply(const Valu& v) const;
 };
 
 //
@@ -793,6 +965,39 @@ public:
     virtual void output(std::ostream& os) const;
     virtual void dump(int level = 0) const;
     virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+};
+
+//
+// Perf - performance counter expression AST node
+//
+// `perf(n)` reads counter `n`, numbered as SPIM's read-counter syscall
+// numbers them, so that a program can measure a region of its own code.
+// Compiled, it makes that syscall. Interpreted, the counters are the
+// statements run, the microseconds elapsed, and the prints and inputs
+// performed, since the program started. Either way, a count is
+// truncated to an int, so the elapsed time reads correctly for the
+// first 2^31 microseconds (about 35 minutes) of a run. Statements are
+// only counted in a program that calls `perf` (see `Perf::counting`).
+//
+class Perf : public Expn {
+public:
+    enum Counter { INSTRUCTIONS = 0, CYCLES = 1, SYSCALLS = 2 };
+    static bool counting;        // => the interpreter counts statements.
+    static long long statements; // Counts kept by the interpreter.
+    static long long io_calls;
+    static void reset(void);
+    //
+    Expn_ptr expn;
+    Perf(Expn_ptr e, Locn lo) : Expn {lo}, expn {e} { }
+    virtual ~Perf(void) = default;
+    virtual Valu eval(const Defs& defs, const Ctxt& ctxt) const;
+    virtual Type chck(Defs& defs, SymT& symt);
+    virtual void output(std::ostream& os) const;
+    virtual void dump(int level = 0) const;
+    virtual void trans(std::string dest, SymT& symt, INST_vec& code);
+    virtual Valu_fn clos(Scope& scope) const;
+    Valu apply(const Valu& v) const;
 };
 
 #endif
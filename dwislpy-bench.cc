@@ -0,0 +1,347 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <chrono>
+#include <regex>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "dwislpy-ast.hh"
+#include "dwislpy-flex.hh"
+#include "dwislpy-bison.tab.hh"
+#include "dwislpy-util.hh"
+#include "dwislpy-main.hh"
+#include "dwislpy-jit.hh"
+#include "spim-cmd/spim-embed.h"
+
+//
+// dwislpy-bench - times each stage of the DWISLPY toolchain
+//
+// Usage: ./dwislpy-bench [--runs N] [--baseline base.json]
+//                        [--tolerance PCT] [--output out.json]
+//                        [--exceptions exceptions.s] file.slpy ...
+//
+// For each source file this parses, checks, interprets, and compiles
+// the program with a fresh `DWISLPY::Driver`, then assembles the MIPS
+// code and runs it with SPIM linked in-process (see spim-embed.h). The
+// stages timed are
+//
+//    parse      - Driver::parse
+//    chck       - Prgm::chck
+//    run        - Prgm::run
+//    closures   - Prgm::run_compiled, including building the closures
+//    jit        - Prgm::run, compiling hot definitions with the JIT
+//    ir         - Prgm::run_ir, on the IR that `compile` translated
+//    compile    - Prgm::compile, including translating to IR
+//    spim_load  - SPIM's assembler, on the compiled code
+//    spim_run   - SPIM's run_spim, on the compiled code
+//
+// Each file is run N times (default 5) and the minimum and median of
+// each stage are written as JSON, one record per line. If a baseline
+// is given, the minimums are compared against it and any stage slower
+// by more than PCT percent (default 15) and 0.5ms is reported as a
+// regression, giving a non-zero exit status.
+//
+// A source can opt out of the IR and SPIM stages with a
+// `# bench: no-spim` line, for features the compiler does not yet
+// support. A file `foo.in` next to `foo.slpy` is fed to the program as its input.
+// The interpreter's output is checked against that of its closures, of
+// its JIT, of the IR's VM, and of SPIM as a sanity check on the numbers
+// being compared.
+//
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* stages[] = {
+    "parse", "chck", "run", "closures", "jit", "ir", "compile",
+    "spim_load", "spim_run"
+};
+static const int num_stages = sizeof(stages) / sizeof(stages[0]);
+
+struct Timing {
+    std::string bench;
+    std::string stage;
+    double min_ms;
+    double median_ms;
+};
+
+template <typename F>
+double time_ms(F work) {
+    Clock::time_point start = Clock::now();
+    work();
+    std::chrono::duration<double,std::milli> elapsed = Clock::now() - start;
+    return elapsed.count();
+}
+
+std::string read_file(std::string name) {
+    std::ifstream in { name };
+    std::stringstream ss { };
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+std::string bench_name(std::string filename) {
+    size_t slash = filename.find_last_of("/");
+    std::string base = filename.substr(slash == std::string::npos ? 0 : slash+1);
+    return base.substr(0, base.find_last_of("."));
+}
+
+std::string stem_of(std::string filename) {
+    return filename.substr(0, filename.find_last_of("."));
+}
+
+double median_of(std::vector<double> xs) {
+    std::sort(xs.begin(), xs.end());
+    size_t n = xs.size();
+    return (n % 2 == 1) ? xs[n/2] : (xs[n/2-1] + xs[n/2]) / 2.0;
+}
+
+// time_run
+//
+// Times a run of the checked program, giving it `input` and collecting
+// its output in `out`.
+//
+double time_run(DWISLPY::Driver& dwislpy, const std::string& input,
+                std::stringstream& out) {
+    std::stringstream in { input };
+    std::streambuf* cout_buf = std::cout.rdbuf(out.rdbuf());
+    std::streambuf* cin_buf = std::cin.rdbuf(in.rdbuf());
+    double ms;
+    try {
+        ms = time_ms([&]() { dwislpy.run(); });
+    } catch (...) {
+        std::cout.rdbuf(cout_buf);
+        std::cin.rdbuf(cin_buf);
+        throw;
+    }
+    std::cout.rdbuf(cout_buf);
+    std::cin.rdbuf(cin_buf);
+    return ms;
+}
+
+// bench_file
+//
+// Runs all the stages on one source file `runs` times, adding the
+// resulting timings to `results`. Returns false if the program could
+// not be processed.
+//
+bool bench_file(std::string filename, int runs, std::vector<Timing>& results) {
+    std::string source = read_file(filename);
+    std::string input = read_file(stem_of(filename) + ".in");
+    std::string asm_name = stem_of(filename) + ".s";
+    bool use_spim = source.find("# bench: no-spim") == std::string::npos;
+
+    std::vector<double> times[num_stages];
+    for (int r = 0; r < runs; r++) {
+        DWISLPY::Driver dwislpy { filename };
+        std::stringstream interp_out { };
+        std::stringstream closure_out { };
+        std::stringstream jit_out { };
+        std::stringstream ir_out { };
+        std::stringstream mips { };
+
+        times[0].push_back(time_ms([&]() { dwislpy.parse(); }));
+        times[1].push_back(time_ms([&]() { dwislpy.check(); }));
+        times[2].push_back(time_run(dwislpy, input, interp_out));
+        dwislpy.closures = true;
+        times[3].push_back(time_run(dwislpy, input, closure_out));
+        if (r == 0 && interp_out.str() != closure_out.str()) {
+            std::cerr << filename << ": warning: interpreter and closure "
+                      << "outputs differ." << std::endl;
+        }
+        dwislpy.closures = false;
+        dwislpy.jit_threshold = JIT_THRESHOLD;
+        times[4].push_back(time_run(dwislpy, input, jit_out));
+        if (r == 0 && interp_out.str() != jit_out.str()) {
+            std::cerr << filename << ": warning: interpreter and JIT "
+                      << "outputs differ." << std::endl;
+        }
+        times[6].push_back(time_ms([&]() { dwislpy.compile(mips); }));
+        if (!use_spim) {
+            continue;
+        }
+        dwislpy.jit_threshold = 0;
+        dwislpy.ir = true;
+        times[5].push_back(time_run(dwislpy, input, ir_out));
+        if (r == 0 && interp_out.str() != ir_out.str()) {
+            std::cerr << filename << ": warning: interpreter and IR "
+                      << "outputs differ." << std::endl;
+        }
+
+        std::ofstream asm_file { asm_name };
+        asm_file << mips.str();
+        asm_file.close();
+
+        bool loaded = false;
+        bool finished = false;
+        times[7].push_back(time_ms([&]() {
+            loaded = spim_embed_load(asm_name.c_str());
+        }));
+        times[8].push_back(time_ms([&]() {
+            finished = loaded && spim_embed_run(input.c_str(), input.size());
+        }));
+        if (!finished) {
+            std::cerr << filename << ": SPIM did not run to completion."
+                      << std::endl;
+            return false;
+        }
+        size_t len;
+        const char* spim_out = spim_embed_output(&len);
+        if (r == 0 && interp_out.str() != std::string(spim_out, len)) {
+            std::cerr << filename << ": warning: interpreter and SPIM "
+                      << "outputs differ." << std::endl;
+        }
+    }
+
+    for (int s = 0; s < num_stages; s++) {
+        if (times[s].empty()) continue;
+        double min = *std::min_element(times[s].begin(), times[s].end());
+        results.push_back(Timing {bench_name(filename), stages[s],
+                                  min, median_of(times[s])});
+    }
+    return true;
+}
+
+void write_json(std::ostream& os, int runs, const std::vector<Timing>& results) {
+    os << "{" << std::endl;
+    os << "  \"runs\": " << runs << "," << std::endl;
+    os << "  \"results\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const Timing& t = results[i];
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "    {\"bench\": \"%s\", \"stage\": \"%s\", "
+                 "\"min_ms\": %.3f, \"median_ms\": %.3f}%s",
+                 t.bench.c_str(), t.stage.c_str(), t.min_ms, t.median_ms,
+                 i + 1 < results.size() ? "," : "");
+        os << line << std::endl;
+    }
+    os << "  ]" << std::endl;
+    os << "}" << std::endl;
+}
+
+// read_baseline
+//
+// Reads the records of a file written by `write_json`, keyed by
+// "bench/stage". Only our own one-record-per-line layout is handled.
+//
+std::map<std::string,Timing> read_baseline(std::string filename) {
+    std::map<std::string,Timing> base { };
+    std::ifstream in { filename };
+    if (in.fail()) {
+        std::cerr << "Unable to read baseline " << filename << "." << std::endl;
+        return base;
+    }
+    std::regex record {
+        "\"bench\": \"([^\"]*)\", \"stage\": \"([^\"]*)\", "
+        "\"min_ms\": ([0-9.]+), \"median_ms\": ([0-9.]+)"
+    };
+    std::string line;
+    while (std::getline(in, line)) {
+        std::smatch m;
+        if (std::regex_search(line, m, record)) {
+            base[m[1].str() + "/" + m[2].str()] =
+                Timing {m[1], m[2], std::stod(m[3]), std::stod(m[4])};
+        }
+    }
+    return base;
+}
+
+// compare
+//
+// Reports each stage against its baseline on `std::cerr`. Returns
+// the number of regressions found.
+//
+int compare(const std::vector<Timing>& results,
+            const std::map<std::string,Timing>& base, double tolerance) {
+    int regressions = 0;
+    for (const Timing& t : results) {
+        std::string key = t.bench + "/" + t.stage;
+        char line[256];
+        if (base.count(key) == 0) {
+            snprintf(line, sizeof(line), "%-10s %-10s %10.3f ms   (no baseline)",
+                     t.bench.c_str(), t.stage.c_str(), t.min_ms);
+            std::cerr << line << std::endl;
+            continue;
+        }
+        double was = base.at(key).min_ms;
+        double change = was > 0.0 ? 100.0 * (t.min_ms - was) / was : 0.0;
+        bool slower = change > tolerance && t.min_ms - was > 0.5;
+        snprintf(line, sizeof(line), "%-10s %-10s %10.3f ms   was %10.3f ms  %+7.1f%%%s",
+                 t.bench.c_str(), t.stage.c_str(), t.min_ms, was, change,
+                 slower ? "  REGRESSION" : "");
+        std::cerr << line << std::endl;
+        if (slower) regressions++;
+    }
+    return regressions;
+}
+
+char* flag_value(int argc, char** argv, std::string flag) {
+    for (int i=1; i<argc-1; i++) {
+        if (strcmp(flag.c_str(),argv[i]) == 0) return argv[i+1];
+    }
+    return nullptr;
+}
+
+// * * * * *
+//
+// main - the DWISLPY benchmark harness
+//
+int main(int argc, char** argv) {
+
+    char* runs_arg   = flag_value(argc,argv,"--runs");
+    char* base_arg   = flag_value(argc,argv,"--baseline");
+    char* tol_arg    = flag_value(argc,argv,"--tolerance");
+    char* out_arg    = flag_value(argc,argv,"--output");
+    char* except_arg = flag_value(argc,argv,"--exceptions");
+    int runs = runs_arg ? std::max(1, atoi(runs_arg)) : 5;
+    double tolerance = tol_arg ? atof(tol_arg) : 15.0;
+
+    std::vector<std::string> filenames { };
+    for (int i=1; i<argc; i++) {
+        if (argv[i][0] == '-') {
+            i++; // Every flag takes a value.
+        } else {
+            filenames.push_back(argv[i]);
+        }
+    }
+    if (filenames.empty()) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--runs N] [--baseline base.json] [--tolerance PCT]"
+                  << " [--output out.json] [--exceptions exceptions.s]"
+                  << " file ..." << std::endl;
+        return 2;
+    }
+
+    // The generated code for big sources outgrows spim's default
+    // text segment, so give it 4MB.
+    spim_embed_initialize(except_arg ? except_arg : "exceptions.s", 4 << 20);
+
+    std::vector<Timing> results { };
+    int failures = 0;
+    for (std::string filename : filenames) {
+        try {
+            if (!bench_file(filename, runs, results)) failures++;
+        } catch (DwislpyError se) {
+            std::cerr << se.what() << std::endl;
+            failures++;
+        }
+    }
+
+    if (out_arg) {
+        std::ofstream out { out_arg };
+        write_json(out, runs, results);
+    } else {
+        write_json(std::cout, runs, results);
+    }
+
+    int regressions = 0;
+    if (base_arg) {
+        regressions = compare(results, read_baseline(base_arg), tolerance);
+        std::cerr << regressions << " regression(s) against "
+                  << base_arg << "." << std::endl;
+    }
+    return (failures > 0 || regressions > 0) ? 1 : 0;
+}
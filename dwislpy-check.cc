@@ -146,9 +146,82 @@ void Prgm::chck(void) {
     if (!std::holds_alternative<Void>(rtns)) {
         DwislpyError(main->where(), "Main script should not return."); // ???
     }
+    build_call_graph();
+    perfs = main_symt.has_perfs();
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        perfs = perfs || dfpr.second->symt.has_perfs();
+    }
+    find_pure_defns();
+    find_live_defns();
+}
+
+// build_call_graph
+//
+// Collects the calls noted in each definition's symbol table, and in
+// the main script's, into `calls`.
+//
+void Prgm::build_call_graph(void) {
+    calls.clear();
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        calls[dfpr.first] = dfpr.second->symt.get_callees();
+    }
+    calls["main"] = main_symt.get_callees();
+}
+
+// find_pure_defns
+//
+// A definition is pure if it performs no I/O and only calls pure
+// definitions. Since a definition only sees its own parameters and
+// locals, a pure one always returns the same value for the same
+// arguments. Starting with every definition that performs no I/O
+// itself, this repeatedly marks as impure any that calls an impure
+// one, until nothing changes.
+//
+void Prgm::find_pure_defns(void) {
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        dfpr.second->pure = !dfpr.second->symt.has_effects();
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::pair<Name,Defn_ptr> dfpr : defs) {
+            Defn_ptr def = dfpr.second;
+            if (!def->pure) continue;
+            for (Name callee : calls[dfpr.first]) {
+                if (defs.count(callee) == 0 || !defs.at(callee)->pure) {
+                    def->pure = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
 }
 
 
+// find_live_defns
+//
+// A definition is live if the main script calls it, or a live
+// definition calls it. This walks the call graph from "main", marking
+// each definition it reaches.
+//
+void Prgm::find_live_defns(void) {
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        dfpr.second->live = false;
+    }
+    std::vector<Name> work { "main" };
+    while (!work.empty()) {
+        Name caller = work.back();
+        work.pop_back();
+        for (Name callee : calls[caller]) {
+            if (defs.count(callee) > 0 && !defs.at(callee)->live) {
+                defs.at(callee)->live = true;
+                work.push_back(callee);
+            }
+        }
+    }
+}
+
 void Defn::chck(Defs& defs) {
     Rtns rtns = blck->chck(Rtns{Type{rety}}, defs, symt);
     if (std::holds_alternative<Void>(rtns)) {
@@ -289,6 +362,7 @@ Rtns Pass::chck([[maybe_unused]] Rtns expd,
 
 
 Rtns Prnt::chck([[maybe_unused]] Rtns expd, Defs& defs, SymT& symt) {
+    symt.add_effect();
     for (Expn_ptr expn : prms) {
         [[maybe_unused]] Type expn_ty = expn->chck(defs,symt);
     }
@@ -359,6 +433,7 @@ Rtns Proc::chck([[maybe_unused]] Rtns expd, Defs& defs, SymT& symt) {
     }
 
     Defn_ptr def = defs.at(name);
+    symt.add_call(name);
 
     if (def->rety != (NoneTy {})) {
         throw DwislpyError { where(), "Error: Function called as procedure." };
@@ -380,6 +455,7 @@ Rtns Proc::chck([[maybe_unused]] Rtns expd, Defs& defs, SymT& symt) {
             throw DwislpyError { where(), msg };
         }
     }
+    defn = def.get();
     return Rtns{ Void{}};
 }
 
@@ -405,6 +481,18 @@ Rtns Whle::chck(Rtns expd, Defs& defs, SymT& symt) {
 
 Type Func::chck(Defs& defs, SymT& symt) {
 
+    if (name == "perf" && defs.count(name) == 0) {
+        if (args.size() != 1) {
+            std::string msg = "Incorrect number of args found for function "
+                "perf: expected 1, saw " + std::to_string(args.size()) + ".";
+            throw DwislpyError { where(), msg };
+        }
+        builtin = Perf_ptr { new Perf {args[0],where()} };
+        symt.add_perf();
+        type = builtin->chck(defs,symt);
+        return type;
+    }
+
     if (defs.count(name) == 0) {
         std::string msg = "Run-time error: procedure '" + name +"'";
         msg += " is not defined.";
@@ -412,6 +500,7 @@ Type Func::chck(Defs& defs, SymT& symt) {
     }
 
     Defn_ptr def = defs.at(name);
+    symt.add_call(name);
 
     if ((int)def->symt.get_frmls_size() != (int)args.size()) {
         std::string msg = "Incorrect number of args found for function " 
@@ -429,6 +518,7 @@ Type Func::chck(Defs& defs, SymT& symt) {
             throw DwislpyError { where(), msg };
         }
     }
+    defn = def.get();
     type = def->rety;
     return type;
 }
@@ -575,6 +665,7 @@ Type Lkup::chck([[maybe_unused]] Defs& defs, [[maybe_unused]] SymT& symt) {
 }
 
 Type Inpt::chck(Defs& defs, SymT& symt) {
+    symt.add_effect();
     Type expn_ty = expn->chck(defs,symt);
     if (is_str(expn_ty)) {
         // ??? This next line *should* be 
@@ -588,6 +679,18 @@ Type Inpt::chck(Defs& defs, SymT& symt) {
     }
 }
 
+Type Perf::chck(Defs& defs, SymT& symt) {
+    symt.add_effect(); // Its value depends on when it is read.
+    Type expn_ty = expn->chck(defs,symt);
+    if (is_int(expn_ty)) {
+        type = Type {IntTy {}};
+        return type;
+    } else {
+        std::string msg = "Counter number is not an int.";
+        throw DwislpyError { where(), msg };
+    }
+}
+
 Type IntC::chck(Defs& defs, SymT& symt) {
     Type expn_ty = expn->chck(defs,symt);
     if (is_None(expn_ty)) {
@@ -44,6 +44,7 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <set>
 
 // * * * * *
 //
@@ -165,6 +166,12 @@ typedef std::variant<Void,VoidOr,Type> Rtns;
 // 3rd, etc parameter's information. The method `get_frmls_size` tells you
 // how many formal parameters are stored in a symbol table.
 //
+// While checking, a block's symbol table also notes what the block does
+// beyond computing: `add_call` records the name of each definition it
+// calls, `add_effect` that it performs I/O (a `print` or `input`)
+// or reads a performance counter (`perf`), and `add_perf` the latter.
+// From these `Prgm::chck` builds the call graph, `Prgm::calls`.
+//
 
 enum SymKind { FRML, LOCL, TEMP };
 
@@ -261,6 +268,24 @@ public:
     unsigned int get_locls_size(void) const {
         return locals.size();
     }
+    void add_call(std::string nm) {
+        callees.insert(nm);
+    }
+    void add_effect(void) {
+        effects = true;
+    }
+    void add_perf(void) {
+        perfs = true;
+    }
+    const std::set<std::string>& get_callees(void) const {
+        return callees;
+    }
+    bool has_effects(void) const {
+        return effects;
+    }
+    bool has_perfs(void) const {
+        return perfs;
+    }
     void set_frame_offset(std::string nm, int offset) {
         get_info(nm)->frame_offset = offset;
     }
@@ -280,6 +305,9 @@ private:
     SymT_ptr globals;
     int sym_id = 0;
     int frame_size;
+    std::set<std::string> callees;
+    bool effects = false;
+    bool perfs = false;
 };
 
 #endif
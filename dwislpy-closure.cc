@@ -0,0 +1,797 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <iostream>
+
+#include "dwislpy-ast.hh"
+#include "dwislpy-util.hh"
+#include "dwislpy-check.hh"
+#include "dwislpy-closure.hh"
+
+//
+// dwislpy-closure.cc
+//
+// This gives the `clos`, `clos_int`, and `clos_cndn` methods for all
+// the AST nodes, and `Prgm::run_compiled`, which runs a checked program
+// with the closures they build. See dwislpy-closure.hh.
+//
+// Each closure does what the `exec` or `eval` method of its node does,
+// in the same order, and reports the same run-time errors. Where the
+// two differ is in what each closure already knows: where variables
+// live, which definition a call invokes, and, in a `typed` scope,
+// that an int expression's value is an int.
+//
+
+//
+// Scope
+//
+
+Scope::Scope(const SymT& symt, bool ty) : typed {ty}, slots {} {
+    for (unsigned int i = 0; i < symt.get_frmls_size(); i++) {
+        add(symt.get_frml(i)->name);
+    }
+    for (unsigned int i = 0; i < symt.get_locls_size(); i++) {
+        add(symt.get_locl(i)->name);
+    }
+}
+
+void Scope::add(const Name& name) {
+    if (slots.count(name) == 0) {
+        int i = slots.size();
+        slots[name] = i;
+    }
+}
+
+int Scope::slot(const Name& name) const {
+    if (slots.count(name) > 0) {
+        return slots.at(name);
+    } else {
+        return -1;
+    }
+}
+
+// monomorphic
+//
+// Checks whether each variable introduced in a block of code, or one
+// nested within it, is always introduced with the same type, adding
+// each to `types`. When that holds for a definition, the value of each
+// of its expressions has the type `chck` found for it, and so its
+// closures can be specialized. A variable can be introduced again with
+// another type, though, and then its uses hold values of either type.
+//
+static bool monomorphic(const Blck& blck, std::unordered_map<Name,Type>& types) {
+    for (const Stmt_ptr& stmt : blck.stmts) {
+        if (Ntro* ntro = dynamic_cast<Ntro*>(stmt.get())) {
+            if (types.count(ntro->name) > 0 && types.at(ntro->name) != ntro->type) {
+                return false;
+            }
+            types.insert({ntro->name,ntro->type});
+        } else if (Whle* whle = dynamic_cast<Whle*>(stmt.get())) {
+            if (!monomorphic(*whle->blck,types)) {
+                return false;
+            }
+        } else if (Tern* tern = dynamic_cast<Tern*>(stmt.get())) {
+            if (!monomorphic(*tern->if_blck,types)
+                || !monomorphic(*tern->else_blck,types)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// bound
+//
+// Gives the definition a call was bound to by `chck`. Closures can
+// only be built for a checked program.
+//
+static Defn* bound(Defn* defn, const Name& name, Locn locn) {
+    if (defn == nullptr) {
+        std::string msg = "Call to '" + name + "' was not checked.";
+        throw DwislpyError { locn, msg };
+    }
+    return defn;
+}
+
+static std::vector<Valu_fn> clos_args(const Expn_vec& args, Scope& scope) {
+    std::vector<Valu_fn> arg_fns {};
+    for (const Expn_ptr& expn : args) {
+        arg_fns.push_back(expn->clos(scope));
+    }
+    return arg_fns;
+}
+
+static DwislpyError not_defined(const Name& name, Locn locn) {
+    std::string msg = "Run-time error: variable '" + name +"'";
+    msg += "not defined.";
+    return DwislpyError { locn, msg };
+}
+
+static int slot_of(const Name& name, Scope& scope, Locn locn) {
+    int i = scope.slot(name);
+    if (i < 0) {
+        throw DwislpyError(locn, "Variable '" + name + "' never introduced.");
+    }
+    return i;
+}
+
+//
+// Prgm::run_compiled, Defn::clos, Defn::call_compiled
+//
+
+void Prgm::run_compiled(void) {
+    Perf::counting = perfs;
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        dfpr.second->clos();
+    }
+    std::unordered_map<Name,Type> types {};
+    Scope scope { main_symt, monomorphic(*main,types) };
+    Stmt_fn main_fn = main->clos(scope);
+    //
+    Perf::reset();
+    Frame frame(scope.size());
+    Valu rslt { None };
+    main_fn(frame,rslt);
+}
+
+void Defn::clos(void) {
+    std::unordered_map<Name,Type> types {};
+    for (unsigned int i = 0; i < symt.get_frmls_size(); i++) {
+        types.insert({formal(i)->name,formal(i)->type});
+    }
+    Scope scope { symt, monomorphic(*blck,types) };
+    frame_size = scope.size();
+    body_fn = blck->clos(scope);
+}
+
+Flow Defn::call_compiled(const std::vector<Valu_fn>& args,
+                         Frame& frame,
+                         Valu& rslt) {
+    Frame locals(frame_size);
+    for (size_t i = 0; i < args.size(); i++) {
+        locals[i].valu = args[i](frame);
+        locals[i].set = true;
+    }
+    return body_fn(locals,rslt);
+}
+
+// call_memo_compiled
+//
+// As `call_memo`, sharing its table.
+//
+Flow Defn::call_memo_compiled(const std::vector<Valu_fn>& args,
+                              Frame& frame,
+                              Valu& rslt) {
+    std::vector<Valu> values {};
+    for (const Valu_fn& arg : args) {
+        values.push_back(arg(frame));
+    }
+    Memo::const_iterator found = memo.find(values);
+    if (found != memo.end()) {
+        rslt = found->second;
+        return RETN;
+    }
+    Frame locals(frame_size);
+    for (size_t i = 0; i < values.size(); i++) {
+        locals[i].valu = values[i];
+        locals[i].set = true;
+    }
+    Flow flow = body_fn(locals,rslt);
+    if (flow == RETN) {
+        if (memo.size() >= memo_size) {
+            memo.clear();
+        }
+        memo.emplace(std::move(values), rslt);
+    }
+    return flow;
+}
+
+//
+// Blck::clos, Stmt::clos
+//
+// A block counts the statements it runs, for `perf`, only if the
+// program calls it, as `Blck::exec` does.
+//
+
+Stmt_fn Blck::clos(Scope& scope) const {
+    std::vector<Stmt_fn> stmt_fns {};
+    for (const Stmt_ptr& s : stmts) {
+        stmt_fns.push_back(s->clos(scope));
+    }
+    if (Perf::counting) {
+        return [stmt_fns](Frame& frame, Valu& rslt) {
+            for (const Stmt_fn& stmt_fn : stmt_fns) {
+                Perf::statements++;
+                if (stmt_fn(frame,rslt) == RETN) {
+                    return RETN;
+                }
+            }
+            return FALL;
+        };
+    }
+    return [stmt_fns](Frame& frame, Valu& rslt) {
+        for (const Stmt_fn& stmt_fn : stmt_fns) {
+            if (stmt_fn(frame,rslt) == RETN) {
+                return RETN;
+            }
+        }
+        return FALL;
+    };
+}
+
+// clos_store
+//
+// Builds the closure for an introduction or an assignment.
+//
+static Stmt_fn clos_store(const Name& name, const Expn& expn, Scope& scope, Locn locn) {
+    int i = slot_of(name,scope,locn);
+    if (scope.typed && is_int(expn.type)) {
+        Int_fn expn_fn = expn.clos_int(scope);
+        return [i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+            int n = expn_fn(frame);
+            frame[i].valu = n;
+            frame[i].set = true;
+            return FALL;
+        };
+    }
+    Valu_fn expn_fn = expn.clos(scope);
+    return [i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+        Valu v = expn_fn(frame);
+        frame[i].valu = std::move(v);
+        frame[i].set = true;
+        return FALL;
+    };
+}
+
+Stmt_fn Ntro::clos(Scope& scope) const {
+    return clos_store(name,*expn,scope,where());
+}
+
+Stmt_fn Asgn::clos(Scope& scope) const {
+    return clos_store(name,*expn,scope,where());
+}
+
+Stmt_fn PlEq::clos(Scope& scope) const {
+    int i = slot_of(name,scope,where());
+    if (scope.typed && is_int(expn->type)) {
+        Int_fn expn_fn = expn->clos_int(scope);
+        return [this,i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+            if (!frame[i].set) {
+                throw not_defined(name,where());
+            }
+            int e = expn_fn(frame);
+            std::get<int>(frame[i].valu) += e;
+            return FALL;
+        };
+    }
+    Valu_fn expn_fn = expn->clos(scope);
+    return [this,i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+        if (!frame[i].set) {
+            throw not_defined(name,where());
+        }
+        Valu e = expn_fn(frame);
+        apply(frame[i].valu,e);
+        return FALL;
+    };
+}
+
+Stmt_fn MiEq::clos(Scope& scope) const {
+    int i = slot_of(name,scope,where());
+    if (scope.typed && is_int(expn->type)) {
+        Int_fn expn_fn = expn->clos_int(scope);
+        return [this,i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+            if (!frame[i].set) {
+                throw not_defined(name,where());
+            }
+            int e = expn_fn(frame);
+            std::get<int>(frame[i].valu) -= e;
+            return FALL;
+        };
+    }
+    Valu_fn expn_fn = expn->clos(scope);
+    return [this,i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+        if (!frame[i].set) {
+            throw not_defined(name,where());
+        }
+        Valu e = expn_fn(frame);
+        apply(frame[i].valu,e);
+        return FALL;
+    };
+}
+
+Stmt_fn TiEq::clos(Scope& scope) const {
+    int i = slot_of(name,scope,where());
+    if (scope.typed && is_int(expn->type)) {
+        Int_fn expn_fn = expn->clos_int(scope);
+        return [this,i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+            if (!frame[i].set) {
+                throw not_defined(name,where());
+            }
+            int e = expn_fn(frame);
+            std::get<int>(frame[i].valu) *= e;
+            return FALL;
+        };
+    }
+    Valu_fn expn_fn = expn->clos(scope);
+    return [this,i,expn_fn](Frame& frame, [[maybe_unused]] Valu& rslt) {
+        if (!frame[i].set) {
+            throw not_defined(name,where());
+        }
+        Valu e = expn_fn(frame);
+        apply(frame[i].valu,e);
+        return FALL;
+    };
+}
+
+Stmt_fn Pass::clos([[maybe_unused]] Scope& scope) const {
+    return []([[maybe_unused]] Frame& frame, [[maybe_unused]] Valu& rslt) {
+        return FALL;
+    };
+}
+
+Stmt_fn Prnt::clos(Scope& scope) const {
+    std::vector<Valu_fn> prm_fns = clos_args(prms,scope);
+    return [prm_fns](Frame& frame, [[maybe_unused]] Valu& rslt) {
+        Perf::io_calls++;
+        if (prm_fns.empty()) {
+            std::cout << '\n';
+            return FALL;
+        }
+        for (const Valu_fn& prm_fn : prm_fns) {
+            write_valu(std::cout, prm_fn(frame));
+            std::cout << '\n';
+        }
+        return FALL;
+    };
+}
+
+Stmt_fn Proc::clos(Scope& scope) const {
+    Defn* def = bound(defn,name,where());
+    std::vector<Valu_fn> arg_fns = clos_args(args,scope);
+    return [def,arg_fns](Frame& frame, [[maybe_unused]] Valu& rslt) {
+        Valu proc_rslt { None };
+        def->call_compiled(arg_fns,frame,proc_rslt);
+        return FALL;
+    };
+}
+
+Stmt_fn Whle::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = expn->clos_cndn(scope);
+    Stmt_fn blck_fn = blck->clos(scope);
+    return [cndn_fn,blck_fn](Frame& frame, Valu& rslt) {
+        while (cndn_fn(frame)) {
+            if (blck_fn(frame,rslt) == RETN) {
+                return RETN;
+            }
+        }
+        return FALL;
+    };
+}
+
+Stmt_fn Tern::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = expn->clos_cndn(scope);
+    Stmt_fn if_fn = if_blck->clos(scope);
+    Stmt_fn else_fn = else_blck->clos(scope);
+    return [cndn_fn,if_fn,else_fn](Frame& frame, Valu& rslt) {
+        if (cndn_fn(frame)) {
+            return if_fn(frame,rslt);
+        } else {
+            return else_fn(frame,rslt);
+        }
+    };
+}
+
+Stmt_fn Retn::clos([[maybe_unused]] Scope& scope) const {
+    return []([[maybe_unused]] Frame& frame, Valu& rslt) {
+        rslt = Valu { None };
+        return RETN;
+    };
+}
+
+Stmt_fn RetE::clos(Scope& scope) const {
+    Valu_fn expn_fn = expn->clos(scope);
+    return [expn_fn](Frame& frame, Valu& rslt) {
+        rslt = expn_fn(frame);
+        return RETN;
+    };
+}
+
+//
+// Expn::clos, Expn::clos_int, Expn::clos_cndn
+//
+// By default, `clos_int` and `clos_cndn` convert the value computed by
+// the closure from `clos`. Nodes that can compute an int or a condition
+// more directly override them. `clos_int` is only used for expressions
+// of type int in a typed scope.
+//
+
+Int_fn Expn::clos_int(Scope& scope) const {
+    Valu_fn expn_fn = clos(scope);
+    return [expn_fn](Frame& frame) {
+        return std::get<int>(expn_fn(frame));
+    };
+}
+
+Cndn_fn Expn::clos_cndn(Scope& scope) const {
+    Valu_fn expn_fn = clos(scope);
+    return [expn_fn](Frame& frame) {
+        return predicate(expn_fn(frame));
+    };
+}
+
+Valu_fn Func::clos(Scope& scope) const {
+    if (builtin) {
+        return builtin->clos(scope);
+    }
+    Defn* def = bound(defn,name,where());
+    std::vector<Valu_fn> arg_fns = clos_args(args,scope);
+    return [this,def,arg_fns](Frame& frame) {
+        Valu rslt { None };
+        Flow flow = (Defn::memoizing && def->pure)
+            ? def->call_memo_compiled(arg_fns,frame,rslt)
+            : def->call_compiled(arg_fns,frame,rslt);
+        if (flow != RETN) {
+            std::string msg = "Run-time error: no value returned from ";
+            msg += "function '" + name +"'.";
+            throw DwislpyError { where(), msg };
+        }
+        return rslt;
+    };
+}
+
+Int_fn Func::clos_int(Scope& scope) const {
+    if (builtin) {
+        return builtin->clos_int(scope);
+    }
+    Valu_fn func_fn = clos(scope);
+    return [func_fn](Frame& frame) {
+        return std::get<int>(func_fn(frame));
+    };
+}
+
+// Plus::clos, Mnus::clos, Tmes::clos, IDiv::clos, IMod::clos
+//
+// In a typed scope, an int operation is built by `clos_int` and only
+// its result is made into a `Valu`. Otherwise each operand's value is
+// computed, in order, and handed to `apply`, as `eval` does.
+//
+
+Valu_fn Plus::clos(Scope& scope) const {
+    if (scope.typed && is_int(type)) {
+        Int_fn int_fn = clos_int(scope);
+        return [int_fn](Frame& frame) { return Valu {int_fn(frame)}; };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return apply(lv,rv);
+    };
+}
+
+Int_fn Plus::clos_int(Scope& scope) const {
+    Int_fn left_fn = left->clos_int(scope);
+    Int_fn rght_fn = rght->clos_int(scope);
+    return [left_fn,rght_fn](Frame& frame) {
+        int ln = left_fn(frame);
+        int rn = rght_fn(frame);
+        return ln + rn;
+    };
+}
+
+Valu_fn Mnus::clos(Scope& scope) const {
+    if (scope.typed && is_int(type)) {
+        Int_fn int_fn = clos_int(scope);
+        return [int_fn](Frame& frame) { return Valu {int_fn(frame)}; };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return apply(lv,rv);
+    };
+}
+
+Int_fn Mnus::clos_int(Scope& scope) const {
+    Int_fn left_fn = left->clos_int(scope);
+    Int_fn rght_fn = rght->clos_int(scope);
+    return [left_fn,rght_fn](Frame& frame) {
+        int ln = left_fn(frame);
+        int rn = rght_fn(frame);
+        return ln - rn;
+    };
+}
+
+Valu_fn Tmes::clos(Scope& scope) const {
+    if (scope.typed && is_int(type)) {
+        Int_fn int_fn = clos_int(scope);
+        return [int_fn](Frame& frame) { return Valu {int_fn(frame)}; };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return apply(lv,rv);
+    };
+}
+
+Int_fn Tmes::clos_int(Scope& scope) const {
+    Int_fn left_fn = left->clos_int(scope);
+    Int_fn rght_fn = rght->clos_int(scope);
+    return [left_fn,rght_fn](Frame& frame) {
+        int ln = left_fn(frame);
+        int rn = rght_fn(frame);
+        return ln * rn;
+    };
+}
+
+Valu_fn IDiv::clos(Scope& scope) const {
+    if (scope.typed && is_int(type)) {
+        Int_fn int_fn = clos_int(scope);
+        return [int_fn](Frame& frame) { return Valu {int_fn(frame)}; };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return apply(lv,rv);
+    };
+}
+
+Int_fn IDiv::clos_int(Scope& scope) const {
+    Int_fn left_fn = left->clos_int(scope);
+    Int_fn rght_fn = rght->clos_int(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        int ln = left_fn(frame);
+        int rn = rght_fn(frame);
+        if (rn == 0) {
+            throw DwislpyError { where(), "Run-time error: division by 0."};
+        }
+        return ln / rn;
+    };
+}
+
+Valu_fn IMod::clos(Scope& scope) const {
+    if (scope.typed && is_int(type)) {
+        Int_fn int_fn = clos_int(scope);
+        return [int_fn](Frame& frame) { return Valu {int_fn(frame)}; };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return apply(lv,rv);
+    };
+}
+
+Int_fn IMod::clos_int(Scope& scope) const {
+    Int_fn left_fn = left->clos_int(scope);
+    Int_fn rght_fn = rght->clos_int(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        int ln = left_fn(frame);
+        int rn = rght_fn(frame);
+        if (rn == 0) {
+            throw DwislpyError { where(), "Run-time error: division by 0."};
+        }
+        return ln % rn;
+    };
+}
+
+// Conj::clos, Disj::clos, Negt::clos
+//
+// These short-circuit as `eval` does, since C++'s && and || do.
+//
+
+Valu_fn Conj::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = clos_cndn(scope);
+    return [cndn_fn](Frame& frame) { return Valu {cndn_fn(frame)}; };
+}
+
+Cndn_fn Conj::clos_cndn(Scope& scope) const {
+    Cndn_fn left_fn = left->clos_cndn(scope);
+    Cndn_fn rght_fn = rght->clos_cndn(scope);
+    return [left_fn,rght_fn](Frame& frame) {
+        return left_fn(frame) && rght_fn(frame);
+    };
+}
+
+Valu_fn Disj::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = clos_cndn(scope);
+    return [cndn_fn](Frame& frame) { return Valu {cndn_fn(frame)}; };
+}
+
+Cndn_fn Disj::clos_cndn(Scope& scope) const {
+    Cndn_fn left_fn = left->clos_cndn(scope);
+    Cndn_fn rght_fn = rght->clos_cndn(scope);
+    return [left_fn,rght_fn](Frame& frame) {
+        return left_fn(frame) || rght_fn(frame);
+    };
+}
+
+Valu_fn Negt::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = clos_cndn(scope);
+    return [cndn_fn](Frame& frame) { return Valu {cndn_fn(frame)}; };
+}
+
+Cndn_fn Negt::clos_cndn(Scope& scope) const {
+    Cndn_fn expn_fn = expn->clos_cndn(scope);
+    return [expn_fn](Frame& frame) {
+        return !expn_fn(frame);
+    };
+}
+
+// Less::clos, LtEq::clos, Eqal::clos
+//
+// A comparison yields a bool, so `clos` wraps `clos_cndn`. In a typed
+// scope, ints are compared without making a `Valu` of either operand.
+//
+
+Valu_fn Less::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = clos_cndn(scope);
+    return [cndn_fn](Frame& frame) { return Valu {cndn_fn(frame)}; };
+}
+
+Cndn_fn Less::clos_cndn(Scope& scope) const {
+    if (scope.typed && is_int(left->type) && is_int(rght->type)) {
+        Int_fn left_fn = left->clos_int(scope);
+        Int_fn rght_fn = rght->clos_int(scope);
+        return [left_fn,rght_fn](Frame& frame) {
+            int ln = left_fn(frame);
+            int rn = rght_fn(frame);
+            return ln < rn;
+        };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return std::get<bool>(apply(lv,rv));
+    };
+}
+
+Valu_fn LtEq::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = clos_cndn(scope);
+    return [cndn_fn](Frame& frame) { return Valu {cndn_fn(frame)}; };
+}
+
+Cndn_fn LtEq::clos_cndn(Scope& scope) const {
+    if (scope.typed && is_int(left->type) && is_int(rght->type)) {
+        Int_fn left_fn = left->clos_int(scope);
+        Int_fn rght_fn = rght->clos_int(scope);
+        return [left_fn,rght_fn](Frame& frame) {
+            int ln = left_fn(frame);
+            int rn = rght_fn(frame);
+            return ln <= rn;
+        };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return std::get<bool>(apply(lv,rv));
+    };
+}
+
+Valu_fn Eqal::clos(Scope& scope) const {
+    Cndn_fn cndn_fn = clos_cndn(scope);
+    return [cndn_fn](Frame& frame) { return Valu {cndn_fn(frame)}; };
+}
+
+Cndn_fn Eqal::clos_cndn(Scope& scope) const {
+    if (scope.typed && is_int(left->type) && is_int(rght->type)) {
+        Int_fn left_fn = left->clos_int(scope);
+        Int_fn rght_fn = rght->clos_int(scope);
+        return [left_fn,rght_fn](Frame& frame) {
+            int ln = left_fn(frame);
+            int rn = rght_fn(frame);
+            return ln == rn;
+        };
+    }
+    Valu_fn left_fn = left->clos(scope);
+    Valu_fn rght_fn = rght->clos(scope);
+    return [this,left_fn,rght_fn](Frame& frame) {
+        Valu lv = left_fn(frame);
+        Valu rv = rght_fn(frame);
+        return std::get<bool>(apply(lv,rv));
+    };
+}
+
+// Ltrl::clos, Lkup::clos
+//
+
+Valu_fn Ltrl::clos([[maybe_unused]] Scope& scope) const {
+    Valu v = valu;
+    return [v]([[maybe_unused]] Frame& frame) { return v; };
+}
+
+Int_fn Ltrl::clos_int([[maybe_unused]] Scope& scope) const {
+    int n = std::get<int>(valu);
+    return [n]([[maybe_unused]] Frame& frame) { return n; };
+}
+
+Cndn_fn Ltrl::clos_cndn([[maybe_unused]] Scope& scope) const {
+    bool b = predicate(valu);
+    return [b]([[maybe_unused]] Frame& frame) { return b; };
+}
+
+Valu_fn Lkup::clos(Scope& scope) const {
+    int i = slot_of(name,scope,where());
+    return [this,i](Frame& frame) {
+        if (!frame[i].set) {
+            throw not_defined(name,where());
+        }
+        return frame[i].valu;
+    };
+}
+
+Int_fn Lkup::clos_int(Scope& scope) const {
+    int i = slot_of(name,scope,where());
+    return [this,i](Frame& frame) {
+        if (!frame[i].set) {
+            throw not_defined(name,where());
+        }
+        return std::get<int>(frame[i].valu);
+    };
+}
+
+Cndn_fn Lkup::clos_cndn(Scope& scope) const {
+    if (!scope.typed || !(is_int(type) || is_bool(type))) {
+        return Expn::clos_cndn(scope);
+    }
+    int i = slot_of(name,scope,where());
+    if (is_int(type)) {
+        return [this,i](Frame& frame) {
+            if (!frame[i].set) {
+                throw not_defined(name,where());
+            }
+            return std::get<int>(frame[i].valu) != 0;
+        };
+    }
+    return [this,i](Frame& frame) {
+        if (!frame[i].set) {
+            throw not_defined(name,where());
+        }
+        return std::get<bool>(frame[i].valu);
+    };
+}
+
+// Inpt::clos, Perf::clos, IntC::clos, StrC::clos
+//
+
+Valu_fn Inpt::clos(Scope& scope) const {
+    Valu_fn expn_fn = expn->clos(scope);
+    return [this,expn_fn](Frame& frame) {
+        return apply(expn_fn(frame));
+    };
+}
+
+Valu_fn Perf::clos(Scope& scope) const {
+    Valu_fn expn_fn = expn->clos(scope);
+    return [this,expn_fn](Frame& frame) {
+        return apply(expn_fn(frame));
+    };
+}
+
+Valu_fn IntC::clos(Scope& scope) const {
+    Valu_fn expn_fn = expn->clos(scope);
+    return [this,expn_fn](Frame& frame) {
+        return apply(expn_fn(frame));
+    };
+}
+
+Valu_fn StrC::clos(Scope& scope) const {
+    Valu_fn expn_fn = expn->clos(scope);
+    return [expn_fn](Frame& frame) {
+        return Valu { to_string(expn_fn(frame)) };
+    };
+}
@@ -0,0 +1,55 @@
+#ifndef _DWISLPY_CLOSURE_HH
+#define _DWISLPY_CLOSURE_HH
+
+//
+// dwislpy-closure.hh
+//
+// The closure-compiled engine, a faster way to run a checked DwiSlpy
+// program than walking its AST with `exec` and `eval`.
+//
+// `Prgm::run_compiled` first has each definition, and then the main
+// script, build a tree of C++ closures from its code with the `clos`
+// methods (see dwislpy-closure.cc). Each closure captures what can be
+// worked out once rather than on every run of the code:
+//
+//  * the slot of the frame that holds each variable it uses, rather
+//    than looking up its name in a `Ctxt`,
+//  * the `Defn` that each call invokes (bound by `chck`), and
+//  * when the program's values are sure to have their checked types,
+//    operations specialized to them. An int expression is built with
+//    `clos_int`, which yields a C++ `int` without making a `Valu`,
+//    and a condition with `clos_cndn`, which yields its `predicate`.
+//
+// The closures then run the program, with the same results, output,
+// and run-time errors as `Prgm::run`. They share the operations on
+// values (the `apply` methods) with `eval` and `exec`.
+//
+// Profiling and tracing are only done by `Prgm::run`.
+//
+
+#include <string>
+#include <unordered_map>
+#include "dwislpy-ast.hh"
+
+//
+// class Scope
+//
+// The layout of the frame of a definition, or of the main script,
+// while its code is turned into closures: the slot of each of its
+// variables. The formal parameters take the first slots, in order, so
+// that a call can fill them in. Rather than tracking which variables
+// are introduced where, every local named in its symbol table gets a
+// slot for the whole of its body, as with a `Ctxt`.
+//
+class Scope {
+public:
+    bool typed; // => each expression's value has the type `chck` found.
+    Scope(const SymT& symt, bool typed);
+    int slot(const Name& name) const; // Its slot, or -1 if it has none.
+    size_t size(void) const { return slots.size(); }
+private:
+    std::unordered_map<Name,int> slots;
+    void add(const Name& name);
+};
+
+#endif
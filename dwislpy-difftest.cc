@@ -0,0 +1,761 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+
+#include "dwislpy-ast.hh"
+#include "dwislpy-flex.hh"
+#include "dwislpy-bison.tab.hh"
+#include "dwislpy-util.hh"
+#include "dwislpy-main.hh"
+#include "spim-cmd/spim-embed.h"
+
+//
+// dwislpy-difftest - differential testing of the interpreter against
+// the compiler
+//
+// Usage: ./dwislpy-difftest [--count N] [--seed S] [--jobs J]
+//                           [--dir DIR] [--exceptions exceptions.s]
+//                           [--engine ast|closures|jit|ir|x86]
+//                           [file.slpy ...]
+//
+// Generates N (default 200) random DWISLPY programs from seeds S,
+// S+1, ..., and runs each one two ways: with the interpreter
+// (`Prgm::run`), and by compiling it (`Prgm::compile`) and running
+// the MIPS code in SPIM, linked in-process. The two outputs must
+// match. Given source files instead, it tests those. With `--engine
+// closures` the interpreter runs the program as compiled closures
+// (`Prgm::run_compiled`) instead of walking its AST. With `--engine
+// jit` it compiles each definition it can with the JIT on its first
+// call, so that as much of the program as possible runs natively. With
+// `--engine ir` it runs the program's IR on the VM (`Prgm::run_ir`),
+// checking the IR apart from the MIPS code made from it. With `--engine
+// x86` it checks the x86-64 backend instead of the MIPS one: the AST
+// walker's output is compared with that of the program compiled by
+// `Prgm::compile_x86`, assembled and linked with `cc`, and run natively
+// (so this needs an x86-64 host).
+//
+// Each program is run in its own forked process, J (default: one per
+// core) at a time. This keeps the interpreter's use of `std::cout`
+// and SPIM's global machine state separate, and it lets a program
+// that crashes or hangs (past a time limit) be reported rather than
+// take the harness down.
+//
+// For each mismatch, the program is shrunk by repeatedly deleting or
+// flattening statements while the mismatch persists. The original
+// program, the smallest one found, and the two outputs of the latter
+// are left in DIR (default `difftest-out`), the compiled one in
+// `.spim`, or in `.x86.out` for `--engine x86`.
+//
+// The generator sticks to what the compiler is meant to support:
+// `int`, `bool`, and `str` literals and variables, arithmetic, the
+// comparisons and logical connectives, `while` and `if`, `print`, and
+// calls among `def`s. Every program terminates: loops count up to a
+// small bound and a `def` only calls the `def`s before it. Integer
+// values are kept well inside 32 bits, since MIPS `add` traps on
+// overflow where C++ does not, and divisors are non-zero literals.
+//
+
+//
+// Outcomes of running one program.
+//
+enum Outcome {
+    SAME,     // Interpreter and SPIM agree.
+    DIFFER,   // Their outputs differ.
+    REJECTED, // The program does not parse or check.
+    FAILED,   // A run-time error, or SPIM did not run to completion.
+    CRASHED,  // The test process died or timed out.
+};
+
+static const char* outcome_names[] = {
+    "same", "differ", "rejected", "failed", "crashed"
+};
+
+static const int time_limit = 10; // seconds per program
+static bool use_closures = false;  // Set by `--engine closures`.
+static bool use_jit = false;       // Set by `--engine jit`.
+static bool use_ir = false;        // Set by `--engine ir`.
+static bool use_x86 = false;       // Set by `--engine x86`.
+
+// * * * * *
+//
+// class Generator
+//
+// Produces a random, well-typed, terminating DWISLPY program as a
+// sequence of indented source lines.
+//
+// Integer expressions are generated along with a bound on their
+// magnitude. Variables, parameters, and return values always hold
+// values of magnitude below `wrap`, and any expression that might
+// exceed that is reduced `% wrap` before being stored.
+//
+
+enum GenTy { GEN_INT, GEN_BOOL, GEN_STR, GEN_NONE };
+
+struct GenVar {
+    std::string name;
+    GenTy type;
+    bool counter; // Loop counters are never assigned by the body.
+};
+
+struct GenDef {
+    std::string name;
+    std::vector<GenTy> params;
+    GenTy rety;
+};
+
+struct GenExp {
+    std::string text;
+    long bound;
+};
+
+class Generator {
+public:
+    Generator(unsigned int seed) : rng {seed} { }
+    std::vector<std::string> program(void);
+private:
+    std::mt19937 rng;
+    std::vector<std::string> lines;
+    std::vector<std::vector<GenVar>> scopes;
+    std::vector<GenDef> defs;
+    size_t callable = 0;  // Number of `defs` visible to calls.
+    int fresh = 0;
+    int loop_depth = 0;
+    bool in_def = false;
+    static const long wrap = 1009;
+    static const long limit = 1L << 28;
+
+    int pick(int n) { return std::uniform_int_distribution<int>(0,n-1)(rng); }
+    bool chance(int pct) { return pick(100) < pct; }
+    std::string name(std::string prefix) { return prefix + std::to_string(fresh++); }
+    std::string type_text(GenTy ty);
+    void emit(int indent, std::string text);
+    std::vector<GenVar> visible(GenTy ty, bool assignable);
+    void declare(std::string nm, GenTy ty, bool counter);
+
+    GenExp int_expn(int depth);
+    std::string bool_expn(int depth);
+    std::string str_expn(void);
+    std::string any_expn(GenTy ty, int depth);
+    std::string stored(GenExp e);
+    std::string call(GenTy ty, int depth);
+
+    void block(int indent, int depth, GenTy rety);
+    void stmt(int indent, int depth, GenTy rety);
+    void defn(void);
+};
+
+std::string Generator::type_text(GenTy ty) {
+    switch (ty) {
+    case GEN_INT:  return "int";
+    case GEN_BOOL: return "bool";
+    case GEN_STR:  return "str";
+    default:       return "None";
+    }
+}
+
+void Generator::emit(int indent, std::string text) {
+    lines.push_back(std::string(4*indent,' ') + text);
+}
+
+std::vector<GenVar> Generator::visible(GenTy ty, bool assignable) {
+    std::vector<GenVar> vs { };
+    for (std::vector<GenVar>& scope : scopes) {
+        for (GenVar& v : scope) {
+            if (v.type == ty && !(assignable && v.counter)) vs.push_back(v);
+        }
+    }
+    return vs;
+}
+
+void Generator::declare(std::string nm, GenTy ty, bool counter) {
+    scopes.back().push_back(GenVar {nm, ty, counter});
+}
+
+// Wraps an integer expression so that it is safe to store.
+std::string Generator::stored(GenExp e) {
+    if (e.bound < wrap) return e.text;
+    return "((" + e.text + ") % " + std::to_string(wrap) + ")";
+}
+
+std::string Generator::call(GenTy ty, int depth) {
+    std::vector<GenDef> fs { };
+    for (size_t i = 0; i < callable; i++) {
+        if (defs[i].rety == ty) fs.push_back(defs[i]);
+    }
+    if (fs.empty()) return "";
+    GenDef f = fs[pick(fs.size())];
+    std::string text = f.name + "(";
+    for (size_t i = 0; i < f.params.size(); i++) {
+        if (i > 0) text += ", ";
+        text += any_expn(f.params[i], depth+1);
+    }
+    return text + ")";
+}
+
+GenExp Generator::int_expn(int depth) {
+    int choice = depth >= 3 ? pick(2) : pick(9);
+    std::vector<GenVar> vs = visible(GEN_INT,false);
+    if (choice == 1 && !vs.empty()) {
+        return GenExp {vs[pick(vs.size())].name, wrap - 1};
+    }
+    if (choice <= 1) {
+        return GenExp {std::to_string(pick(21)), 20};
+    }
+    if (choice == 2) {
+        std::string c = call(GEN_INT,depth);
+        if (c != "") return GenExp {c, wrap - 1};
+    }
+    GenExp l = int_expn(depth+1);
+    GenExp r = int_expn(depth+1);
+    int d = 1 + pick(9);
+    switch (pick(6)) {
+    case 0:
+        if (l.bound + r.bound < limit) {
+            return GenExp {"(" + l.text + " + " + r.text + ")", l.bound + r.bound};
+        }
+        break;
+    case 1:
+        if (l.bound + r.bound < limit) {
+            return GenExp {"(" + l.text + " - " + r.text + ")", l.bound + r.bound};
+        }
+        break;
+    case 2:
+        if (l.bound * r.bound < limit) {
+            return GenExp {"(" + l.text + " * " + r.text + ")", l.bound * r.bound};
+        }
+        break;
+    case 3:
+        return GenExp {"(" + l.text + " // " + std::to_string(d) + ")", l.bound};
+    case 4:
+        return GenExp {"(" + l.text + " % " + std::to_string(d) + ")", d};
+    default:
+        break;
+    }
+    return GenExp {"(" + l.text + " % " + std::to_string(wrap) + ")", wrap - 1};
+}
+
+std::string Generator::bool_expn(int depth) {
+    int choice = depth >= 3 ? pick(2) : pick(10);
+    std::vector<GenVar> vs = visible(GEN_BOOL,false);
+    if (choice == 1 && !vs.empty()) {
+        return vs[pick(vs.size())].name;
+    }
+    if (choice <= 1) {
+        return chance(50) ? "True" : "False";
+    }
+    if (choice == 2) {
+        std::string c = call(GEN_BOOL,depth);
+        if (c != "") return c;
+    }
+    switch (pick(6)) {
+    case 0:
+        return "(" + int_expn(depth+1).text + " < " + int_expn(depth+1).text + ")";
+    case 1:
+        return "(" + int_expn(depth+1).text + " <= " + int_expn(depth+1).text + ")";
+    case 2:
+        return "(" + int_expn(depth+1).text + " == " + int_expn(depth+1).text + ")";
+    case 3:
+        return "(" + bool_expn(depth+1) + " and " + bool_expn(depth+1) + ")";
+    case 4:
+        return "(" + bool_expn(depth+1) + " or " + bool_expn(depth+1) + ")";
+    default:
+        return "(not " + bool_expn(depth+1) + ")";
+    }
+}
+
+std::string Generator::str_expn(void) {
+    static const char* words[] = {
+        "", "a", "hello", "x y z", "DwiSlpy", "tab\\there", "0123"
+    };
+    std::vector<GenVar> vs = visible(GEN_STR,false);
+    if (!vs.empty() && chance(40)) {
+        return vs[pick(vs.size())].name;
+    }
+    return "\"" + std::string(words[pick(7)]) + "\"";
+}
+
+std::string Generator::any_expn(GenTy ty, int depth) {
+    switch (ty) {
+    case GEN_INT:  return stored(int_expn(depth));
+    case GEN_BOOL: return bool_expn(depth);
+    default:       return str_expn();
+    }
+}
+
+void Generator::stmt(int indent, int depth, GenTy rety) {
+    int choice = pick(depth >= 2 ? 7 : 10);
+    std::vector<GenVar> ints = visible(GEN_INT,true);
+    if (choice == 0 || choice == 1) {
+        // Introduce a variable.
+        GenTy ty = (GenTy)(chance(60) ? GEN_INT : pick(3));
+        std::string nm = name("v");
+        emit(indent, nm + " : " + type_text(ty) + " = " + any_expn(ty,0));
+        declare(nm,ty,false);
+    } else if (choice == 2) {
+        // Assign to a variable.
+        GenTy ty = (GenTy)pick(3);
+        std::vector<GenVar> vs = visible(ty,true);
+        if (vs.empty()) return stmt(indent,depth,rety);
+        emit(indent, vs[pick(vs.size())].name + " = " + any_expn(ty,0));
+    } else if (choice == 3 && !ints.empty()) {
+        // Update an integer variable in place.
+        std::string nm = ints[pick(ints.size())].name;
+        switch (pick(3)) {
+        case 0: emit(indent, nm + " += " + stored(int_expn(1))); break;
+        case 1: emit(indent, nm + " -= " + stored(int_expn(1))); break;
+        default: emit(indent, nm + " *= " + std::to_string(pick(7))); break;
+        }
+        emit(indent, nm + " = " + nm + " % " + std::to_string(wrap));
+    } else if (choice == 4) {
+        // Call a procedure.
+        std::string c = call(GEN_NONE,0);
+        if (c == "") return stmt(indent,depth,rety);
+        emit(indent, c);
+    } else if (choice <= 6) {
+        // Print some values.
+        std::string text = "print(";
+        int n = 1 + pick(2);
+        for (int i = 0; i < n; i++) {
+            if (i > 0) text += ", ";
+            GenTy ty = (GenTy)pick(3);
+            text += ty == GEN_INT ? int_expn(0).text : any_expn(ty,0);
+        }
+        emit(indent, text + ")");
+    } else if (choice == 7 && loop_depth < (in_def ? 1 : 2)) {
+        // A counted loop.
+        std::string ctr = name("c");
+        emit(indent, ctr + " : int = 0");
+        declare(ctr,GEN_INT,true);
+        emit(indent, "while " + ctr + " < " + std::to_string(1 + pick(4)) + ":");
+        loop_depth++;
+        block(indent+1,depth+1,rety);
+        loop_depth--;
+        emit(indent+1, ctr + " += 1");
+    } else if (choice == 8) {
+        // A conditional, possibly returning early from a `def`.
+        emit(indent, "if " + bool_expn(0) + ":");
+        block(indent+1,depth+1,rety);
+        if (in_def && loop_depth == 0 && chance(25)) {
+            emit(indent+1, rety == GEN_NONE ? "return" : "return " + any_expn(rety,0));
+        }
+        emit(indent, "else:");
+        block(indent+1,depth+1,rety);
+    } else {
+        emit(indent, "pass");
+    }
+}
+
+void Generator::block(int indent, int depth, GenTy rety) {
+    scopes.push_back(std::vector<GenVar> { });
+    int n = 1 + pick(depth == 0 ? 6 : 3);
+    for (int i = 0; i < n; i++) {
+        stmt(indent,depth,rety);
+    }
+    scopes.pop_back();
+}
+
+void Generator::defn(void) {
+    GenDef f { name("f"), { }, (GenTy)pick(4) };
+    if (f.rety == GEN_STR) f.rety = GEN_NONE;
+    scopes.push_back(std::vector<GenVar> { });
+    std::string text = "def " + f.name + "(";
+    int n = pick(4);
+    for (int i = 0; i < n; i++) {
+        GenTy ty = chance(70) ? GEN_INT : GEN_BOOL;
+        std::string nm = name("a");
+        if (i > 0) text += ", ";
+        text += nm + " : " + type_text(ty);
+        f.params.push_back(ty);
+        declare(nm,ty,false);
+    }
+    emit(0, text + ") -> " + type_text(f.rety) + ":");
+    in_def = true;
+    block(1,0,f.rety);
+    emit(1, f.rety == GEN_NONE ? "return" : "return " + any_expn(f.rety,0));
+    in_def = false;
+    scopes.pop_back();
+    emit(0, "");
+    defs.push_back(f);
+    callable = defs.size();
+}
+
+std::vector<std::string> Generator::program(void) {
+    int n = pick(5);
+    for (int i = 0; i < n; i++) {
+        defn();
+    }
+    block(0,0,GEN_NONE);
+    return lines;
+}
+
+// * * * * *
+//
+// Running a program both ways.
+//
+
+std::string read_file(std::string name) {
+    std::ifstream in { name };
+    std::stringstream ss { };
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+void write_file(std::string name, std::string text) {
+    std::ofstream out { name };
+    out << text;
+}
+
+std::string join(const std::vector<std::string>& lines) {
+    std::string text { };
+    for (const std::string& line : lines) {
+        text += line + "\n";
+    }
+    return text;
+}
+
+// run_x86
+//
+// Assembles and links the x86-64 code in `stem`.x86.s with `cc`, then
+// runs it with no input, leaving its output in `stem`.x86.out to be
+// compared with the interpreter's, `interp`.
+//
+Outcome run_x86(std::string stem, const std::string& interp) {
+    std::string exe = stem + ".x86";
+    std::string cc = "cc -o " + exe + " " + exe + ".s";
+    std::string run = exe + " < /dev/null > " + exe + ".out";
+    if (system(cc.c_str()) != 0 || system(run.c_str()) != 0) {
+        return FAILED;
+    }
+    std::string x86 = read_file(exe + ".out");
+    return interp == x86 ? SAME : DIFFER;
+}
+
+// run_both
+//
+// Runs the program in `stem`.slpy with the interpreter and with SPIM,
+// leaving the outputs in `stem`.interp and `stem`.spim (or, with
+// `--engine x86`, compiled for x86-64 by `run_x86`). This is the
+// work of a test process, and its result is the process's exit code.
+//
+Outcome run_both(std::string stem) {
+    std::string interp { };
+    try {
+        DWISLPY::Driver dwislpy { stem + ".slpy" };
+        dwislpy.parse();
+        dwislpy.check();
+        dwislpy.closures = use_closures;
+        dwislpy.jit_threshold = use_jit ? 1 : 0;
+        dwislpy.ir = use_ir;
+        std::stringstream out { };
+        std::stringstream in { };
+        std::cout.rdbuf(out.rdbuf());
+        std::cin.rdbuf(in.rdbuf());
+        try {
+            dwislpy.run();
+        } catch (DwislpyError se) {
+            write_file(stem + ".interp", out.str() + se.what() + "\n");
+            return FAILED;
+        }
+        interp = out.str();
+        write_file(stem + ".interp", interp);
+        if (use_x86) {
+            std::ofstream x86 { stem + ".x86.s" };
+            dwislpy.compile_x86(x86);
+        } else {
+            std::ofstream mips { stem + ".s" };
+            dwislpy.compile(mips);
+        }
+    } catch (DwislpyError se) {
+        write_file(stem + ".interp", std::string(se.what()) + "\n");
+        return REJECTED;
+    }
+    if (use_x86) {
+        return run_x86(stem,interp);
+    }
+
+    std::string asm_name = stem + ".s";
+    if (!spim_embed_load(asm_name.c_str()) || !spim_embed_run("", 0)) {
+        return FAILED;
+    }
+    size_t len;
+    const char* spim_out = spim_embed_output(&len);
+    std::string spim { spim_out, len };
+    write_file(stem + ".spim", spim);
+    return interp == spim ? SAME : DIFFER;
+}
+
+// run_all
+//
+// Runs each of the programs, whose sources are at the given stems,
+// in a separate process, with up to `jobs` of them at once. Returns
+// the outcome of each.
+//
+std::vector<Outcome> run_all(const std::vector<std::string>& stems, int jobs) {
+    std::vector<Outcome> outcomes(stems.size(), CRASHED);
+    std::map<pid_t,size_t> running { };
+    size_t next = 0;
+    std::cout.flush();
+    std::cerr.flush();
+    while (next < stems.size() || !running.empty()) {
+        while (next < stems.size() && (int)running.size() < jobs) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                alarm(time_limit);
+                _exit(run_both(stems[next]));
+            }
+            if (pid < 0) {
+                perror("fork");
+                exit(2);
+            }
+            running[pid] = next++;
+        }
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) break;
+        size_t i = running[pid];
+        running.erase(pid);
+        if (WIFEXITED(status) && WEXITSTATUS(status) <= FAILED) {
+            outcomes[i] = (Outcome)WEXITSTATUS(status);
+        }
+    }
+    return outcomes;
+}
+
+// * * * * *
+//
+// Shrinking a failing program.
+//
+
+int indent_of(const std::string& line) {
+    size_t n = line.find_first_not_of(' ');
+    return n == std::string::npos ? -1 : (int)n;
+}
+
+// The end of the statement that starts at line `i`: its nested block
+// and, for an `if`, its `else` and that block.
+size_t stmt_end(const std::vector<std::string>& lines, size_t i) {
+    int ind = indent_of(lines[i]);
+    size_t j = i + 1;
+    while (j < lines.size()) {
+        int jnd = indent_of(lines[j]);
+        if (jnd > ind || jnd < 0) {
+            j++;
+        } else if (jnd == ind && lines[j].compare(ind,5,"else:") == 0) {
+            j++;
+        } else {
+            break;
+        }
+    }
+    while (j > i + 1 && indent_of(lines[j-1]) < 0) j--;
+    return j;
+}
+
+// candidates
+//
+// The programs to try in place of `lines`: each statement deleted,
+// or replaced by `pass`, and each `while` or `if` replaced by its
+// first block.
+//
+std::vector<std::vector<std::string>> candidates(const std::vector<std::string>& lines) {
+    std::vector<std::vector<std::string>> cands { };
+    for (size_t i = 0; i < lines.size(); i++) {
+        int ind = indent_of(lines[i]);
+        if (ind < 0 || lines[i].compare(ind,5,"else:") == 0) continue;
+        size_t j = stmt_end(lines,i);
+        std::vector<std::string> before(lines.begin(), lines.begin()+i);
+        std::vector<std::string> after(lines.begin()+j, lines.end());
+
+        std::vector<std::string> del = before;
+        del.insert(del.end(), after.begin(), after.end());
+        cands.push_back(del);
+
+        if (lines[i].substr(ind) != "pass") {
+            std::vector<std::string> pass = before;
+            pass.push_back(std::string(ind,' ') + "pass");
+            pass.insert(pass.end(), after.begin(), after.end());
+            cands.push_back(pass);
+        }
+
+        bool nests = lines[i].compare(ind,6,"while ") == 0
+                  || lines[i].compare(ind,3,"if ") == 0;
+        if (nests) {
+            std::vector<std::string> flat = before;
+            for (size_t k = i+1; k < j; k++) {
+                if (indent_of(lines[k]) == ind) break; // The `else:`.
+                flat.push_back(lines[k].substr(std::min(lines[k].size(),(size_t)4)));
+            }
+            flat.insert(flat.end(), after.begin(), after.end());
+            cands.push_back(flat);
+        }
+    }
+    return cands;
+}
+
+// shrink
+//
+// Repeatedly replaces `lines` by the first of its candidates that
+// still differs, trying `jobs` candidates at a time, until none do.
+//
+std::vector<std::string> shrink(std::vector<std::string> lines,
+                                std::string dir, int jobs) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        std::vector<std::vector<std::string>> cands = candidates(lines);
+        for (size_t c = 0; c < cands.size() && !progress; c += jobs) {
+            std::vector<std::string> stems { };
+            for (size_t k = c; k < cands.size() && k < c + jobs; k++) {
+                std::string stem = dir + "/shrink-" + std::to_string(k - c);
+                write_file(stem + ".slpy", join(cands[k]));
+                stems.push_back(stem);
+            }
+            std::vector<Outcome> outs = run_all(stems,jobs);
+            for (size_t k = 0; k < outs.size(); k++) {
+                if (outs[k] == DIFFER) {
+                    lines = cands[c + k];
+                    progress = true;
+                    break;
+                }
+            }
+        }
+    }
+    lines.erase(std::remove_if(lines.begin(), lines.end(),
+                               [](const std::string& line) {
+                                   return indent_of(line) < 0;
+                               }),
+                lines.end());
+    return lines;
+}
+
+char* flag_value(int argc, char** argv, std::string flag) {
+    for (int i=1; i<argc-1; i++) {
+        if (strcmp(flag.c_str(),argv[i]) == 0) return argv[i+1];
+    }
+    return nullptr;
+}
+
+// * * * * *
+//
+// main - the DWISLPY differential tester
+//
+int main(int argc, char** argv) {
+
+    char* count_arg  = flag_value(argc,argv,"--count");
+    char* seed_arg   = flag_value(argc,argv,"--seed");
+    char* jobs_arg   = flag_value(argc,argv,"--jobs");
+    char* dir_arg    = flag_value(argc,argv,"--dir");
+    char* except_arg = flag_value(argc,argv,"--exceptions");
+    char* engine_arg = flag_value(argc,argv,"--engine");
+    int count = count_arg ? atoi(count_arg) : 200;
+    unsigned int seed = seed_arg ? atoi(seed_arg) : 1;
+    int jobs = jobs_arg ? atoi(jobs_arg) : std::thread::hardware_concurrency();
+    jobs = std::max(1, jobs);
+    std::string dir = dir_arg ? dir_arg : "difftest-out";
+    if (engine_arg && strcmp(engine_arg,"ast") != 0
+        && strcmp(engine_arg,"closures") != 0
+        && strcmp(engine_arg,"jit") != 0
+        && strcmp(engine_arg,"ir") != 0
+        && strcmp(engine_arg,"x86") != 0) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--count N] [--seed S] [--jobs J] [--dir DIR]"
+                  << " [--exceptions exceptions.s]"
+                  << " [--engine ast|closures|jit|ir|x86] [file.slpy ...]"
+                  << std::endl;
+        return 2;
+    }
+    use_closures = engine_arg && strcmp(engine_arg,"closures") == 0;
+    use_jit = engine_arg && strcmp(engine_arg,"jit") == 0;
+    use_ir = engine_arg && strcmp(engine_arg,"ir") == 0;
+    use_x86 = engine_arg && strcmp(engine_arg,"x86") == 0;
+    mkdir(dir.c_str(), 0755);
+
+    std::vector<std::string> files { };
+    for (int i=1; i<argc; i++) {
+        if (argv[i][0] == '-') {
+            i++; // Every flag takes a value.
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    // Gather the programs, each as its lines and a name.
+    std::vector<std::vector<std::string>> programs { };
+    std::vector<std::string> names { };
+    if (files.empty()) {
+        for (int i = 0; i < count; i++) {
+            Generator gen { seed + i };
+            programs.push_back(gen.program());
+            names.push_back("seed-" + std::to_string(seed + i));
+        }
+    } else {
+        for (std::string file : files) {
+            std::vector<std::string> lines { };
+            std::stringstream ss { read_file(file) };
+            std::string line;
+            while (std::getline(ss, line)) lines.push_back(line);
+            programs.push_back(lines);
+            size_t slash = file.find_last_of("/");
+            std::string base = file.substr(slash == std::string::npos ? 0 : slash+1);
+            names.push_back(base.substr(0, base.find_last_of(".")));
+        }
+    }
+
+    spim_embed_initialize(except_arg ? except_arg : "exceptions.s", 0);
+
+    std::vector<std::string> stems { };
+    for (size_t i = 0; i < programs.size(); i++) {
+        std::string stem = dir + "/" + names[i];
+        write_file(stem + ".slpy", join(programs[i]));
+        stems.push_back(stem);
+    }
+    std::vector<Outcome> outcomes = run_all(stems,jobs);
+
+    int tally[CRASHED+1] = { };
+    int mismatches = 0;
+    for (size_t i = 0; i < programs.size(); i++) {
+        tally[outcomes[i]]++;
+        if (outcomes[i] == SAME) {
+            for (std::string ext : {".slpy", ".s", ".interp", ".spim",
+                                    ".x86.s", ".x86", ".x86.out"}) {
+                unlink((stems[i] + ext).c_str());
+            }
+            continue;
+        }
+        std::cout << names[i] << ": " << outcome_names[outcomes[i]] << std::endl;
+        if (outcomes[i] == DIFFER) {
+            mismatches++;
+            std::vector<std::string> small = shrink(programs[i], dir, jobs);
+            std::string stem = stems[i] + "-min";
+            write_file(stem + ".slpy", join(small));
+            run_all({stem},1);
+            std::cout << "    shrunk from " << programs[i].size() << " to "
+                      << small.size() << " lines: " << stem << ".slpy" << std::endl;
+        }
+    }
+    for (std::string ext : {".slpy", ".s", ".interp", ".spim",
+                                ".x86.s", ".x86", ".x86.out"}) {
+        for (int k = 0; k < jobs; k++) {
+            unlink((dir + "/shrink-" + std::to_string(k) + ext).c_str());
+        }
+    }
+
+    std::cout << programs.size() << " programs:";
+    for (int o = SAME; o <= CRASHED; o++) {
+        std::cout << " " << tally[o] << " " << outcome_names[o]
+                  << (o < CRASHED ? "," : ".");
+    }
+    std::cout << std::endl;
+    return mismatches + tally[CRASHED] + tally[FAILED] > 0 ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <fstream>
+
+#include "dwislpy-ast.hh"
+#include "dwislpy-flex.hh"
+#include "dwislpy-bison.tab.hh"
+#include "dwislpy-util.hh"
+#include "dwislpy-main.hh"
+#include "dwislpy-prof.hh"
+#include "dwislpy-trace.hh"
+#include "dwislpy-jit.hh"
+
+//
+// dwislpy-driver.cc
+//
+// The methods of `DWISLPY::Driver`, shared by the `dwislpyc` compiler
+// and by the `dwislpy-bench` timing harness.
+//
+
+// * * * * *
+//
+// DWISLPY::Driver methods.
+//
+// This class just houses the components of the DWISLPY interpreter.
+// We wrote it this way just to prevent some deallocation errors
+// due to sharing pointers in our interfacing with Flex/Bison, programs
+// built in a more permissive error (and originally for C).
+//
+
+DWISLPY::Driver::Driver(std::string filename) :
+    src_name {filename}
+{
+    src_stream = istream_ptr { new std::ifstream { src_name } };
+}
+
+// parse
+//
+// Checks the file's stream, builds the lexer for it, then parses the
+// file's contents. The parser sets the `prgm` AST using the `set`
+// method.
+//
+void DWISLPY::Driver::parse(void) {
+    if (src_stream->fail()) {
+        Locn locn {src_name};
+        std::string mesg = "Unable to open file. Does the file exist?";
+        throw DwislpyError {locn, mesg};
+    }
+    lexer = Lexer_ptr { new DWISLPY::Lexer { src_stream.get(), src_name } };
+    DWISLPY::Lexer& lexer_local = *lexer;
+    parser = Parser_ptr { new DWISLPY::Parser { lexer_local, *this } };
+    parser->parse();
+}
+
+// run
+//
+// Runs the DwiSlpy program. If `memoizing`, calls to pure functions
+// reuse the results of earlier calls with the same arguments (see
+// `Defn::call_memo`). If `profiling`, a profile of the run is
+// reported to `std::cerr` and its collapsed stacks written to
+// `foo.folded`. If `tracing`, a trace of the run is written to
+// `foo.trace`. These are written even if the run ends with a run-time
+// error. If `closures`, and neither is being done, the program is
+// run by the closure-compiled engine (see `Prgm::run_compiled`).
+//
+void DWISLPY::Driver::run(void) {
+    Defn::memoizing = memoizing;
+    Jit::threshold = jit_threshold;
+    if (!profiling && !tracing) {
+        if (ir) {
+            program->run_ir();
+        } else if (closures) {
+            program->run_compiled();
+        } else {
+            program->run();
+        }
+        return;
+    }
+    Prof prof { };
+    trace_ring ring { };
+    if (tracing) {
+        if (!trace_open(&ring, TRACE_DEFAULT_EVENTS)) {
+            Locn locn {src_name};
+            throw DwislpyError {locn, "Unable to allocate the trace."};
+        }
+        for (std::pair<Name,Defn_ptr> dfpr : program->defs) {
+            if (!trace_name(&ring, dfpr.second->line(), dfpr.first.c_str())) {
+                trace_close(&ring);
+                Locn locn {src_name};
+                throw DwislpyError {locn, "Unable to allocate the trace."};
+            }
+        }
+        trace_active = &ring;
+    }
+    if (profiling) {
+        Prof::active = &prof;
+    }
+    try {
+        program->run();
+    } catch (...) {
+        finish_run(prof, ring);
+        throw;
+    }
+    finish_run(prof, ring);
+}
+
+void DWISLPY::Driver::finish_run(const Prof& prof, trace_ring& ring) {
+    Prof::active = nullptr;
+    trace_active = nullptr;
+    std::cout.flush();
+    std::string stem = src_name.substr(0, src_name.find_last_of("."));
+    if (profiling) {
+        prof.report(std::cerr);
+        std::ofstream out_stream { stem + ".folded" };
+        prof.write_folded(out_stream);
+    }
+    if (tracing) {
+        std::string out_name = stem + ".trace";
+        if (!trace_write(&ring, out_name.c_str())) {
+            std::cerr << "Unable to write " << out_name << "." << std::endl;
+        }
+        trace_close(&ring);
+    }
+}
+
+// check
+//
+// Runs the DwiSlpy program.
+//
+void DWISLPY::Driver::check(void) {
+    program->chck();
+}
+
+// compile
+//
+// Runs the DwiSlpy program.
+//
+void DWISLPY::Driver::compile(void) {
+    std::ofstream out_stream { };
+    size_t thedot = src_name.find_last_of("."); 
+    std::string out_name = src_name.substr(0, thedot) + ".s"; 
+    out_stream.open(out_name);
+    compile(out_stream);
+    out_stream.close();
+}
+
+// compile(os)
+//
+// Compiles the DwiSlpy program, writing its MIPS code to `os`.
+//
+void DWISLPY::Driver::compile(std::ostream& os) {
+    program->compile(os);
+}
+
+// compile_x86
+//
+// Compiles the DwiSlpy program to x86-64 assembly, in `foo.x86.s`.
+//
+void DWISLPY::Driver::compile_x86(void) {
+    std::ofstream out_stream { };
+    size_t thedot = src_name.find_last_of("."); 
+    std::string out_name = src_name.substr(0, thedot) + ".x86.s"; 
+    out_stream.open(out_name);
+    compile_x86(out_stream);
+    out_stream.close();
+}
+
+// compile_x86(os)
+//
+// Compiles the DwiSlpy program, writing its x86-64 code to `os`.
+//
+void DWISLPY::Driver::compile_x86(std::ostream& os) {
+    program->compile_x86(os);
+}
+
+// dump
+//
+// Outputs the DwiSlpy program, either by depicting its AST, or by
+// a "pretty" version that mimics the original source code.
+//
+void DWISLPY::Driver::dump(bool pretty) {
+    if (pretty) {
+        program->output(std::cout);
+    } else {
+        program->dump();
+    }
+}
@@ -25,9 +25,15 @@ std::string INPT_BUFF_LBL; // Label for the 80-character `input` buffer.
 // Prgm::trans(void)
 //
 // Translate each of the definitions and the main script of the program
-// into their intermediate representation,
+// into their intermediate representation. This is done just once, and
+// the IR is shared by `run_ir`, `compile`, and `compile_x86`, since
+// translating again would add each temporary to the symbol tables
+// again.
 //
 void Prgm::trans(void) {
+
+    if (translated) return;
+    translated = true;
     
     // Make the global symbol table shared by all the program's IR.
     //
@@ -41,10 +47,11 @@ void Prgm::trans(void) {
     NONE_STRG_LBL = glbl_symt_ptr->add_strg("None"); 
     INPT_BUFF_LBL = glbl_symt_ptr->add_strg("12345678901234567890123456789012345678901234567890123456789012345678901234567890"); 
 
-    // Translate each definition into IR.
+    // Translate each live definition into IR.
     // 
     for (std::pair<Name,Defn_ptr> dfpr : defs) {
         Defn_ptr defn = dfpr.second;
+        if (!defn->live) continue; // Never called. See Prgm::chck.
         defn->symt.set_parent(glbl_symt_ptr); // Set parent to global table.
         defn->trans();
     }
@@ -74,6 +81,7 @@ void Defn::trans(void) {
     std::string def_lbl = symt.add_labl(name);
     std::string ext_lbl = symt.add_labl(name+"_done");
     //
+    code = INST_vec {};
     code.push_back(INST_ptr { new LBL {def_lbl} });
     code.push_back(INST_ptr { new ENTER {} });
     blck->trans(ext_lbl,symt,code);
@@ -350,6 +358,10 @@ void LtEq::trans_cndn(std::string then_lbl, std::string else_lbl,
 void Func::trans_cndn(std::string then_lbl, std::string else_lbl,
                       SymT& symt, INST_vec& code) {
     
+    if (builtin) {
+        builtin->trans_cndn(then_lbl,else_lbl,symt,code);
+        return;
+    }
     std::string srce1 = symt.add_temp(type);
     trans(srce1,symt,code);
     code.push_back(INST_ptr {new BCZ {"eqz",
@@ -375,6 +387,10 @@ void Proc::trans([[maybe_unused]] std::string dest, SymT& symt, INST_vec& code)
 
 void Func::trans(std::string dest, SymT& symt, INST_vec& code) {
 
+    if (builtin) {
+        builtin->trans(dest,symt,code);
+        return;
+    }
     std::vector<std::string> srcs;
     for (Expn_ptr expn : args) {
         srcs.push_back(symt.add_temp(expn->type));
@@ -565,3 +581,9 @@ void Inpt::trans(std::string dest, SymT& symt, INST_vec& code) {
     code.push_back(INST_ptr {new PTS {strg}});
     code.push_back(INST_ptr {new GTI {dest}});
 }
+
+void Perf::trans(std::string dest, SymT& symt, INST_vec& code) {
+    std::string cntr = symt.add_temp(IntTy {});
+    expn->trans(cntr,symt,code);
+    code.push_back(INST_ptr {new RDC {dest,cntr}});
+}
@@ -3,7 +3,7 @@
 
 //
 // Objects used for compilation and assembly of a DwiSlpy program
-// to a MIPS program.
+// to a MIPS program, or to an x86-64 one.
 //
 // It defines subclasses of INST. These are pseudo-instructions
 
@@ -17,6 +17,8 @@
 #include "dwislpy-check.hh"
 
 class INST;
+class Jit_code;
+class VM_code;
 typedef std::shared_ptr<INST> INST_ptr;
 typedef std::vector<INST_ptr> INST_vec;
 
@@ -56,7 +58,16 @@ typedef std::vector<INST_ptr> INST_vec;
 //            MIPS instructions, outputting them to the give output
 //            stream. This is performed in PASS 3 of compilation.
 //
-// This method takes a SymT object which contains information for
+// * toX86 - This instead converts it into x86-64 instructions, in
+//           GNU assembler syntax. See dwislpy-x86.cc.
+//
+// * toJIT - This encodes it as x86-64 machine code, for the JIT to
+//           run while interpreting. See dwislpy-jit.cc.
+//
+// * toVM - This lowers it to an operation of the virtual machine that
+//          runs the IR directly. See dwislpy-vm.cc.
+//
+// These methods take a SymT object which contains information for
 // assembling each function component of the program, namely the stack
 // frame locations of each variable and temporary. It also tracks
 // whole-program information like string constants.
@@ -65,6 +76,9 @@ typedef std::vector<INST_ptr> INST_vec;
 class INST {
 public:
   virtual void toMIPS(std::ostream& os, const SymT& assm) const = 0;
+  virtual void toX86(std::ostream& os, const SymT& assm) const = 0;
+  virtual void toJIT(Jit_code& jit, const SymT& assm) const = 0;
+  virtual void toVM(VM_code& vm, const SymT& assm) const = 0;
 };
 
 typedef std::shared_ptr<INST> INST_ptr;
@@ -86,6 +100,9 @@ public:
     SET(std::string d, int v) : dst {d}, val {v} { }
     virtual ~SET(void) = default;
     void toMIPS(std::ostream& os, const SymT& assm) const;
+    void toX86(std::ostream& os, const SymT& assm) const;
+    void toJIT(Jit_code& jit, const SymT& assm) const;
+    void toVM(VM_code& vm, const SymT& assm) const;
 };
 
 class STL : public INST {
@@ -95,6 +112,9 @@ public:
     STL(std::string d, std::string l) : dst {d}, lbl {l} { }
     virtual ~STL(void) = default;
     void toMIPS(std::ostream& os, const SymT& assm) const;
+    void toX86(std::ostream& os, const SymT& assm) const;
+    void toJIT(Jit_code& jit, const SymT& assm) const;
+    void toVM(VM_code& vm, const SymT& assm) const;
 };
 
 class MOV : public INST {
@@ -104,6 +124,9 @@ public:
     MOV(std::string d, std::string s) : dst {d}, src {s} {}
     virtual ~MOV(void) = default;
     void toMIPS(std::ostream& os, const SymT& assm) const;
+    void toX86(std::ostream& os, const SymT& assm) const;
+    void toJIT(Jit_code& jit, const SymT& assm) const;
+    void toVM(VM_code& vm, const SymT& assm) const;
 };
 
 class ADD : public INST {
@@ -114,6 +137,9 @@ public:
     ADD(std::string d, std::string s1, std::string s2) : dst {d}, src1 {s1}, src2 {s2} {}
     virtual ~ADD(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 // multiplication
@@ -125,6 +151,9 @@ public:
     MLT(std::string d, std::string s1, std::string s2) : dst {d}, src1 {s1}, src2 {s2} {}
     virtual ~MLT(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 // multiplication
@@ -136,6 +165,9 @@ public:
     DIV(std::string d, std::string s1, std::string s2) : dst {d}, src1 {s1}, src2 {s2} {}
     virtual ~DIV(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 // multiplication
 class MOD : public INST {
@@ -146,6 +178,9 @@ public:
     MOD(std::string d, std::string s1, std::string s2) : dst {d}, src1 {s1}, src2 {s2} {}
     virtual ~MOD(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class SUB : public INST {
@@ -156,6 +191,9 @@ public:
     SUB(std::string d, std::string s1, std::string s2) : dst {d}, src1 {s1}, src2 {s2} {}
     virtual ~SUB(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class NOP : public INST {
@@ -163,6 +201,9 @@ public:
     NOP(void) { } 
     virtual ~NOP(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 
@@ -182,6 +223,9 @@ public:
     LBL(std::string l) : lbl {l} {}
     virtual ~LBL(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class BCN : public INST {
@@ -196,6 +240,9 @@ public:
         cndn {cn}, src1 {s1}, src2 {s2}, lblt {lt}, lblf {lf} {}
     virtual ~BCN(void) = default;
     virtual void toMIPS(std::ostream& os, const SymT& symt) const;
+    virtual void toX86(std::ostream& os, const SymT& symt) const;
+    virtual void toJIT(Jit_code& jit, const SymT& symt) const;
+    virtual void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class BCZ : public INST {
@@ -208,6 +255,9 @@ public:
         cndn {cn}, src {s}, lblt {lt}, lblf {lf} {}
     virtual ~BCZ(void) = default;
     virtual void toMIPS(std::ostream& os, const SymT& symt) const;
+    virtual void toX86(std::ostream& os, const SymT& symt) const;
+    virtual void toJIT(Jit_code& jit, const SymT& symt) const;
+    virtual void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class JMP : public INST {
@@ -216,6 +266,9 @@ public:
     JMP(std::string l) : lbl {l} {}
     virtual ~JMP(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 //
@@ -231,6 +284,9 @@ public:
     ENTER(void) {}
     virtual ~ENTER(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class RTN : public INST {
@@ -239,6 +295,9 @@ public:
     RTN(std::string s) : src {s} {}
     virtual ~RTN(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class LEAVE : public INST {
@@ -246,6 +305,9 @@ public:
     LEAVE(void) {}
     virtual ~LEAVE(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 //
@@ -263,6 +325,9 @@ public:
     ARG(int i, std::string s) : idx {i}, src {s} {}
     virtual ~ARG(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class RTV : public INST {
@@ -271,6 +336,9 @@ public:
     RTV(std::string d) : dst {d} {}
     virtual ~RTV(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class CLL : public INST {
@@ -279,6 +347,9 @@ public:
     CLL(std::string l) : lbl {l} {}
     virtual ~CLL(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 //
@@ -287,6 +358,7 @@ public:
 // GTI d - Gets a integer of input into d.
 // PTI s - Outputs the integer value of s.
 // PTS s - Outputs a string sitting at an address s.
+// RDC d,s - Reads the performance counter numbered s into d.
 //
 //
 class GTI : public INST {
@@ -295,6 +367,9 @@ public:
     GTI(std::string dest) : dst {dest} {} 
     virtual ~GTI(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class PTI : public INST {
@@ -303,6 +378,9 @@ public:
     PTI(std::string s) : src {s} { } 
     virtual ~PTI(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 class PTS : public INST {
@@ -311,6 +389,21 @@ public:
     PTS(std::string srce) : src {srce} { } 
     virtual ~PTS(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
+};
+
+class RDC : public INST {
+public:
+    std::string dst;
+    std::string src;
+    RDC(std::string d, std::string s) : dst {d}, src {s} { }
+    virtual ~RDC(void) = default;
+    void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 
@@ -323,8 +416,16 @@ public:
     CMT(std::string m) : msg {m} {}
     virtual ~CMT(void) = default;
     void toMIPS(std::ostream& os, const SymT& symt) const;
+    void toX86(std::ostream& os, const SymT& symt) const;
+    void toJIT(Jit_code& jit, const SymT& symt) const;
+    void toVM(VM_code& vm, const SymT& symt) const;
 };
 
 
+//
+// Frame layout for x86-64 code, shared by the JIT (see dwislpy-x86.cc).
+//
+void layout_frame_x86(SymT& symt);
+
 #endif
 
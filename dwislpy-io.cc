@@ -0,0 +1,193 @@
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dwislpy-io.hh"
+
+//
+// dwislpy-io.cc
+//
+// The interpreter's console output and input layers. See dwislpy-io.hh.
+//
+
+Outbuf::Outbuf(int fd, size_t size) :
+    fd {fd}, buffer(size), replaced {nullptr}
+{
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+Outbuf::~Outbuf(void) {
+    drain();
+    if (replaced) {
+        std::cout.rdbuf(replaced);
+    }
+}
+
+void Outbuf::install(void) {
+    std::ios_base::sync_with_stdio(false);
+    std::cout.flush();
+    replaced = std::cout.rdbuf(this);
+}
+
+// drain
+//
+// Writes out the buffered characters, retrying short writes. Returns
+// false if the descriptor cannot be written.
+//
+bool Outbuf::drain(void) {
+    const char* next = pbase();
+    const char* end = pptr();
+    while (next < end) {
+        ssize_t wrote = ::write(fd, next, end - next);
+        if (wrote < 0) {
+            if (errno == EINTR) continue;
+            setp(buffer.data(), buffer.data() + buffer.size());
+            return false;
+        }
+        next += wrote;
+    }
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return true;
+}
+
+Outbuf::int_type Outbuf::overflow(int_type c) {
+    if (!drain()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize Outbuf::xsputn(const char* s, std::streamsize n) {
+    std::streamsize left = n;
+    while (left > 0) {
+        std::streamsize room = epptr() - pptr();
+        if (room == 0) {
+            if (!drain()) break;
+            continue;
+        }
+        std::streamsize chunk = left < room ? left : room;
+        std::memcpy(pptr(), s, chunk);
+        pbump(static_cast<int>(chunk));
+        s += chunk;
+        left -= chunk;
+    }
+    return n - left;
+}
+
+int Outbuf::sync(void) {
+    return drain() ? 0 : -1;
+}
+
+Inbuf* Inbuf::active = nullptr;
+
+Inbuf::Inbuf(int fd, size_t size) :
+    fd {fd}, buffer(size), mapped {nullptr}, mapped_size {0},
+    replaced {nullptr}
+{
+    setg(buffer.data(), buffer.data(), buffer.data());
+}
+
+Inbuf::~Inbuf(void) {
+    if (replaced) {
+        std::cin.rdbuf(replaced);
+    }
+    if (active == this) {
+        active = nullptr;
+    }
+    if (mapped) {
+        munmap(mapped, mapped_size);
+    }
+}
+
+// map_file
+//
+// Maps the file `filename` into memory as all of the input. Returns
+// false if it cannot be opened or mapped.
+//
+bool Inbuf::map_file(std::string filename) {
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) < 0) {
+        close(file);
+        return false;
+    }
+    mapped_size = info.st_size;
+    if (mapped_size > 0) {
+        void* addr = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (addr == MAP_FAILED) {
+            close(file);
+            return false;
+        }
+        mapped = static_cast<char*>(addr);
+        madvise(mapped, mapped_size, MADV_SEQUENTIAL);
+    }
+    close(file);
+    fd = -1;
+    setg(mapped, mapped, mapped + mapped_size);
+    return true;
+}
+
+void Inbuf::install(void) {
+    std::ios_base::sync_with_stdio(false);
+    replaced = std::cin.rdbuf(this);
+    active = this;
+}
+
+Inbuf::int_type Inbuf::underflow(void) {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    if (fd < 0) {
+        return traits_type::eof();
+    }
+    ssize_t got;
+    do {
+        got = ::read(fd, buffer.data(), buffer.size());
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) {
+        return traits_type::eof();
+    }
+    setg(buffer.data(), buffer.data(), buffer.data() + got);
+    return traits_type::to_int_type(*gptr());
+}
+
+// read_line
+//
+// Sets `line` to the next line of input, without its line ending.
+// Returns false if there is no more input.
+//
+bool Inbuf::read_line(std::string& line) {
+    line.clear();
+    bool any = false;
+    while (true) {
+        if (gptr() == egptr()
+            && traits_type::eq_int_type(underflow(), traits_type::eof())) {
+            break;
+        }
+        any = true;
+        char* start = gptr();
+        char* end = egptr();
+        char* newline = static_cast<char*>(std::memchr(start, '\n', end - start));
+        if (newline) {
+            line.append(start, newline - start);
+            setg(eback(), newline + 1, end);
+            break;
+        }
+        line.append(start, end - start);
+        setg(eback(), end, end);
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return any;
+}
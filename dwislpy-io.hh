@@ -0,0 +1,78 @@
+#ifndef _DWISLPY_IO_H
+#define _DWISLPY_IO_H
+
+//
+// dwislpy-io.hh
+//
+// The interpreter's console output and input layers.
+//
+// By default `std::cout` is synchronized with C's stdio and, since
+// `print` used to end each line with `std::endl`, it made a `write`
+// system call for every line printed. Instead, `dwislpyc` installs an
+// `Outbuf` as the buffer of `std::cout` for the duration of the run:
+//
+//     Outbuf out { };
+//     out.install();
+//
+// This collects output in a large buffer, writing it to the standard
+// output (file descriptor 1) only when the buffer is full, when the
+// stream is flushed (as `input()` does so that its prompt appears),
+// and when the `Outbuf` is destroyed (at exit).
+//
+// Similarly, `std::cin` reads through iostream's locale and sentry
+// machinery in small pieces. `dwislpyc` installs an `Inbuf` as its
+// buffer instead. This either reads the standard input (file descriptor
+// 0) in large chunks, or, given `--stdin-file`, maps a whole file into
+// memory and serves it without copying. While one is installed,
+// `Inbuf::active` points to it, and `input()` takes each line with
+// `Inbuf::read_line`, which scans the buffer for the newline itself.
+//
+
+#include <streambuf>
+#include <iostream>
+#include <vector>
+#include <string>
+
+class Outbuf : public std::streambuf {
+public:
+    static const size_t default_size = 1 << 20;
+    //
+    Outbuf(int fd = 1, size_t size = default_size);
+    virtual ~Outbuf(void);
+    void install(void);   // Make this the buffer of `std::cout`.
+    //
+protected:
+    virtual int_type overflow(int_type c);
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    virtual int sync(void);
+    //
+private:
+    int fd;
+    std::vector<char> buffer;
+    std::streambuf* replaced; // The buffer of `std::cout` before install.
+    bool drain(void);         // Write out what is buffered.
+};
+
+class Inbuf : public std::streambuf {
+public:
+    static const size_t default_size = 1 << 16;
+    static Inbuf* active; // The installed `Inbuf`, if any.
+    //
+    Inbuf(int fd = 0, size_t size = default_size);
+    virtual ~Inbuf(void);
+    bool map_file(std::string filename); // Read from this file instead.
+    void install(void);   // Make this the buffer of `std::cin`.
+    bool read_line(std::string& line);
+    //
+protected:
+    virtual int_type underflow(void);
+    //
+private:
+    int fd;
+    std::vector<char> buffer;
+    char* mapped;         // The mapped file, if any.
+    size_t mapped_size;
+    std::streambuf* replaced; // The buffer of `std::cin` before install.
+};
+
+#endif
@@ -0,0 +1,775 @@
+#include <csetjmp>
+#include <cstring>
+#include <set>
+#include <vector>
+#include "dwislpy-jit.hh"
+#include "dwislpy-inst.hh"
+#include "dwislpy-ast.hh"
+#include "dwislpy-check.hh"
+
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+#define JIT_NATIVE 1
+#else
+#define JIT_NATIVE 0
+#endif
+
+//
+// dwislpy-jit.cc
+//
+// The tiering JIT (see dwislpy-jit.hh). It defines
+//
+//     Jit::compile - checks that a definition can run natively, then
+//                    compiles it and its callees into executable memory
+//     Jit::call    - runs a definition's native code on the arguments
+//                    bound in its `Ctxt`
+//
+// and `INST::toJIT`, which encodes each IR instruction as x86-64
+// machine code into a `Jit_code`. The encoding is that of `toX86` (see
+// dwislpy-x86.cc): each variable and temporary has an 8-byte slot
+// below %rbp, ints are operated on as 32-bit values and then sign-
+// extended into their slot, and bools are 0 or 1. Every slot operand
+// has the form disp32(%rbp).
+//
+
+#define JIT_FAIL_LABEL "#fail"
+#define JIT_ENTRY_PREFIX "@"
+#define JIT_MAX_ARGS 6
+
+// The registers, by their number in an encoding.
+enum Jit_reg { RAX = 0, RCX = 1, RDX = 2, RSP = 4, RBP = 5,
+               RSI = 6, RDI = 7, R8 = 8, R9 = 9 };
+
+// The registers that pass a call's arguments, in order.
+static const int jit_arg_regs[JIT_MAX_ARGS] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+// The condition codes of `jcc`, as in its opcode 0x0F 0x80+cc.
+enum Jit_cc { CC_E = 0x4, CC_NE = 0x5, CC_L = 0xC, CC_GE = 0xD,
+              CC_LE = 0xE, CC_G = 0xF, CC_ALWAYS = -1 };
+
+// jit_cc(cndn)
+//
+// The condition code for a BCN or BCZ condition, as with `x86_jump`.
+//
+static int jit_cc(std::string cndn) {
+    if (cndn.back() == 'z') {
+        cndn.pop_back();
+    }
+    if (cndn == "lt") return CC_L;
+    if (cndn == "le") return CC_LE;
+    if (cndn == "eq") return CC_E;
+    if (cndn == "ne") return CC_NE;
+    if (cndn == "ge") return CC_GE;
+    return CC_G; // "gt"
+}
+
+// rex_w(reg)
+//
+// The REX prefix of a 64-bit operation on `reg` and a slot.
+//
+static int rex_w(int reg) {
+    return (reg >= 8) ? 0x4C : 0x48;
+}
+
+//
+// * * * * *
+//
+// Jit_code
+//
+
+void Jit_code::byte(int b) {
+    bytes.push_back((unsigned char)b);
+}
+
+void Jit_code::word(int w) {
+    unsigned int u = (unsigned int)w;
+    for (int i = 0; i < 4; i++) {
+        byte((u >> (8*i)) & 0xFF);
+    }
+}
+
+// slot(reg,symt,name)
+//
+// The ModRM byte and displacement of an operand that is `name`'s slot,
+// with `reg` (or an opcode extension) as the other operand.
+//
+void Jit_code::slot(int reg, const SymT& symt, const std::string& name) {
+    byte(0x80 | ((reg & 7) << 3) | RBP);
+    word(symt.get_frame_offset(name));
+}
+
+void Jit_code::jump(const std::string& lbl) {
+    byte(0xE9);
+    fixups.push_back({bytes.size(), scope + "/" + lbl});
+    word(0);
+}
+
+void Jit_code::branch(int cc, const std::string& lbl) {
+    byte(0x0F);
+    byte(0x80 | cc);
+    fixups.push_back({bytes.size(), scope + "/" + lbl});
+    word(0);
+}
+
+// call(name)
+//
+// Calls the definition `name`: one in this code by its displacement,
+// or one compiled earlier at its entry point.
+//
+void Jit_code::call(const std::string& name) {
+    if (natives.count(name) > 0) {
+        call_at(reinterpret_cast<unsigned long>(natives.at(name)));
+        return;
+    }
+    byte(0xE8);
+    fixups.push_back({bytes.size(), JIT_ENTRY_PREFIX + name});
+    word(0);
+}
+
+// call_at(addr)
+//
+// Calls the code at `addr`. It is called with an absolute address, as
+// it may well lie beyond a 32-bit displacement.
+//
+void Jit_code::call_at(unsigned long addr) {
+    byte(0x48); byte(0xB8);                         // movabsq $addr,%rax
+    for (int i = 0; i < 8; i++) {
+        byte((addr >> (8*i)) & 0xFF);
+    }
+    byte(0xFF); byte(0xD0);                         // call *%rax
+}
+
+void Jit_code::fail(int cc) {
+    if (cc == CC_ALWAYS) {
+        byte(0xE9);
+    } else {
+        byte(0x0F);
+        byte(0x80 | cc);
+    }
+    fixups.push_back({bytes.size(), JIT_FAIL_LABEL});
+    word(0);
+}
+
+void Jit_code::label(const std::string& lbl) {
+    labels[scope + "/" + lbl] = bytes.size();
+}
+
+// entry(name)
+//
+// Starts the code of the definition `name`, at its entry point.
+//
+void Jit_code::entry(const std::string& name) {
+    scope = name;
+    labels[JIT_ENTRY_PREFIX + name] = bytes.size();
+}
+
+size_t Jit_code::entry_offset(const std::string& name) const {
+    return labels.at(JIT_ENTRY_PREFIX + name);
+}
+
+// fail_stub(handler)
+//
+// The code that each `fail` jumps to, which calls `handler` to give
+// up.
+//
+void Jit_code::fail_stub(void (*handler)(void)) {
+    labels[JIT_FAIL_LABEL] = bytes.size();
+    call_at(reinterpret_cast<unsigned long>(handler));
+}
+
+// link()
+//
+// Patches each jump and call with the displacement to its label.
+// Reports whether all the code was encoded and every label it targets
+// was defined.
+//
+bool Jit_code::link(void) {
+    if (!supported) {
+        return false;
+    }
+    for (const std::pair<size_t,std::string>& fixup : fixups) {
+        if (labels.count(fixup.second) == 0) {
+            return false;
+        }
+        int disp = (int)labels.at(fixup.second) - (int)(fixup.first + 4);
+        std::memcpy(&bytes[fixup.first], &disp, 4);
+    }
+    return true;
+}
+
+//
+// * * * * *
+//
+// INST::toJIT
+//
+// Each encodes its instruction just as its `toX86` assembles it, noted
+// alongside in GNU assembler syntax. A division also checks for a zero
+// divisor, giving up if so. The instructions that do I/O, or work with
+// strings, are left out of any definition that is compiled; they
+// instead mark the code as unsupported.
+//
+
+void ENTER::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit.byte(0x55);                                 // pushq %rbp
+    jit.byte(0x48); jit.byte(0x89); jit.byte(0xE5); // movq %rsp,%rbp
+    jit.byte(0x48); jit.byte(0x81); jit.byte(0xEC); // subq $size,%rsp
+    jit.word(symt.get_frame_size());
+    for (unsigned int argi = 0; argi < symt.get_frmls_size(); argi++) {
+        std::string pram = symt.get_frml(argi)->name;
+        int reg = jit_arg_regs[argi];
+        jit.byte(rex_w(reg)); jit.byte(0x89);       // movq %reg,pram
+        jit.slot(reg,symt,pram);
+    }
+}
+//
+void LEAVE::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.byte(0xC9);                                 // leave
+    jit.byte(0xC3);                                 // ret
+}
+//
+void SET::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit.byte(0x48); jit.byte(0xC7);                 // movq $val,dst
+    jit.slot(0,symt,dst);
+    jit.word(val);
+}
+//
+void STL::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.supported = false;
+}
+//
+void MOV::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit.byte(0x48); jit.byte(0x8B);                 // movq src,%rax
+    jit.slot(RAX,symt,src);
+    jit.byte(0x48); jit.byte(0x89);                 // movq %rax,dst
+    jit.slot(RAX,symt,dst);
+}
+//
+void RTV::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit.byte(0x48); jit.byte(0x89);                 // movq %rax,dst
+    jit.slot(RAX,symt,dst);
+}
+//
+void GTI::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.supported = false;
+}
+//
+void NOP::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.byte(0x90);                                 // nop
+}
+//
+void PTI::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.supported = false;
+}
+//
+void PTS::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.supported = false;
+}
+//
+void RDC::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.supported = false;
+}
+//
+// jit_arith(jit,symt,opcode,dst,src1,src2)
+//
+// An int operation of `src1` by `src2` into `dst`, as with ADD.
+//
+static void jit_arith(Jit_code& jit, const SymT& symt,
+                      std::vector<int> opcode, const std::string& dst,
+                      const std::string& src1, const std::string& src2) {
+    jit.byte(0x8B);                                 // movl src1,%eax
+    jit.slot(RAX,symt,src1);
+    for (int b : opcode) {                          // opl src2,%eax
+        jit.byte(b);
+    }
+    jit.slot(RAX,symt,src2);
+    jit.byte(0x48); jit.byte(0x98);                 // cltq
+    jit.byte(0x48); jit.byte(0x89);                 // movq %rax,dst
+    jit.slot(RAX,symt,dst);
+}
+//
+void ADD::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit_arith(jit,symt,{0x03},dst,src1,src2);
+}
+//
+void SUB::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit_arith(jit,symt,{0x2B},dst,src1,src2);
+}
+//
+void MLT::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit_arith(jit,symt,{0x0F,0xAF},dst,src1,src2);
+}
+//
+// jit_divide(jit,symt,src1,src2)
+//
+// Divides `src1` by `src2`, leaving the quotient in %eax and the
+// remainder in %edx, or gives up if `src2` is 0.
+//
+static void jit_divide(Jit_code& jit, const SymT& symt,
+                       const std::string& src1, const std::string& src2) {
+    jit.byte(0x83);                                 // cmpl $0,src2
+    jit.slot(7,symt,src2);
+    jit.byte(0x00);
+    jit.fail(CC_E);                                 // je fail
+    jit.byte(0x8B);                                 // movl src1,%eax
+    jit.slot(RAX,symt,src1);
+    jit.byte(0x99);                                 // cltd
+    jit.byte(0xF7);                                 // idivl src2
+    jit.slot(7,symt,src2);
+}
+//
+void DIV::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit_divide(jit,symt,src1,src2);
+    jit.byte(0x48); jit.byte(0x98);                 // cltq
+    jit.byte(0x48); jit.byte(0x89);                 // movq %rax,dst
+    jit.slot(RAX,symt,dst);
+}
+//
+void MOD::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit_divide(jit,symt,src1,src2);
+    jit.byte(0x48); jit.byte(0x63); jit.byte(0xD2); // movslq %edx,%rdx
+    jit.byte(0x48); jit.byte(0x89);                 // movq %rdx,dst
+    jit.slot(RDX,symt,dst);
+}
+//
+void RTN::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit.byte(0x48); jit.byte(0x8B);                 // movq src,%rax
+    jit.slot(RAX,symt,src);
+}
+//
+void BCN::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit.byte(0x8B);                                 // movl src1,%eax
+    jit.slot(RAX,symt,src1);
+    jit.byte(0x3B);                                 // cmpl src2,%eax
+    jit.slot(RAX,symt,src2);
+    jit.branch(jit_cc(cndn),lblt);                  // jcc lblt
+    jit.jump(lblf);                                 // jmp lblf
+}
+//
+void BCZ::toJIT(Jit_code& jit, const SymT& symt) const {
+    jit.byte(0x83);                                 // cmpl $0,src
+    jit.slot(7,symt,src);
+    jit.byte(0x00);
+    jit.branch(jit_cc(cndn),lblt);                  // jcc lblt
+    jit.jump(lblf);                                 // jmp lblf
+}
+//
+void JMP::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.jump(lbl);                                  // jmp lbl
+}
+//
+void CLL::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.call(lbl);                                  // call lbl
+}
+//
+void LBL::toJIT(Jit_code& jit, [[maybe_unused]] const SymT& symt) const {
+    jit.label(lbl);
+}
+//
+void CMT::toJIT([[maybe_unused]] Jit_code& jit,
+                [[maybe_unused]] const SymT& symt) const {
+}
+//
+void ARG::toJIT(Jit_code& jit, const SymT& symt) const {
+    int reg = jit_arg_regs[idx];
+    jit.byte(rex_w(reg)); jit.byte(0x8B);           // movq src,%reg
+    jit.slot(reg,symt,src);
+}
+
+//
+// * * * * *
+//
+// Choosing what to compile
+//
+// A definition is compiled only when its native code would do just
+// what the interpreter does. This is checked on its AST, by walking
+// its statements and expressions while tracking the set of variables
+// that are sure to have been set (rather than the interpreter's
+// run-time check). Each call adds its callee to the `unit` compiled
+// with the definition.
+//
+
+static bool jit_defn(Defn* defn, std::vector<Defn*>& unit);
+static bool jit_value(const Expn_ptr& expn,
+                      const std::set<Name>& set, std::vector<Defn*>& unit);
+
+// jit_scalar(type)
+//
+// Whether values of `type` are held natively: ints and bools.
+//
+static bool jit_scalar(const Type& type) {
+    return std::holds_alternative<IntTy>(type)
+        || std::holds_alternative<BoolTy>(type);
+}
+
+static bool jit_int(const Expn_ptr& expn) {
+    return std::holds_alternative<IntTy>(expn->type);
+}
+
+// jit_args(defn,args,set,unit)
+//
+// Whether a call to `defn` with `args` can be compiled.
+//
+static bool jit_args(Defn* defn, const Expn_vec& args,
+                     const std::set<Name>& set, std::vector<Defn*>& unit) {
+    if (defn == nullptr || args.size() != defn->arity()) {
+        return false;
+    }
+    for (const Expn_ptr& arg : args) {
+        if (!jit_value(arg,set,unit)) {
+            return false;
+        }
+    }
+    return jit_defn(defn,unit);
+}
+
+// jit_cndn(expn,set,unit)
+//
+// Whether `expn` can be compiled as a condition, with `trans_cndn`.
+//
+static bool jit_cndn(const Expn_ptr& expn,
+                     const std::set<Name>& set, std::vector<Defn*>& unit) {
+    if (Ltrl* ltrl = dynamic_cast<Ltrl*>(expn.get())) {
+        return std::holds_alternative<bool>(ltrl->valu);
+    }
+    if (Lkup* lkup = dynamic_cast<Lkup*>(expn.get())) {
+        return std::holds_alternative<BoolTy>(lkup->type)
+            && set.count(lkup->name) > 0;
+    }
+    if (Less* less = dynamic_cast<Less*>(expn.get())) {
+        return jit_int(less->left) && jit_int(less->rght)
+            && jit_value(less->left,set,unit)
+            && jit_value(less->rght,set,unit);
+    }
+    if (LtEq* lteq = dynamic_cast<LtEq*>(expn.get())) {
+        return jit_int(lteq->left) && jit_int(lteq->rght)
+            && jit_value(lteq->left,set,unit)
+            && jit_value(lteq->rght,set,unit);
+    }
+    if (Eqal* eqal = dynamic_cast<Eqal*>(expn.get())) {
+        return jit_int(eqal->left) && jit_int(eqal->rght)
+            && jit_value(eqal->left,set,unit)
+            && jit_value(eqal->rght,set,unit);
+    }
+    if (Conj* conj = dynamic_cast<Conj*>(expn.get())) {
+        return jit_cndn(conj->left,set,unit) && jit_cndn(conj->rght,set,unit);
+    }
+    if (Disj* disj = dynamic_cast<Disj*>(expn.get())) {
+        return jit_cndn(disj->left,set,unit) && jit_cndn(disj->rght,set,unit);
+    }
+    if (Negt* negt = dynamic_cast<Negt*>(expn.get())) {
+        return jit_cndn(negt->expn,set,unit);
+    }
+    if (dynamic_cast<Func*>(expn.get())) {
+        return jit_value(expn,set,unit);
+    }
+    return false;
+}
+
+// jit_oper<Oper>(expn,set,unit)
+//
+// Whether `expn` is an int operation whose operands can be compiled.
+//
+template<class Oper>
+static bool jit_oper(const Expn_ptr& expn,
+                     const std::set<Name>& set, std::vector<Defn*>& unit) {
+    Oper* oper = dynamic_cast<Oper*>(expn.get());
+    return oper != nullptr
+        && jit_int(expn) && jit_int(oper->left) && jit_int(oper->rght)
+        && jit_value(oper->left,set,unit) && jit_value(oper->rght,set,unit);
+}
+
+// jit_value(expn,set,unit)
+//
+// Whether `expn` can be compiled for its value, with `trans`.
+//
+static bool jit_value(const Expn_ptr& expn,
+                      const std::set<Name>& set, std::vector<Defn*>& unit) {
+    if (Ltrl* ltrl = dynamic_cast<Ltrl*>(expn.get())) {
+        return std::holds_alternative<int>(ltrl->valu)
+            || std::holds_alternative<bool>(ltrl->valu);
+    }
+    if (Lkup* lkup = dynamic_cast<Lkup*>(expn.get())) {
+        return jit_scalar(lkup->type) && set.count(lkup->name) > 0;
+    }
+    if (Func* func = dynamic_cast<Func*>(expn.get())) {
+        return jit_scalar(func->type)
+            && jit_args(func->defn,func->args,set,unit);
+    }
+    if (dynamic_cast<Less*>(expn.get())
+        || dynamic_cast<LtEq*>(expn.get())
+        || dynamic_cast<Eqal*>(expn.get())
+        || dynamic_cast<Conj*>(expn.get())
+        || dynamic_cast<Disj*>(expn.get())
+        || dynamic_cast<Negt*>(expn.get())) {
+        return jit_cndn(expn,set,unit);
+    }
+    return jit_oper<Plus>(expn,set,unit)
+        || jit_oper<Mnus>(expn,set,unit)
+        || jit_oper<Tmes>(expn,set,unit)
+        || jit_oper<IDiv>(expn,set,unit)
+        || jit_oper<IMod>(expn,set,unit);
+}
+
+// jit_assign(defn,name,expn,set,unit)
+//
+// Whether setting variable `name` to `expn` can be compiled, where
+// its value has the type the variable has throughout.
+//
+static bool jit_assign(Defn* defn, const Name& name, const Expn_ptr& expn,
+                       std::set<Name>& set, std::vector<Defn*>& unit) {
+    if (!defn->symt.has_info(name)) {
+        return false;
+    }
+    Type type = defn->symt.get_info(name)->type;
+    if (!jit_scalar(type) || type.index() != expn->type.index()
+        || !jit_value(expn,set,unit)) {
+        return false;
+    }
+    set.insert(name);
+    return true;
+}
+
+// jit_update(defn,name,expn,set,unit)
+//
+// Whether updating int variable `name` by `expn` can be compiled.
+//
+static bool jit_update(Defn* defn, const Name& name, const Expn_ptr& expn,
+                       std::set<Name>& set, std::vector<Defn*>& unit) {
+    return set.count(name) > 0
+        && std::holds_alternative<IntTy>(defn->symt.get_info(name)->type)
+        && jit_int(expn) && jit_value(expn,set,unit);
+}
+
+static bool jit_blck(Defn* defn, const Blck_ptr& blck,
+                     std::set<Name>& set, std::vector<Defn*>& unit);
+
+// jit_stmt(defn,stmt,set,unit)
+//
+// Whether `stmt` in the body of `defn` can be compiled, adding to
+// `set` the variables it is sure to set.
+//
+static bool jit_stmt(Defn* defn, const Stmt_ptr& stmt,
+                     std::set<Name>& set, std::vector<Defn*>& unit) {
+    if (Ntro* ntro = dynamic_cast<Ntro*>(stmt.get())) {
+        return ntro->type.index() == ntro->expn->type.index()
+            && jit_assign(defn,ntro->name,ntro->expn,set,unit);
+    }
+    if (Asgn* asgn = dynamic_cast<Asgn*>(stmt.get())) {
+        return jit_assign(defn,asgn->name,asgn->expn,set,unit);
+    }
+    if (PlEq* pleq = dynamic_cast<PlEq*>(stmt.get())) {
+        return jit_update(defn,pleq->name,pleq->expn,set,unit);
+    }
+    if (MiEq* mieq = dynamic_cast<MiEq*>(stmt.get())) {
+        return jit_update(defn,mieq->name,mieq->expn,set,unit);
+    }
+    if (TiEq* tieq = dynamic_cast<TiEq*>(stmt.get())) {
+        return jit_update(defn,tieq->name,tieq->expn,set,unit);
+    }
+    if (dynamic_cast<Pass*>(stmt.get())) {
+        return true;
+    }
+    if (Whle* whle = dynamic_cast<Whle*>(stmt.get())) {
+        //
+        // The loop's body might not run, so what it sets isn't sure.
+        //
+        std::set<Name> body_set = set;
+        return jit_cndn(whle->expn,set,unit)
+            && jit_blck(defn,whle->blck,body_set,unit);
+    }
+    if (Tern* tern = dynamic_cast<Tern*>(stmt.get())) {
+        std::set<Name> if_set = set;
+        std::set<Name> else_set = set;
+        if (!jit_cndn(tern->expn,set,unit)
+            || !jit_blck(defn,tern->if_blck,if_set,unit)
+            || !jit_blck(defn,tern->else_blck,else_set,unit)) {
+            return false;
+        }
+        for (const Name& name : if_set) {
+            if (else_set.count(name) > 0) {
+                set.insert(name);
+            }
+        }
+        return true;
+    }
+    if (RetE* rete = dynamic_cast<RetE*>(stmt.get())) {
+        return rete->expn->type.index() == defn->rety.index()
+            && jit_value(rete->expn,set,unit);
+    }
+    if (Proc* proc = dynamic_cast<Proc*>(stmt.get())) {
+        return jit_args(proc->defn,proc->args,set,unit);
+    }
+    return false;
+}
+
+static bool jit_blck(Defn* defn, const Blck_ptr& blck,
+                     std::set<Name>& set, std::vector<Defn*>& unit) {
+    for (const Stmt_ptr& stmt : blck->stmts) {
+        if (!jit_stmt(defn,stmt,set,unit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// jit_defn(defn,unit)
+//
+// Whether `defn` can be compiled, along with the definitions it
+// calls, which are added to `unit`. A definition already in `unit` is
+// taken to be fine while it is being checked, so that recursion can be
+// compiled; if it turns out not to be, the whole unit is rejected. One
+// that was compiled earlier is added as it is, to be called there.
+//
+static bool jit_defn(Defn* defn, std::vector<Defn*>& unit) {
+    for (Defn* other : unit) {
+        if (other == defn) {
+            return true;
+        }
+    }
+    if (defn->native != nullptr) {
+        unit.push_back(defn);
+        return true;
+    }
+    if (defn->jit_never || !defn->pure
+        || defn->arity() > JIT_MAX_ARGS || !jit_scalar(defn->rety)) {
+        return false;
+    }
+    unit.push_back(defn);
+    std::set<Name> set {};
+    for (unsigned int i = 0; i < defn->arity(); i++) {
+        SymInfo_ptr frml = defn->formal(i);
+        if (!jit_scalar(frml->type)) {
+            return false;
+        }
+        set.insert(frml->name);
+    }
+    return jit_blck(defn,defn->blck,set,unit);
+}
+
+//
+// * * * * *
+//
+// Jit
+//
+
+size_t Jit::threshold = 0;
+
+// Where the native code gives up, for `Jit::call` to run the call by
+// interpreting it instead.
+static std::jmp_buf jit_fail_env;
+
+[[noreturn]] static void jit_fail(void) {
+    std::longjmp(jit_fail_env,1);
+}
+
+// compile(defn)
+//
+// Compiles `defn`, and every definition it calls that isn't compiled
+// already, into one region of executable memory, setting each one's
+// `native` entry point. If `defn` can't be compiled, it is marked
+// `jit_never`. A region is never freed, as the later ones may call
+// into it.
+//
+bool Jit::compile(Defn& defn) {
+    std::vector<Defn*> unit {};
+    if (!JIT_NATIVE || !jit_defn(&defn,unit)) {
+        defn.jit_never = true;
+        return false;
+    }
+
+    //
+    // Translate each into IR as `Defn::trans` does, but into copies of
+    // its symbol table and code, then encode that with the same frame
+    // layout as `Prgm::compile_x86`. Falling off the end of the body
+    // gives up, as the interpreter reports no value being returned.
+    //
+    Jit_code jit {};
+    for (Defn* def : unit) {
+        if (def->native != nullptr) {
+            jit.natives[def->name] = def->native;
+        }
+    }
+    for (Defn* def : unit) {
+        if (def->native != nullptr) {
+            continue;
+        }
+        SymT symt = def->symt;
+        INST_vec code {};
+        std::string ext_lbl = symt.add_labl(def->name+"_done");
+        code.push_back(INST_ptr { new ENTER {} });
+        def->blck->trans(ext_lbl,symt,code);
+        layout_frame_x86(symt);
+        jit.entry(def->name);
+        for (INST_ptr inst : code) {
+            inst->toJIT(jit,symt);
+        }
+        jit.fail(CC_ALWAYS);
+        LBL {ext_lbl}.toJIT(jit,symt);
+        LEAVE {}.toJIT(jit,symt);
+    }
+    jit.fail_stub(&jit_fail);
+    if (!jit.link()) {
+        defn.jit_never = true;
+        return false;
+    }
+
+#if JIT_NATIVE
+    //
+    // Place it, then make it executable rather than writable.
+    //
+    size_t size = jit.bytes.size();
+    void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        defn.jit_never = true;
+        return false;
+    }
+    std::memcpy(region, jit.bytes.data(), size);
+    if (mprotect(region, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(region, size);
+        defn.jit_never = true;
+        return false;
+    }
+    unsigned char* code = static_cast<unsigned char*>(region);
+    for (Defn* def : unit) {
+        if (jit.natives.count(def->name) == 0) {
+            def->native = reinterpret_cast<Native_fn>(code + jit.entry_offset(def->name));
+        }
+    }
+#endif
+    return true;
+}
+
+// call(defn,locals,rslt)
+//
+// Runs the native code of `defn` on the values of its parameters in
+// `locals`, setting `rslt` to the value it returns. Reports whether it
+// ran; if it gave up, or the arguments are not of the types it was
+// compiled for, the call must be interpreted instead.
+//
+bool Jit::call(Defn& defn, const Ctxt& locals, Valu& rslt) {
+    long args[JIT_MAX_ARGS] = {0, 0, 0, 0, 0, 0};
+    for (unsigned int i = 0; i < defn.arity(); i++) {
+        SymInfo_ptr frml = defn.formal(i);
+        const Valu& valu = locals.at(frml->name);
+        if (std::holds_alternative<IntTy>(frml->type)
+            && std::holds_alternative<int>(valu)) {
+            args[i] = std::get<int>(valu);
+        } else if (std::holds_alternative<BoolTy>(frml->type)
+                   && std::holds_alternative<bool>(valu)) {
+            args[i] = std::get<bool>(valu);
+        } else {
+            return false;
+        }
+    }
+    if (setjmp(jit_fail_env) != 0) {
+        return false;
+    }
+    long value = defn.native(args[0],args[1],args[2],args[3],args[4],args[5]);
+    if (std::holds_alternative<BoolTy>(defn.rety)) {
+        rslt = Valu {value != 0};
+    } else {
+        rslt = Valu {(int)value};
+    }
+    return true;
+}
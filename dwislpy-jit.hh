@@ -0,0 +1,93 @@
+#ifndef _DWISLPY_JIT_HH
+#define _DWISLPY_JIT_HH
+
+//
+// dwislpy-jit.hh
+//
+// A tiering JIT for the AST interpreter, `Prgm::run`. Each call of a
+// definition is counted by `Defn::exec_body` and, once a definition
+// has been called `Jit::threshold` times, its IR (from the `trans`
+// methods) is compiled to x86-64 machine code in executable memory.
+// Its later calls then run that code rather than walking its body.
+//
+// Only a definition whose code is simple enough to behave the same
+// natively is compiled (see `Jit::compile` in dwislpy-jit.cc):
+//
+//  * it is `pure` and all its values are ints and bools, so that no
+//    string, `input`, `print`, or `perf` is involved, and it takes at
+//    most six parameters,
+//  * its variables are each given one type, and each is set before it
+//    is used, and
+//  * the definitions it calls are compiled along with it, or were
+//    compiled earlier, in which case they are called where they are.
+//
+// Anything else stays interpreted. The native code follows the same
+// frame layout as `Prgm::compile_x86`, with each INST encoded by its
+// `toJIT` method.
+//
+// A native call that would raise a run-time error (division by 0, or
+// no value returned) instead gives up, and the call is then run again
+// by the interpreter, which reports the error as it always would. A
+// pure call can be run twice with no difference to the program.
+//
+// Profiling and tracing turn tiering off, as does the closure engine.
+// Statements run natively are not counted in `Perf::statements`.
+//
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include "dwislpy-ast.hh"
+
+#define JIT_THRESHOLD 100 // Calls before a definition is compiled, by default.
+
+//
+// class Jit_code
+//
+// x86-64 machine code as it is encoded, before it is placed in
+// executable memory. Labels are resolved once all the code is in: each
+// jump or call to a label leaves a 32-bit displacement to be patched.
+// A definition's labels are scoped by its name. `SymT::add_labl`
+// numbers IR labels program-wide through the global table, but the JIT
+// translates into a copy of a definition's table, and one not yet
+// given that table by `Prgm::trans` numbers its labels by itself.
+//
+class Jit_code {
+public:
+    std::vector<unsigned char> bytes;
+    std::string scope;     // The definition being encoded.
+    bool supported = true; // => every INST could be encoded.
+    std::unordered_map<std::string,Native_fn> natives; // Compiled earlier.
+    //
+    void byte(int b);
+    void word(int w);
+    void slot(int reg, const SymT& symt, const std::string& name);
+    void jump(const std::string& lbl);               // To a label in scope.
+    void branch(int cc, const std::string& lbl);     // A `jcc` to one.
+    void call(const std::string& name);              // To a definition.
+    void call_at(unsigned long addr);                // To an address.
+    void fail(int cc);                               // A `jcc` to give up.
+    void fail_stub(void (*handler)(void));
+    void label(const std::string& lbl);
+    void entry(const std::string& name);
+    bool link(void);
+    size_t entry_offset(const std::string& name) const;
+private:
+    std::unordered_map<std::string,size_t> labels;
+    std::vector<std::pair<size_t,std::string>> fixups;
+};
+
+//
+// class Jit
+//
+// The tiering policy, and the native code's entry point.
+//
+class Jit {
+public:
+    static size_t threshold; // Calls before compiling; 0 => never.
+    static bool compile(Defn& defn);
+    static bool call(Defn& defn, const Ctxt& locals, Valu& rslt);
+};
+
+#endif
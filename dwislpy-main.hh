@@ -24,10 +24,14 @@
 
 #include <string>
 #include <istream>
+#include <ostream>
 
 #include "dwislpy-flex.hh"
 #include "dwislpy-bison.tab.hh"
 
+class Prof;
+struct trace_ring;
+
 typedef std::shared_ptr<DWISLPY::Lexer> Lexer_ptr;
 typedef std::shared_ptr<DWISLPY::Parser> Parser_ptr;
 typedef std::shared_ptr<std::istream> istream_ptr;
@@ -41,7 +45,15 @@ typedef std::shared_ptr<std::istream> istream_ptr;
  * The methods it provides are:
  *   parse - runs the parser, building the AST
  *   set - sets the AST that results from a parse
- *   run - executes the parsed DwiDlpy program
+ *   run - executes the parsed DwiDlpy program (set `memoizing` to
+ *         cache the results of pure functions, `profiling` to report
+ *         where its time was spent, `tracing` to record a trace,
+ *         `closures` to run it as compiled closures, `jit_threshold`
+ *         to compile each hot pure definition to machine code, `ir`
+ *         to run its IR on a virtual machine)
+ *   check - checks the program's types and builds its symbol tables
+ *   compile - outputs MIPS code to `foo.s` (or to a given stream)
+ *   compile_x86 - outputs x86-64 code to `foo.x86.s` (or to a stream)
  *   dump - (pretty) prints the AST
  *
  * Note that the constructor attempts to create a stream attached to
@@ -58,14 +70,24 @@ namespace DWISLPY {
         void run(void);
         void check(void);
         void compile(void);
+        void compile(std::ostream& os);
+        void compile_x86(void);
+        void compile_x86(std::ostream& os);
         void dump(bool pretty);
         void set(Prgm_ptr prgm) { program = prgm; }
         std::string src_name;
+        bool memoizing = false;
+        bool profiling = false;
+        bool tracing = false;
+        bool closures = false;
+        size_t jit_threshold = 0;
+        bool ir = false;
     private:
         istream_ptr src_stream = nullptr;
         Prgm_ptr    program = nullptr;
         Lexer_ptr   lexer = nullptr;
         Parser_ptr  parser  = nullptr;
+        void finish_run(const Prof& prof, trace_ring& ring);
     };
 
 }
@@ -59,7 +59,15 @@ void compile_defn(std::ostream& os, SymT& symt, INST_vec& code) {
         symt.set_frame_offset(frml,i*4);
     }
 
-    int offset = -4;
+    // Saved registers sit at the top of the frame, at fixed offsets
+    // from $fp, so that a debugger or profiler can walk the chain of
+    // frames without knowing each function's layout.
+    std::string ra = symt.add_locl(RETURN_ADDRESS, IntTy {}); // Not really an integer.
+    std::string fp = symt.add_locl(FRAME_POINTER, IntTy {});  // Not really an integer.
+    symt.set_frame_offset(ra,-4);
+    symt.set_frame_offset(fp,-8);
+
+    int offset = -12;
         
     // Locals sit next.
     for (int i = 0; i < num_locls; i++) {
@@ -68,14 +76,6 @@ void compile_defn(std::ostream& os, SymT& symt, INST_vec& code) {
         offset -= 4;
     }
 
-    // Saved registers sit next.
-    std::string ra = symt.add_locl(RETURN_ADDRESS, IntTy {}); // Not really an integer.
-    std::string fp = symt.add_locl(FRAME_POINTER, IntTy {});  // Not really an integer.
-    symt.set_frame_offset(ra,offset);
-    offset -= 4;
-    symt.set_frame_offset(fp,offset);
-    offset -= 4;
-
     // Possible arguments to calls sit last.
     
     symt.set_frame_size(frame_size);
@@ -111,14 +111,15 @@ void Prgm::compile(std::ostream& os) {
         os << "\t.asciiz " << strg << std::endl;
     }
     
-    // Generate the `.text` section filled with `main` and each `def`'s
-    // (labelled) code.
+    // Generate the `.text` section filled with `main` and each live
+    // `def`'s (labelled) code.
     //
     os << "\t.text" << std::endl;
     os << "\t.globl main" << std::endl;
     compile_defn(os,main_symt,main_code);
     for (std::pair<Name,Defn_ptr> dfpr : defs) {
         Defn_ptr defn = dfpr.second;
+        if (!defn->live) continue;
         compile_defn(os,defn->symt,defn->code);
     }
 }
@@ -204,6 +205,13 @@ void PTS::toMIPS(std::ostream& os, const SymT& symt) const {
     os << "\t" << "syscall" << std::endl;
 }
 //
+void RDC::toMIPS(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "lw $a0," << symt.get_frame_offset(src) << "($fp)" << std::endl;
+    os << "\t" << "li $v0,18" << std::endl;
+    os << "\t" << "syscall" << std::endl;
+    os << "\t" << "sw $v0," << symt.get_frame_offset(dst) << "($fp)" << std::endl;
+}
+//
 void ADD::toMIPS(std::ostream& os, const SymT& symt) const {
     os << "\t" << "lw $t1," << symt.get_frame_offset(src1) << "($fp)" << std::endl;
     os << "\t" << "lw $t2," << symt.get_frame_offset(src2) << "($fp)" << std::endl;
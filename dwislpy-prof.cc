@@ -0,0 +1,184 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+
+#include "dwislpy-ast.hh"
+#include "dwislpy-util.hh"
+#include "dwislpy-prof.hh"
+
+//
+// dwislpy-prof.cc
+//
+// The profiler for `dwislpyc --profile`. See dwislpy-prof.hh.
+//
+
+Prof* Prof::active = nullptr;
+
+Prof::Prof(void) :
+    entries {}, entry_of {}, paths {}, path_of {}, stack {},
+    epoch {Clock::now()}
+{
+    // Path 0 is the root of every stack: the main script.
+    paths.push_back(Path {0, 0, 0});
+}
+
+int64_t Prof::now_ns(void) const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - epoch).count();
+}
+
+// entry_for
+//
+// Finds the entry for a statement or definition, making one the first
+// time it is seen.
+//
+size_t Prof::entry_for(const AST& node, std::string name) {
+    auto found = entry_of.find(&node);
+    if (found != entry_of.end()) {
+        return found->second;
+    }
+    size_t entry = entries.size();
+    entries.push_back(Entry {node.where(), name, 0, 0, 0, 0});
+    entry_of[&node] = entry;
+    return entry;
+}
+
+void Prof::enter(const Stmt& stmt) {
+    push(entry_for(stmt,""));
+}
+
+void Prof::enter(const Defn& defn) {
+    push(entry_for(defn,defn.name));
+}
+
+void Prof::push(size_t entry) {
+    size_t parent = stack.empty() ? 0 : stack.back().path;
+    uint64_t key = (static_cast<uint64_t>(parent) << 32) | entry;
+    auto found = path_of.find(key);
+    size_t path;
+    if (found != path_of.end()) {
+        path = found->second;
+    } else {
+        path = paths.size();
+        paths.push_back(Path {parent, entry, 0});
+        path_of[key] = path;
+    }
+    entries[entry].count++;
+    entries[entry].active++;
+    stack.push_back(Frame {entry, path, now_ns(), 0});
+}
+
+void Prof::leave(void) {
+    Frame frame = stack.back();
+    stack.pop_back();
+    int64_t elapsed = now_ns() - frame.start_ns;
+    int64_t exclusive = elapsed - frame.child_ns;
+    Entry& e = entries[frame.entry];
+    e.excl_ns += exclusive;
+    paths[frame.path].excl_ns += exclusive;
+    // Only the outermost of a recursion's frames counts as inclusive.
+    e.active--;
+    if (e.active == 0) {
+        e.incl_ns += elapsed;
+    }
+    if (!stack.empty()) {
+        stack.back().child_ns += elapsed;
+    }
+}
+
+std::string Prof::frame_name(size_t entry) const {
+    const Entry& e = entries[entry];
+    if (e.name != "") {
+        return e.name;
+    }
+    std::string file = e.locn.source_name;
+    size_t slash = file.find_last_of("/");
+    if (slash != std::string::npos) {
+        file = file.substr(slash+1);
+    }
+    return file + ":" + std::to_string(e.locn.line);
+}
+
+// source_lines
+//
+// Reads a source file's lines so that the report can show them.
+//
+static std::vector<std::string> source_lines(std::string filename) {
+    std::vector<std::string> lines {};
+    std::ifstream in {filename};
+    std::string line;
+    while (std::getline(in,line)) {
+        size_t first = line.find_first_not_of(" \t");
+        lines.push_back(first == std::string::npos ? "" : line.substr(first));
+    }
+    return lines;
+}
+
+// report
+//
+// Lists the entries with the most exclusive time first, along with the
+// source line each came from.
+//
+void Prof::report(std::ostream& os) const {
+    std::vector<size_t> order {};
+    int64_t total_ns = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        order.push_back(i);
+        total_ns += entries[i].excl_ns;
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return entries[a].excl_ns > entries[b].excl_ns;
+    });
+
+    std::map<std::string,std::vector<std::string>> sources {};
+    char line[256];
+    snprintf(line, sizeof(line), "%12s %11s %11s %6s  %-16s %s",
+             "count", "incl ms", "excl ms", "excl%", "location", "source");
+    os << line << std::endl;
+    for (size_t i : order) {
+        const Entry& e = entries[i];
+        if (sources.count(e.locn.source_name) == 0) {
+            sources[e.locn.source_name] = source_lines(e.locn.source_name);
+        }
+        const std::vector<std::string>& text = sources[e.locn.source_name];
+        std::string src = "";
+        if (e.locn.line >= 1 && static_cast<size_t>(e.locn.line) <= text.size()) {
+            src = text[e.locn.line-1];
+        }
+        std::string where = frame_name(i);
+        if (e.name != "") {
+            where = "def " + where;
+        }
+        double percent = total_ns > 0 ? 100.0 * e.excl_ns / total_ns : 0.0;
+        snprintf(line, sizeof(line), "%12lld %11.3f %11.3f %5.1f%%  %-16s ",
+                 static_cast<long long>(e.count), e.incl_ns / 1e6,
+                 e.excl_ns / 1e6, percent, where.c_str());
+        os << line << src << std::endl;
+    }
+}
+
+// write_folded
+//
+// Writes one line per call stack seen, giving its frames from the
+// root and its exclusive time in microseconds.
+//
+void Prof::write_folded(std::ostream& os) const {
+    for (size_t p = 1; p < paths.size(); p++) {
+        int64_t us = paths[p].excl_ns / 1000;
+        if (us == 0) continue;
+        std::vector<size_t> frames {};
+        for (size_t q = p; q != 0; q = paths[q].parent) {
+            frames.push_back(paths[q].entry);
+        }
+        os << "main";
+        for (auto f = frames.rbegin(); f != frames.rend(); f++) {
+            os << ";" << frame_name(*f);
+        }
+        os << " " << us << std::endl;
+    }
+}
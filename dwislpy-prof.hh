@@ -0,0 +1,112 @@
+#ifndef _DWISLPY_PROF_H
+#define _DWISLPY_PROF_H
+
+//
+// dwislpy-prof.hh
+//
+// Defines `Prof`, the hot-spot profiler used by `dwislpyc --profile`.
+//
+// While a profile is being taken, `Blck::exec` brackets each statement
+// it executes, and `Defn::call` brackets each call's body, with a
+// `Prof_scope`. For each statement and definition this counts how often
+// it was executed and accumulates
+//
+//   * its inclusive time - the time spent within it, including the
+//     statements and calls it executes (counted once for recursion),
+//   * its exclusive time - the time spent within it, excluding them.
+//
+// Entries are reported by their `AST::where()` location. The time is
+// also accumulated per call stack, so that it can be written in the
+// "collapsed stack" format read by flamegraph tools, e.g.
+//
+//     main;fib.slpy:9;fib;fib.slpy:5;fib 1234
+//
+// where each frame is a definition's name or a statement's line, and
+// the count is exclusive time in microseconds.
+//
+// When no profile is being taken `Prof::active` is null, and each
+// `Prof_scope` costs just that test.
+//
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "dwislpy-ast.hh"
+#include "dwislpy-util.hh"
+
+class Prof {
+public:
+    //
+    static Prof* active; // The profile being taken, if any.
+    //
+    Prof(void);
+    void enter(const Stmt& stmt);
+    void enter(const Defn& defn);
+    void leave(void);
+    //
+    void report(std::ostream& os) const;
+    void write_folded(std::ostream& os) const;
+    //
+private:
+    typedef std::chrono::steady_clock Clock;
+    //
+    struct Entry {
+        Locn        locn;    // Where the statement or definition is.
+        std::string name;    // A definition's name, or "" for a statement.
+        int64_t     count;   // Number of times it was entered.
+        int64_t     incl_ns; // Inclusive time.
+        int64_t     excl_ns; // Exclusive time.
+        int         active;  // Number of its frames on the stack.
+    };
+    struct Path {
+        size_t      parent;  // The calling path (0 is the root, `main`).
+        size_t      entry;   // The entry at the top of this path.
+        int64_t     excl_ns; // Exclusive time spent with this stack.
+    };
+    struct Frame {
+        size_t      entry;
+        size_t      path;
+        int64_t     start_ns;
+        int64_t     child_ns; // Inclusive time of the frames it entered.
+    };
+    //
+    std::vector<Entry> entries;
+    std::unordered_map<const AST*,size_t> entry_of;
+    std::vector<Path> paths;
+    std::unordered_map<uint64_t,size_t> path_of;
+    std::vector<Frame> stack;
+    Clock::time_point epoch;
+    //
+    size_t entry_for(const AST& node, std::string name);
+    void push(size_t entry);
+    int64_t now_ns(void) const;
+    std::string frame_name(size_t entry) const;
+};
+
+//
+// class Prof_scope
+//
+// Brackets the execution of a statement or a definition's body for the
+// active profile, if there is one. Leaving through an exception (a
+// run-time error) still pops the frame.
+//
+class Prof_scope {
+private:
+    Prof* prof;
+public:
+    template <typename Node>
+    Prof_scope(const Node& node) : prof {Prof::active} {
+        if (prof) prof->enter(node);
+    }
+    ~Prof_scope(void) {
+        if (prof) prof->leave();
+    }
+    Prof_scope(const Prof_scope&) = delete;
+    Prof_scope& operator=(const Prof_scope&) = delete;
+};
+
+#endif
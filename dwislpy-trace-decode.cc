@@ -0,0 +1,236 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "spim-cmd/trace-ring.h"
+
+//
+// dwislpy-trace-decode - prints a binary execution trace
+//
+// Usage: ./dwislpy-trace-decode [--summary] file.trace
+//
+// Reads a trace written by `dwislpyc --trace` or by `spim -trace` (see
+// spim-cmd/trace-ring.h) and prints its events, oldest first, one per
+// line with the time in microseconds since the first. Calls are
+// indented by their depth, and each def or label is shown by name.
+//
+// With `--summary` it instead prints the number of each kind of event,
+// the calls made to each def, the syscalls made, and the share of the
+// PC samples that fell in the code following each label.
+//
+
+struct Trace {
+    trace_header header;
+    std::vector<trace_event> events;
+    std::map<uint32_t,std::string> names;
+};
+
+bool read_trace(std::string filename, Trace& trace) {
+    std::ifstream in { filename, std::ios::binary };
+    if (in.fail()) {
+        std::cerr << "Unable to open " << filename << "." << std::endl;
+        return false;
+    }
+    in.read(reinterpret_cast<char*>(&trace.header), sizeof(trace.header));
+    if (!in || memcmp(trace.header.magic, TRACE_MAGIC, 8) != 0) {
+        std::cerr << filename << " is not a trace file." << std::endl;
+        return false;
+    }
+    trace.events.resize(trace.header.count);
+    in.read(reinterpret_cast<char*>(trace.events.data()),
+            trace.header.count * sizeof(trace_event));
+    uint32_t count = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    for (uint32_t i = 0; in && i < count; i++) {
+        uint32_t id, len;
+        in.read(reinterpret_cast<char*>(&id), sizeof(id));
+        in.read(reinterpret_cast<char*>(&len), sizeof(len));
+        std::string name(len, '\0');
+        in.read(&name[0], len);
+        trace.names[id] = name;
+    }
+    if (!in) {
+        std::cerr << filename << " is truncated." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char* kind_name(uint32_t kind) {
+    switch (kind) {
+    case TRACE_CALL:    return "call";
+    case TRACE_RETURN:  return "return";
+    case TRACE_LOOP:    return "loop";
+    case TRACE_INPUT:   return "input";
+    case TRACE_PRINT:   return "print";
+    case TRACE_PC:      return "pc";
+    case TRACE_SYSCALL: return "syscall";
+    default:            return "?";
+    }
+}
+
+// def_name
+//
+// The name of the def starting on line `arg`.
+//
+std::string def_name(const Trace& trace, uint32_t arg) {
+    auto found = trace.names.find(arg);
+    if (found == trace.names.end()) {
+        return "line " + std::to_string(arg);
+    }
+    return found->second;
+}
+
+// code_name
+//
+// Describes code address `pc` as an offset from the nearest label
+// before it.
+//
+std::string code_name(const Trace& trace, uint32_t pc) {
+    char hex[32];
+    snprintf(hex, sizeof(hex), "0x%08x", pc);
+    auto after = trace.names.upper_bound(pc);
+    if (after == trace.names.begin()) {
+        return hex;
+    }
+    after--;
+    return std::string(hex) + " " + after->second
+        + "+" + std::to_string(pc - after->first);
+}
+
+std::string label_of(const Trace& trace, uint32_t pc) {
+    auto after = trace.names.upper_bound(pc);
+    if (after == trace.names.begin()) {
+        return "?";
+    }
+    after--;
+    return after->second;
+}
+
+void print_events(const Trace& trace) {
+    if (trace.header.written > trace.header.count) {
+        std::cout << "# " << trace.header.written - trace.header.count
+                  << " earlier events were overwritten." << std::endl;
+    }
+    if (trace.events.empty()) return;
+    double ticks_per_us = trace.header.ticks_per_sec / 1e6;
+    uint64_t start = trace.events[0].time;
+    int depth = 0;
+    for (const trace_event& e : trace.events) {
+        if (e.kind == TRACE_RETURN && depth > 0) depth--;
+        char when[32];
+        snprintf(when, sizeof(when), "%12.3f", (e.time - start) / ticks_per_us);
+        std::cout << when << " " << std::string(2*depth, ' ')
+                  << kind_name(e.kind) << " ";
+        switch (e.kind) {
+        case TRACE_CALL:
+        case TRACE_RETURN:
+            std::cout << def_name(trace, e.arg);
+            break;
+        case TRACE_PC:
+            std::cout << code_name(trace, e.arg);
+            break;
+        case TRACE_SYSCALL:
+            std::cout << e.arg;
+            break;
+        default:
+            std::cout << "line " << e.arg;
+            break;
+        }
+        std::cout << std::endl;
+        if (e.kind == TRACE_CALL) depth++;
+    }
+}
+
+template <typename Key>
+void print_counts(std::string title, const std::map<Key,uint64_t>& counts,
+                  uint64_t total) {
+    if (counts.empty()) return;
+    std::vector<std::pair<Key,uint64_t>> order(counts.begin(), counts.end());
+    std::sort(order.begin(), order.end(),
+              [](const std::pair<Key,uint64_t>& a, const std::pair<Key,uint64_t>& b) {
+                  return a.second > b.second;
+              });
+    std::cout << title << ":" << std::endl;
+    for (auto& kc : order) {
+        char line[64];
+        snprintf(line, sizeof(line), "%12llu %6.1f%%  ",
+                 static_cast<unsigned long long>(kc.second),
+                 total > 0 ? 100.0 * kc.second / total : 0.0);
+        std::cout << line << kc.first << std::endl;
+    }
+}
+
+void print_summary(const Trace& trace) {
+    std::map<std::string,uint64_t> kinds { };
+    std::map<std::string,uint64_t> calls { };
+    std::map<uint32_t,uint64_t> syscalls { };
+    std::map<std::string,uint64_t> samples { };
+    uint64_t num_calls = 0;
+    uint64_t num_syscalls = 0;
+    uint64_t num_samples = 0;
+    for (const trace_event& e : trace.events) {
+        kinds[kind_name(e.kind)]++;
+        if (e.kind == TRACE_CALL) {
+            calls[def_name(trace, e.arg)]++;
+            num_calls++;
+        } else if (e.kind == TRACE_SYSCALL) {
+            syscalls[e.arg]++;
+            num_syscalls++;
+        } else if (e.kind == TRACE_PC) {
+            samples[label_of(trace, e.arg)]++;
+            num_samples++;
+        }
+    }
+    std::cout << trace.header.count << " events";
+    if (trace.header.written > trace.header.count) {
+        std::cout << " (of " << trace.header.written << " recorded)";
+    }
+    if (trace.events.size() > 1) {
+        double secs = static_cast<double>(trace.events.back().time
+                                          - trace.events.front().time)
+            / trace.header.ticks_per_sec;
+        std::cout << " over " << secs * 1e3 << "ms";
+    }
+    std::cout << "." << std::endl;
+    print_counts("events", kinds, trace.header.count);
+    print_counts("calls", calls, num_calls);
+    print_counts("syscalls", syscalls, num_syscalls);
+    print_counts("pc samples", samples, num_samples);
+}
+
+// * * * * *
+//
+// main - the trace decoder
+//
+int main(int argc, char** argv) {
+    bool summary = false;
+    char* filename = nullptr;
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], "--summary") == 0) {
+            summary = true;
+        } else {
+            filename = argv[i];
+        }
+    }
+    if (!filename) {
+        std::cerr << "usage: " << argv[0] << " [--summary] file.trace"
+                  << std::endl;
+        return 2;
+    }
+    Trace trace { };
+    if (!read_trace(filename, trace)) {
+        return 1;
+    }
+    if (summary) {
+        print_summary(trace);
+    } else {
+        print_events(trace);
+    }
+    return 0;
+}
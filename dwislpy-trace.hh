@@ -0,0 +1,26 @@
+#ifndef _DWISLPY_TRACE_H
+#define _DWISLPY_TRACE_H
+
+//
+// dwislpy-trace.hh
+//
+// The interpreter's side of `dwislpyc --trace`. While a trace is being
+// recorded, `trace_active` points to its ring (see spim-cmd/trace-ring.h)
+// and the interpreter records
+//
+//   * TRACE_CALL and TRACE_RETURN around each `Defn::call`,
+//   * TRACE_LOOP at each iteration of a `Whle`,
+//   * TRACE_INPUT and TRACE_PRINT for each `Inpt` and `Prnt`,
+//
+// each with the source line of the construct. Each def is named in the
+// trace by the line it starts on.
+//
+// When no trace is being recorded `trace_active` is null, and each of
+// these costs just that test.
+//
+
+#include "spim-cmd/trace-ring.h"
+
+extern trace_ring* trace_active; // The trace being recorded, if any.
+
+#endif
@@ -0,0 +1,480 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "dwislpy-vm.hh"
+#include "dwislpy-inst.hh"
+#include "dwislpy-ast.hh"
+#include "dwislpy-check.hh"
+#include "dwislpy-util.hh"
+
+//
+// dwislpy-vm.cc
+//
+// This gives the code for running the IR on a virtual machine (see
+// dwislpy-vm.hh). At the top level, it defines
+//
+//     Prgm::run_ir
+//
+// which relies on
+//
+//     lower_defn_vm
+//
+// to lower the code of every `def` body and of the `main` script with
+// `INST::toVM`, and then on `VM_code::run` to run it.
+//
+
+// layout_frame_vm(symt)
+//
+// Numbers the register of each variable and temporary within the
+// frame, formals first, marking it as its frame offset in `symt`, and
+// sets the frame's size.
+//
+static void layout_frame_vm(SymT& symt) {
+    int num_frmls = symt.get_frmls_size();
+    int num_locls = symt.get_locls_size();
+    int reg = 0;
+    for (int i = 0; i < num_frmls; i++) {
+        symt.set_frame_offset(symt.get_frml(i)->name,reg++);
+    }
+    for (int i = 0; i < num_locls; i++) {
+        symt.set_frame_offset(symt.get_locl(i)->name,reg++);
+    }
+    symt.set_frame_size(reg);
+}
+
+// lower_defn_vm(vm,symt,code)
+//
+// Lowers `code` into `vm`, relying on `symt` for the registers of its
+// variables and temporaries.
+//
+static void lower_defn_vm(VM_code& vm, SymT& symt, INST_vec& code) {
+    layout_frame_vm(symt);
+    for (INST_ptr inst : code) {
+        inst->toVM(vm,symt);
+    }
+}
+
+// Prgm::run_ir
+//
+// Runs the program by translating it to IR, then running that on the
+// VM. Its output goes to `std::cout` and its input is read from
+// `std::cin`, as with `Prgm::run`.
+//
+void Prgm::run_ir(void) {
+
+    // Translate the AST to IR.
+    //
+    trans();
+
+    // Lower the string constants, then `main` and each live `def`.
+    //
+    VM_code vm { };
+    for (std::pair<Name,std::string> lbl_strg : glbl_symt_ptr->strings) {
+        vm.string(lbl_strg.first,lbl_strg.second);
+    }
+    lower_defn_vm(vm,main_symt,main_code);
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        Defn_ptr defn = dfpr.second;
+        if (!defn->live) continue; // Never translated. See Prgm::trans.
+        lower_defn_vm(vm,defn->symt,defn->code);
+    }
+    if (!vm.link()) {
+        throw DwislpyError { where(), "Unable to link the IR." };
+    }
+
+    vm.run("main",where());
+}
+
+//
+// * * * * *
+//
+// VM_code
+//
+
+long long VM_code::steps = 0;
+
+// emit(op,lblt,lblf)
+//
+// Adds `op`, which jumps to the labels `lblt` and `lblf` (if given).
+//
+void VM_code::emit(VM_op op, const std::string& lblt,
+                   const std::string& lblf) {
+    if (!lblt.empty() || !lblf.empty()) {
+        fixups.push_back({ops.size(), {lblt, lblf}});
+    }
+    ops.push_back(op);
+}
+
+void VM_code::label(const std::string& lbl) {
+    labels[lbl] = ops.size();
+}
+
+// string(lbl,strg)
+//
+// Adds the string constant `strg` labelled `lbl`, giving its index.
+//
+int VM_code::string(const std::string& lbl, const std::string& strg) {
+    string_ids[lbl] = strings.size();
+    strings.push_back(strg);
+    return string_ids[lbl];
+}
+
+int VM_code::string(const std::string& lbl) const {
+    return string_ids.at(lbl);
+}
+
+// link()
+//
+// Resolves the labels that each operation jumps to. Reports whether
+// every one was defined.
+//
+bool VM_code::link(void) {
+    for (const std::pair<size_t,std::pair<std::string,std::string>>& fixup
+             : fixups) {
+        VM_op& op = ops[fixup.first];
+        const std::string& lblt = fixup.second.first;
+        const std::string& lblf = fixup.second.second;
+        if ((!lblt.empty() && labels.count(lblt) == 0)
+            || (!lblf.empty() && labels.count(lblf) == 0)) {
+            return false;
+        }
+        if (!lblt.empty()) op.lblt = labels.at(lblt);
+        if (!lblf.empty()) op.lblf = labels.at(lblf);
+    }
+    return true;
+}
+
+// vm_test(cndn,value1,value2)
+//
+// Whether a BCN or BCZ branches to its `lblt`.
+//
+static inline bool vm_test(VM_cndn cndn, int value1, int value2) {
+    switch (cndn) {
+    case VM_LT: return value1 < value2;
+    case VM_LE: return value1 <= value2;
+    case VM_EQ: return value1 == value2;
+    case VM_NE: return value1 != value2;
+    case VM_GE: return value1 >= value2;
+    default:    return value1 > value2;
+    }
+}
+
+// The return point of a call: where it continues, and its frame.
+struct VM_return {
+    size_t pc;
+    size_t fp;
+};
+
+// run(entry,locn)
+//
+// Runs the code, starting at label `entry` with an empty stack, until
+// the LEAVE of that code. Arithmetic is on 32-bit words that wrap, as
+// on MIPS. A division by 0 or an unknown counter is a run-time error,
+// reported at `locn`.
+//
+void VM_code::run(const std::string& entry, const Locn& locn) {
+    std::vector<int> regs(4096);
+    std::vector<int> args(8);
+    std::vector<VM_return> stack { };
+    size_t fp = 0;
+    size_t sp = 0;
+    int retv = 0;
+    long long io_calls = 0;
+    steps = 0;
+
+    size_t pc = labels.at(entry);
+    for (;;) {
+        const VM_op& op = ops[pc++];
+        int* r = regs.data() + fp;
+        steps++;
+        switch (op.opcode) {
+        case VM_SET:
+            r[op.dst] = op.src1;
+            break;
+        case VM_STL:
+            r[op.dst] = op.src1;
+            break;
+        case VM_MOV:
+            r[op.dst] = r[op.src1];
+            break;
+        case VM_ADD:
+            r[op.dst] = (int)((unsigned)r[op.src1] + (unsigned)r[op.src2]);
+            break;
+        case VM_SUB:
+            r[op.dst] = (int)((unsigned)r[op.src1] - (unsigned)r[op.src2]);
+            break;
+        case VM_MLT:
+            r[op.dst] = (int)((unsigned)r[op.src1] * (unsigned)r[op.src2]);
+            break;
+        case VM_DIV:
+        case VM_MOD:
+            {
+                long long n = r[op.src1];
+                long long d = r[op.src2];
+                if (d == 0) {
+                    throw DwislpyError { locn, "Run-time error: division by 0." };
+                }
+                r[op.dst] = (int)(op.opcode == VM_DIV ? n / d : n % d);
+            }
+            break;
+        case VM_NOP:
+            break;
+        case VM_BCN:
+            pc = vm_test(op.cndn,r[op.src1],r[op.src2]) ? op.lblt : op.lblf;
+            break;
+        case VM_BCZ:
+            pc = vm_test(op.cndn,r[op.src1],0) ? op.lblt : op.lblf;
+            break;
+        case VM_JMP:
+            pc = op.lblt;
+            break;
+        case VM_ENTER:
+            fp = sp;
+            sp += op.src1;
+            if (sp > regs.size()) {
+                regs.resize(2 * sp);
+            }
+            r = regs.data() + fp;
+            for (int i = 0; i < op.src2; i++) {
+                r[i] = args[i];
+            }
+            break;
+        case VM_RTN:
+            retv = r[op.src1];
+            break;
+        case VM_LEAVE:
+            if (stack.empty()) {
+                return;
+            }
+            sp = fp;
+            fp = stack.back().fp;
+            pc = stack.back().pc;
+            stack.pop_back();
+            break;
+        case VM_ARG:
+            if ((size_t)op.dst >= args.size()) {
+                args.resize(op.dst + 1);
+            }
+            args[op.dst] = r[op.src1];
+            break;
+        case VM_CLL:
+            stack.push_back(VM_return {pc, fp});
+            pc = op.lblt;
+            break;
+        case VM_RTV:
+            r[op.dst] = retv;
+            break;
+        case VM_GTI:
+            {
+                io_calls++;
+                std::string line;
+                std::getline(std::cin,line);
+                r[op.dst] = (int)std::atol(line.c_str());
+            }
+            break;
+        case VM_PTI:
+            io_calls++;
+            std::cout << r[op.src1];
+            break;
+        case VM_PTS:
+            io_calls++;
+            std::cout << strings[r[op.src1]];
+            break;
+        case VM_RDC:
+            io_calls++;
+            switch (r[op.src1]) {
+            case 0:
+            case 1:
+                r[op.dst] = (int)steps;
+                break;
+            case 2:
+                r[op.dst] = (int)io_calls;
+                break;
+            default:
+                std::string msg = "Run-time error: no counter ";
+                msg += std::to_string(r[op.src1]) + ".";
+                throw DwislpyError { locn, msg };
+            }
+            break;
+        }
+    }
+}
+
+//
+// * * * * *
+//
+// INST::toVM
+//
+// Each lowers its instruction to (at most) one VM operation, naming
+// each variable or temporary by its register. LBL marks the operation
+// after it, and CMT has none.
+//
+
+// vm_cndn(cndn)
+//
+// The condition of a BCN or BCZ.
+//
+static VM_cndn vm_cndn(std::string cndn) {
+    if (cndn.back() == 'z') {
+        cndn.pop_back();
+    }
+    if (cndn == "lt") return VM_LT;
+    if (cndn == "le") return VM_LE;
+    if (cndn == "eq") return VM_EQ;
+    if (cndn == "ne") return VM_NE;
+    if (cndn == "ge") return VM_GE;
+    return VM_GT; // "gt"
+}
+
+// vm_reg(symt,name)
+//
+// The register of a variable or temporary.
+//
+static int vm_reg(const SymT& symt, const std::string& name) {
+    return symt.get_frame_offset(name);
+}
+
+void ENTER::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_ENTER};
+    op.src1 = symt.get_frame_size();
+    op.src2 = symt.get_frmls_size();
+    vm.emit(op);
+}
+//
+void LEAVE::toVM(VM_code& vm, [[maybe_unused]] const SymT& symt) const {
+    vm.emit(VM_op {VM_LEAVE});
+}
+//
+void SET::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_SET};
+    op.dst = vm_reg(symt,dst);
+    op.src1 = val;
+    vm.emit(op);
+}
+//
+void STL::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_STL};
+    op.dst = vm_reg(symt,dst);
+    op.src1 = vm.string(lbl);
+    vm.emit(op);
+}
+//
+void MOV::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_MOV};
+    op.dst = vm_reg(symt,dst);
+    op.src1 = vm_reg(symt,src);
+    vm.emit(op);
+}
+//
+void RTV::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_RTV};
+    op.dst = vm_reg(symt,dst);
+    vm.emit(op);
+}
+//
+void GTI::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_GTI};
+    op.dst = vm_reg(symt,dst);
+    vm.emit(op);
+}
+//
+void NOP::toVM(VM_code& vm, [[maybe_unused]] const SymT& symt) const {
+    vm.emit(VM_op {VM_NOP});
+}
+//
+void PTI::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_PTI};
+    op.src1 = vm_reg(symt,src);
+    vm.emit(op);
+}
+//
+void PTS::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_PTS};
+    op.src1 = vm_reg(symt,src);
+    vm.emit(op);
+}
+//
+void RDC::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_RDC};
+    op.dst = vm_reg(symt,dst);
+    op.src1 = vm_reg(symt,src);
+    vm.emit(op);
+}
+//
+// vm_arith(vm,symt,opcode,dst,src1,src2)
+//
+// An int operation of `src1` by `src2` into `dst`, as with ADD.
+//
+static void vm_arith(VM_code& vm, const SymT& symt, VM_opcode opcode,
+                     const std::string& dst, const std::string& src1,
+                     const std::string& src2) {
+    VM_op op {opcode};
+    op.dst = vm_reg(symt,dst);
+    op.src1 = vm_reg(symt,src1);
+    op.src2 = vm_reg(symt,src2);
+    vm.emit(op);
+}
+//
+void ADD::toVM(VM_code& vm, const SymT& symt) const {
+    vm_arith(vm,symt,VM_ADD,dst,src1,src2);
+}
+//
+void SUB::toVM(VM_code& vm, const SymT& symt) const {
+    vm_arith(vm,symt,VM_SUB,dst,src1,src2);
+}
+//
+void MLT::toVM(VM_code& vm, const SymT& symt) const {
+    vm_arith(vm,symt,VM_MLT,dst,src1,src2);
+}
+//
+void DIV::toVM(VM_code& vm, const SymT& symt) const {
+    vm_arith(vm,symt,VM_DIV,dst,src1,src2);
+}
+//
+void MOD::toVM(VM_code& vm, const SymT& symt) const {
+    vm_arith(vm,symt,VM_MOD,dst,src1,src2);
+}
+//
+void RTN::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_RTN};
+    op.src1 = vm_reg(symt,src);
+    vm.emit(op);
+}
+//
+void BCN::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_BCN};
+    op.cndn = vm_cndn(cndn);
+    op.src1 = vm_reg(symt,src1);
+    op.src2 = vm_reg(symt,src2);
+    vm.emit(op,lblt,lblf);
+}
+//
+void BCZ::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_BCZ};
+    op.cndn = vm_cndn(cndn);
+    op.src1 = vm_reg(symt,src);
+    vm.emit(op,lblt,lblf);
+}
+//
+void JMP::toVM(VM_code& vm, [[maybe_unused]] const SymT& symt) const {
+    vm.emit(VM_op {VM_JMP},lbl);
+}
+//
+void CLL::toVM(VM_code& vm, [[maybe_unused]] const SymT& symt) const {
+    vm.emit(VM_op {VM_CLL},lbl);
+}
+//
+void LBL::toVM(VM_code& vm, [[maybe_unused]] const SymT& symt) const {
+    vm.label(lbl);
+}
+//
+void CMT::toVM([[maybe_unused]] VM_code& vm,
+               [[maybe_unused]] const SymT& symt) const {
+}
+//
+void ARG::toVM(VM_code& vm, const SymT& symt) const {
+    VM_op op {VM_ARG};
+    op.dst = idx;
+    op.src1 = vm_reg(symt,src);
+    vm.emit(op);
+}
@@ -0,0 +1,87 @@
+#ifndef _DWISLPY_VM_HH
+#define _DWISLPY_VM_HH
+
+//
+// dwislpy-vm.hh
+//
+// A virtual machine that runs the IR directly, a third way to run a
+// checked DwiSlpy program besides `Prgm::run` and SPIM. `Prgm::run_ir`
+// translates the program with `Prgm::trans`, as `Prgm::compile` does,
+// then lowers each IR instruction with its `toVM` method into a flat
+// array of `VM_op`s and runs them (see dwislpy-vm.cc). There is no
+// assembler round trip, so it is a quick check of what the IR does,
+// and it counts the IR instructions run.
+//
+// As on MIPS, each variable and temporary of a definition has a slot
+// in its frame: here a register, numbered from the frame's base, in
+// a flat array of 32-bit registers. The formal parameters take the
+// first registers, in order. ENTER pushes a frame of the definition's
+// size on top of its caller's and CLL, LEAVE push and pop the return
+// point on a separate stack. A string constant is held as its index
+// in the program's table of them.
+//
+// Its counters (for `perf`) are the IR instructions run (0 and 1, as
+// SPIM counts a cycle per instruction) and its I/O calls (2).
+//
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include "dwislpy-util.hh"
+#include "dwislpy-check.hh"
+
+// The operations of the VM, one for each kind of IR instruction that
+// does any work.
+enum VM_opcode {
+    VM_SET, VM_STL, VM_MOV, VM_ADD, VM_SUB, VM_MLT, VM_DIV, VM_MOD,
+    VM_NOP, VM_BCN, VM_BCZ, VM_JMP, VM_ENTER, VM_RTN, VM_LEAVE,
+    VM_ARG, VM_CLL, VM_RTV, VM_GTI, VM_PTI, VM_PTS, VM_RDC
+};
+
+// The conditions of BCN and BCZ.
+enum VM_cndn { VM_LT, VM_LE, VM_EQ, VM_NE, VM_GE, VM_GT };
+
+//
+// struct VM_op
+//
+// One operation, with its registers (or a value) and the operations
+// it might jump to.
+//
+struct VM_op {
+    VM_opcode opcode;
+    VM_cndn cndn = VM_EQ;
+    int dst = 0;  // Also the value of SET, the index of ARG, and
+    int src1 = 0; // the frame size of ENTER.
+    int src2 = 0;
+    size_t lblt = 0;
+    size_t lblf = 0;
+};
+
+//
+// class VM_code
+//
+// A program lowered for the VM. The IR labels are resolved once all
+// of its code is in.
+//
+class VM_code {
+public:
+    std::vector<VM_op> ops;
+    std::vector<std::string> strings;
+    //
+    static long long steps; // IR instructions run by the last `run`.
+    //
+    void emit(VM_op op, const std::string& lblt = "",
+              const std::string& lblf = "");
+    void label(const std::string& lbl);
+    int string(const std::string& lbl, const std::string& strg);
+    int string(const std::string& lbl) const;
+    bool link(void);
+    void run(const std::string& entry, const Locn& locn);
+private:
+    std::unordered_map<std::string,size_t> labels;
+    std::unordered_map<std::string,int> string_ids;
+    std::vector<std::pair<size_t,std::pair<std::string,std::string>>> fixups;
+};
+
+#endif
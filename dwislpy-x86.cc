@@ -0,0 +1,419 @@
+#include <iostream>
+#include <fstream>
+#include "dwislpy-inst.hh"
+#include "dwislpy-ast.hh"
+#include "dwislpy-check.hh"
+#include "dwislpy-util.hh"
+
+//
+// dwislpy-x86.cc
+//
+// This gives the code for compiling the IR into x86-64 code for the
+// System V ABI (e.g. Linux), outputting GNU assembler source to a
+// provided `std::ostream`. It is a sibling of dwislpy-mips.cc, taking
+// the same IR from `Prgm::trans`. At the top level, it defines
+//
+//     Prgm::compile_x86
+//
+// which relies on
+//
+//     compile_defn_x86
+//
+// to produce x86-64 code for every `def` body and for the `main`
+// script, and on `INST::toX86` for each IR instruction. The output
+// also holds a small runtime, written by `runtime_x86`, that does the
+// work of SPIM's system calls with the C library. It assembles and
+// links with the local C compiler:
+//
+//     cc -o foo foo.x86.s
+//
+// As with MIPS, every variable and temporary lives in the frame, here
+// in an 8-byte slot below %rbp, and each instruction loads what it
+// needs into registers and stores its result. Ints are kept sign-
+// extended to 64 bits and operated on as 32-bit values, as on MIPS;
+// string constants are 64-bit addresses.
+//
+// Each IR label is prefixed by `DW_` so that the program's `def`s and
+// labels cannot collide with the runtime's or the C library's names.
+// In particular the main script is `DW_main`, called by the runtime's
+// `main`, which then returns 0.
+//
+
+#define X86_LABEL_PREFIX "DW_"
+#define X86_SLOT_SIZE    8
+#define X86_MAX_ARGS     6
+
+// The registers that pass a call's arguments, in order.
+static const char* x86_arg_regs[X86_MAX_ARGS] = {
+    "%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"
+};
+
+// x86_label(lbl)
+//
+// The assembly label for an IR label.
+//
+static std::string x86_label(std::string lbl) {
+    return X86_LABEL_PREFIX + lbl;
+}
+
+// x86_slot(symt,name)
+//
+// The operand for a variable or temporary's frame slot.
+//
+static std::string x86_slot(const SymT& symt, std::string name) {
+    return std::to_string(symt.get_frame_offset(name)) + "(%rbp)";
+}
+
+// x86_jump(cndn)
+//
+// The conditional jump for a BCN or BCZ condition, after comparing
+// its (first) source with its second, or with 0.
+//
+static std::string x86_jump(std::string cndn) {
+    if (cndn.back() == 'z') {
+        cndn.pop_back();
+    }
+    if (cndn == "lt") return "jl";
+    if (cndn == "le") return "jle";
+    if (cndn == "eq") return "je";
+    if (cndn == "ne") return "jne";
+    if (cndn == "ge") return "jge";
+    return "jg"; // "gt"
+}
+
+// layout_frame_x86(symt)
+//
+// Sets up the frame information for x86-64 code, marking the frame
+// location of each variable and temporary, and the frame's size, in
+// `symt`. Also used by the JIT (see dwislpy-jit.cc).
+//
+void layout_frame_x86(SymT& symt) {
+    int num_frmls = symt.get_frmls_size();
+    int num_locls = symt.get_locls_size();
+
+    //
+    // Frame layout: the caller's %rbp is saved at 0(%rbp) and the
+    // return address sits above it. The formal parameters, which
+    // arrive in registers, are saved in the slots just below, then
+    // the locals and temporaries. The frame size is a multiple of
+    // 16, keeping %rsp aligned for calls.
+    //
+    int offset = -X86_SLOT_SIZE;
+    for (int i = 0; i < num_frmls; i++) {
+        std::string frml = symt.get_frml(i)->name;
+        symt.set_frame_offset(frml,offset);
+        offset -= X86_SLOT_SIZE;
+    }
+    for (int i = 0; i < num_locls; i++) {
+        std::string locl = symt.get_locl(i)->name;
+        symt.set_frame_offset(locl,offset);
+        offset -= X86_SLOT_SIZE;
+    }
+    int frame_size = X86_SLOT_SIZE * (num_frmls + num_locls);
+    if (frame_size % 16 != 0) {
+        frame_size += 8;
+    }
+    symt.set_frame_size(frame_size);
+}
+
+// compile_defn_x86(os,symt,code)
+//
+// Generate x86-64 code into `os`, relying on `symt` to figure out
+// frame locations of variables and temporaries. This sets up the
+// frame information, marking things in the `symt`, then walks through
+// `code` and converts each IR instruction (using `toX86`) into
+// x86-64 code.
+//
+void compile_defn_x86(std::ostream& os, SymT& symt, INST_vec& code) {
+    layout_frame_x86(symt);
+    for (INST_ptr inst : code) {
+        inst->toX86(os,symt);
+    }
+}
+
+// runtime_x86(os)
+//
+// Generate the runtime called by the compiled code:
+//
+//   main                 - runs DW_main and returns 0.
+//   dwislpy_put_int      - outputs the int in %edi (PTI).
+//   dwislpy_put_str      - outputs the string at %rdi (PTS).
+//   dwislpy_get_int      - reads a line of input, and gives the int
+//                          it starts with in %eax, or 0 (GTI).
+//   dwislpy_read_counter - gives counter %edi in %eax (RDC).
+//
+// Counter 1 is the processor's time-stamp counter. There is no count
+// of instructions, so counter 0 reads as -1, as do unknown counters.
+// Counter 2 counts the calls to the runtime, as SPIM counts syscalls.
+//
+static void runtime_x86(std::ostream& os) {
+    os << "\t" << ".data" << std::endl;
+    os << "dwislpy_calls:" << std::endl;
+    os << "\t" << ".quad 0" << std::endl;
+    os << "dwislpy_int_format:" << std::endl;
+    os << "\t" << ".asciz \"%d\"" << std::endl;
+    os << "\t" << ".text" << std::endl;
+    //
+    os << "\t" << ".globl main" << std::endl;
+    os << "main:" << std::endl;
+    os << "\t" << "subq $8,%rsp" << std::endl;
+    os << "\t" << "call " << x86_label("main") << std::endl;
+    os << "\t" << "xorl %eax,%eax" << std::endl;
+    os << "\t" << "addq $8,%rsp" << std::endl;
+    os << "\t" << "ret" << std::endl;
+    //
+    os << "dwislpy_put_int:" << std::endl;
+    os << "\t" << "incq dwislpy_calls(%rip)" << std::endl;
+    os << "\t" << "subq $8,%rsp" << std::endl;
+    os << "\t" << "movl %edi,%esi" << std::endl;
+    os << "\t" << "leaq dwislpy_int_format(%rip),%rdi" << std::endl;
+    os << "\t" << "xorl %eax,%eax" << std::endl;
+    os << "\t" << "call printf@PLT" << std::endl;
+    os << "\t" << "addq $8,%rsp" << std::endl;
+    os << "\t" << "ret" << std::endl;
+    //
+    os << "dwislpy_put_str:" << std::endl;
+    os << "\t" << "incq dwislpy_calls(%rip)" << std::endl;
+    os << "\t" << "subq $8,%rsp" << std::endl;
+    os << "\t" << "movq stdout@GOTPCREL(%rip),%rax" << std::endl;
+    os << "\t" << "movq (%rax),%rsi" << std::endl;
+    os << "\t" << "call fputs@PLT" << std::endl;
+    os << "\t" << "addq $8,%rsp" << std::endl;
+    os << "\t" << "ret" << std::endl;
+    //
+    // The line is read into an 80-byte buffer on the stack, as SPIM
+    // reads into INPT_BUFF_LBL. Output is flushed first so that a
+    // prompt appears.
+    //
+    os << "dwislpy_get_int:" << std::endl;
+    os << "\t" << "incq dwislpy_calls(%rip)" << std::endl;
+    os << "\t" << "subq $88,%rsp" << std::endl;
+    os << "\t" << "movq stdout@GOTPCREL(%rip),%rax" << std::endl;
+    os << "\t" << "movq (%rax),%rdi" << std::endl;
+    os << "\t" << "call fflush@PLT" << std::endl;
+    os << "\t" << "movq %rsp,%rdi" << std::endl;
+    os << "\t" << "movl $80,%esi" << std::endl;
+    os << "\t" << "movq stdin@GOTPCREL(%rip),%rax" << std::endl;
+    os << "\t" << "movq (%rax),%rdx" << std::endl;
+    os << "\t" << "call fgets@PLT" << std::endl;
+    os << "\t" << "testq %rax,%rax" << std::endl;
+    os << "\t" << "je dwislpy_get_int_eof" << std::endl;
+    os << "\t" << "movq %rsp,%rdi" << std::endl;
+    os << "\t" << "xorl %esi,%esi" << std::endl;
+    os << "\t" << "movl $10,%edx" << std::endl;
+    os << "\t" << "call strtol@PLT" << std::endl;
+    os << "\t" << "addq $88,%rsp" << std::endl;
+    os << "\t" << "ret" << std::endl;
+    os << "dwislpy_get_int_eof:" << std::endl;
+    os << "\t" << "xorl %eax,%eax" << std::endl;
+    os << "\t" << "addq $88,%rsp" << std::endl;
+    os << "\t" << "ret" << std::endl;
+    //
+    os << "dwislpy_read_counter:" << std::endl;
+    os << "\t" << "incq dwislpy_calls(%rip)" << std::endl;
+    os << "\t" << "cmpl $1,%edi" << std::endl;
+    os << "\t" << "je dwislpy_read_cycles" << std::endl;
+    os << "\t" << "cmpl $2,%edi" << std::endl;
+    os << "\t" << "je dwislpy_read_calls" << std::endl;
+    os << "\t" << "movl $-1,%eax" << std::endl;
+    os << "\t" << "ret" << std::endl;
+    os << "dwislpy_read_cycles:" << std::endl;
+    os << "\t" << "rdtsc" << std::endl;
+    os << "\t" << "ret" << std::endl;
+    os << "dwislpy_read_calls:" << std::endl;
+    os << "\t" << "movq dwislpy_calls(%rip),%rax" << std::endl;
+    os << "\t" << "ret" << std::endl;
+}
+
+// Prgm::compile_x86(os)
+//
+// Generate x86-64 code into `os`, as `Prgm::compile` does MIPS32 code,
+// along with the runtime. The resulting file is GNU assembler source
+// for a complete program.
+//
+// Arguments are passed only in registers, so a `def` can have at most
+// six parameters.
+//
+void Prgm::compile_x86(std::ostream& os) {
+
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        Defn_ptr defn = dfpr.second;
+        if (defn->live && defn->arity() > X86_MAX_ARGS) {
+            std::string msg = "Cannot compile a definition with more than ";
+            msg += std::to_string(X86_MAX_ARGS) + " parameters for x86-64.";
+            throw DwislpyError { defn->where(), msg };
+        }
+    }
+
+    // Translate the AST to IR.
+    //
+    trans();
+
+    // Generate the read-only section filled with string constants.
+    //
+    os << "\t.section .rodata" << std::endl;
+    for (std::pair<Name,std::string> lbl_strg : glbl_symt_ptr->strings) {
+        std::string lbl = lbl_strg.first;
+        std::string strg = "\"" + re_escape(lbl_strg.second) + "\"";
+        os << x86_label(lbl) << ":" << std::endl;
+        os << "\t.asciz " << strg << std::endl;
+    }
+
+    // Generate the runtime, then the `.text` section filled with `main`
+    // and each live `def`'s (labelled) code.
+    //
+    runtime_x86(os);
+    compile_defn_x86(os,main_symt,main_code);
+    for (std::pair<Name,Defn_ptr> dfpr : defs) {
+        Defn_ptr defn = dfpr.second;
+        if (!defn->live) continue;
+        compile_defn_x86(os,defn->symt,defn->code);
+    }
+    os << "\t.section .note.GNU-stack,\"\",@progbits" << std::endl;
+}
+
+//
+// INST::toX86(os,symt)
+//
+// Method for generating x86-64 code that performs the work of a
+// pseudo-instruction (an object derived from class INST), as
+// `INST::toMIPS` does for MIPS. Intermediate values are kept in
+// %rax, %rcx, and %rdx.
+//
+// We define this method for each subclass of INST.
+//
+//
+void ENTER::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "pushq %rbp" << std::endl;
+    os << "\t" << "movq %rsp,%rbp" << std::endl;
+    os << "\t" << "subq $" << symt.get_frame_size() << ",%rsp" << std::endl;
+    for (unsigned int argi = 0; argi < symt.get_frmls_size(); argi++) {
+        std::string pram = symt.get_frml(argi)->name;
+        os << "\t" << "movq " << x86_arg_regs[argi] << ","
+           << x86_slot(symt,pram) << std::endl;
+    }
+}
+//
+void LEAVE::toX86(std::ostream& os, [[maybe_unused]] const SymT& symt) const {
+    os << "\t" << "leave" << std::endl;
+    os << "\t" << "ret" << std::endl;
+}
+void SET::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movq $" << val << "," << x86_slot(symt,dst) << std::endl;
+}
+//
+void STL::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "leaq " << x86_label(lbl) << "(%rip),%rax" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void MOV::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movq " << x86_slot(symt,src) << ",%rax" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void RTV::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void GTI::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "call dwislpy_get_int" << std::endl;
+    os << "\t" << "cltq" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void NOP::toX86(std::ostream& os, [[maybe_unused]] const SymT& symt) const {
+    os << "\t" << "nop" << std::endl;
+}
+//
+void PTI::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src) << ",%edi" << std::endl;
+    os << "\t" << "call dwislpy_put_int" << std::endl;
+}
+//
+void PTS::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movq " << x86_slot(symt,src) << ",%rdi" << std::endl;
+    os << "\t" << "call dwislpy_put_str" << std::endl;
+}
+//
+void RDC::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src) << ",%edi" << std::endl;
+    os << "\t" << "call dwislpy_read_counter" << std::endl;
+    os << "\t" << "cltq" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void ADD::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src1) << ",%eax" << std::endl;
+    os << "\t" << "addl " << x86_slot(symt,src2) << ",%eax" << std::endl;
+    os << "\t" << "cltq" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void SUB::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src1) << ",%eax" << std::endl;
+    os << "\t" << "subl " << x86_slot(symt,src2) << ",%eax" << std::endl;
+    os << "\t" << "cltq" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void MLT::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src1) << ",%eax" << std::endl;
+    os << "\t" << "imull " << x86_slot(symt,src2) << ",%eax" << std::endl;
+    os << "\t" << "cltq" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void DIV::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src1) << ",%eax" << std::endl;
+    os << "\t" << "cltd" << std::endl;
+    os << "\t" << "idivl " << x86_slot(symt,src2) << std::endl;
+    os << "\t" << "cltq" << std::endl;
+    os << "\t" << "movq %rax," << x86_slot(symt,dst) << std::endl;
+}
+//
+void MOD::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src1) << ",%eax" << std::endl;
+    os << "\t" << "cltd" << std::endl;
+    os << "\t" << "idivl " << x86_slot(symt,src2) << std::endl;
+    os << "\t" << "movslq %edx,%rdx" << std::endl;
+    os << "\t" << "movq %rdx," << x86_slot(symt,dst) << std::endl;
+}
+//
+void RTN::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movq " << x86_slot(symt,src) << ",%rax" << std::endl;
+}
+//
+void BCN::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movl " << x86_slot(symt,src1) << ",%eax" << std::endl;
+    os << "\t" << "cmpl " << x86_slot(symt,src2) << ",%eax" << std::endl;
+    os << "\t" << x86_jump(cndn) << " " << x86_label(lblt) << std::endl;
+    os << "\t" << "jmp " << x86_label(lblf) << std::endl;
+}
+//
+void BCZ::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "cmpl $0," << x86_slot(symt,src) << std::endl;
+    os << "\t" << x86_jump(cndn) << " " << x86_label(lblt) << std::endl;
+    os << "\t" << "jmp " << x86_label(lblf) << std::endl;
+}
+//
+void JMP::toX86(std::ostream& os, [[maybe_unused]] const SymT& symt) const {
+    os << "\t" << "jmp " << x86_label(lbl) << std::endl;
+}
+//
+void CLL::toX86(std::ostream& os, [[maybe_unused]] const SymT& symt) const {
+    os << "\t" << "call " << x86_label(lbl) << std::endl;
+}
+//
+void LBL::toX86(std::ostream& os, [[maybe_unused]] const SymT& symt) const {
+    os << x86_label(lbl) << ":" << std::endl;
+}
+//
+void CMT::toX86(std::ostream& os,[[maybe_unused]]  const SymT& symt) const {
+    os << "\t\t\t\t#" << msg << std::endl;
+}
+//
+void ARG::toX86(std::ostream& os, const SymT& symt) const {
+    os << "\t" << "movq " << x86_slot(symt,src) << ","
+       << x86_arg_regs[idx] << std::endl;
+}
@@ -7,103 +7,68 @@
 #include "dwislpy-bison.tab.hh"
 #include "dwislpy-util.hh"
 #include "dwislpy-main.hh"
+#include "dwislpy-io.hh"
+#include "dwislpy-jit.hh"
+#include "dwislpy-vm.hh"
 
 //
 // dwslpyc - a DWISLPY compiler
 //
-// Usage: ./dwislpyc <DWISLPY source file name>
+// Usage: ./dwislpyc [--memoize] [--profile] [--trace] [--closures]
+//                   [--jit] [--ir] [--x86] [--stdin-file <file>]
+//                   <DWISLPY source file>
 //
 // This command compiles a DWISLPY program into MIPS source. If the
 // source file's name is `foo.py` (or `foo.slpy` etc.) It will
 // generate the MIPS source `foo.s`. This source can be run using the
-// SPIM text-based MIPS32 emulator.
+// SPIM text-based MIPS32 emulator. With `--x86` it instead generates
+// the x86-64 source `foo.x86.s`, which builds a native program with
+// `cc -o foo foo.x86.s`.
+//
+// Before compiling, the program is interpreted. With `--memoize` the
+// interpreter caches the results of pure functions (those that do no
+// I/O, even through the functions they call) by their arguments, so a
+// repeated call is not re-run. With `--profile` its
+// run is profiled: a report of where the time went, by source line, is
+// written to the standard error and the collapsed stacks (for drawing
+// a flamegraph) to `foo.folded`. With `--trace` a binary trace of its
+// calls, loop iterations and I/O is written to `foo.trace`, to be read
+// with `dwislpy-trace-decode`. With `--closures` the checked program
+// is first compiled into C++ closures, which then run it faster than
+// walking its AST (unless it is also profiled or traced). With `--jit`
+// each pure definition that works only with ints and bools is compiled
+// to x86-64 machine code, once it has been called often enough, and
+// then run natively (see dwislpy-jit.hh). With `--ir` the program is
+// instead translated to IR and that is run on a virtual machine (see
+// dwislpy-vm.hh), and the number of IR instructions it ran is written
+// to the standard error.
+//
+// The program's input is read from the standard input in large chunks.
+// With `--stdin-file` it is instead read from the given file, which is
+// mapped into memory rather than copied.
 //
 // The code is heavily reliant upon:
 //
 // * dwislpy-ast.{cc,hh} - defines the AST for our language
 // * dwislpy-check.{cc,hh} - annotates the AST in prep for compilation
 // * dwislpy-inst.{cc,hh} - defines the IR, performs translation/compilation
+// * dwislpy-driver.cc - the DWISLPY::Driver methods that invoke each stage
 //
 
-// * * * * *
-//
-// DWISLPY::Driver methods.
-//
-// This class just houses the components of the DWISLPY interpreter.
-// We wrote it this way just to prevent some deallocation errors
-// due to sharing pointers in our interfacing with Flex/Bison, programs
-// built in a more permissive error (and originally for C).
-//
-
-DWISLPY::Driver::Driver(std::string filename) :
-    src_name {filename}
-{
-    src_stream = istream_ptr { new std::ifstream { src_name } };
-}
-
-// parse
-//
-// Checks the file's stream, builds the lexer for it, then parses the
-// file's contents. The parser sets the `prgm` AST using the `set`
-// method.
-//
-void DWISLPY::Driver::parse(void) {
-    if (src_stream->fail()) {
-        Locn locn {src_name};
-        std::string mesg = "Unable to open file. Does the file exist?";
-        throw DwislpyError {locn, mesg};
-    }
-    lexer = Lexer_ptr { new DWISLPY::Lexer { src_stream.get(), src_name } };
-    DWISLPY::Lexer& lexer_local = *lexer;
-    parser = Parser_ptr { new DWISLPY::Parser { lexer_local, *this } };
-    parser->parse();
-}
-
-// run
-//
-// Runs the DwiSlpy program.
-//
-void DWISLPY::Driver::run(void) {
-    program->run();
-}
-
-// check
-//
-// Runs the DwiSlpy program.
-//
-void DWISLPY::Driver::check(void) {
-    program->chck();
-}
-
-// compile
-//
-// Runs the DwiSlpy program.
-//
-void DWISLPY::Driver::compile(void) {
-    std::ofstream out_stream { };
-    size_t thedot = src_name.find_last_of("."); 
-    std::string out_name = src_name.substr(0, thedot) + ".s"; 
-    out_stream.open(out_name);
-    program->compile(out_stream);
-    out_stream.close();
-}
-
-// dump
-//
-// Outputs the DwiSlpy program, either by depicting its AST, or by
-// a "pretty" version that mimics the original source code.
-//
-void DWISLPY::Driver::dump(bool pretty) {
-    if (pretty) {
-        program->output(std::cout);
-    } else {
-        program->dump();
+char* extract_filename(int argc, char** argv) {
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i],"--stdin-file") == 0) {
+            i++; // Skip its value.
+        } else if (argv[i][0] != '-') {
+            return argv[i];
+        }
     }
+    return nullptr;
 }
 
-char* extract_filename(int argc, char** argv) {
-    for (int i=1; i<argc; i++) {
-        if (argv[i][0] != '-') return argv[i];
+char* flag_value(int argc, char** argv, std::string flag) {
+    for (int i=1; i<argc-1; i++) {
+        if (strcmp(flag.c_str(),argv[i]) == 0) return argv[i+1];
     }
     return nullptr;
 }
@@ -121,15 +86,39 @@ bool check_flag(int argc, char** argv, std::string flag) {
 //
 int main(int argc, char** argv) {
     
-    bool dump   = check_flag(argc,argv,"--dump");
+    bool dump     = check_flag(argc,argv,"--dump");
+    bool profile  = check_flag(argc,argv,"--profile");
+    bool trace    = check_flag(argc,argv,"--trace");
+    bool memoize  = check_flag(argc,argv,"--memoize");
+    bool closures = check_flag(argc,argv,"--closures");
+    bool jit      = check_flag(argc,argv,"--jit");
+    bool ir       = check_flag(argc,argv,"--ir");
+    bool x86      = check_flag(argc,argv,"--x86");
     bool pretty = false;
     if (dump) {
         pretty = check_flag(argc,argv,"--pretty");
     }
+    char* stdin_file = flag_value(argc,argv,"--stdin-file");
     char* filename = extract_filename(argc,argv);
     
     if (filename) {
         
+        //
+        // Buffer the program's output (see dwislpy-io.hh).
+        //
+        Outbuf out { };
+        out.install();
+
+        //
+        // Read its input in chunks, or from a mapped file.
+        //
+        Inbuf in { };
+        if (stdin_file && !in.map_file(stdin_file)) {
+            std::cerr << "Unable to read " << stdin_file << "." << std::endl;
+            return 1;
+        }
+        in.install();
+
         DWISLPY::Driver dwislpy { filename };
         
         //
@@ -149,7 +138,18 @@ int main(int argc, char** argv) {
                 dwislpy.dump(pretty);
             } else {
                 dwislpy.check();
+                dwislpy.memoizing = memoize;
+                dwislpy.profiling = profile;
+                dwislpy.tracing = trace;
+                dwislpy.closures = closures;
+                dwislpy.jit_threshold = jit ? JIT_THRESHOLD : 0;
+                dwislpy.ir = ir;
                 dwislpy.run();
+                if (ir && !profile && !trace) {
+                    std::cout.flush();
+                    std::cerr << VM_code::steps << " IR instructions run."
+                              << std::endl;
+                }
             }
 
             //
@@ -160,7 +160,11 @@ int main(int argc, char** argv) {
             //
             // Compile.
             //
-            dwislpy.compile();
+            if (x86) {
+                dwislpy.compile_x86();
+            } else {
+                dwislpy.compile();
+            }
             
         } catch (DwislpyError se) {
             
@@ -0,0 +1,347 @@
+/* SPIM S20 MIPS simulator.
+   Model of first-level instruction and data caches.
+   See cache.h for what is modeled. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spim.h"
+#include "string-stream.h"
+#include "spim-utils.h"
+#include "inst.h"
+#include "reg.h"
+#include "mem.h"
+#include "sym-tbl.h"
+#include "cache.h"
+
+
+/* Exported variables: */
+
+cache_model *spim_cache = NULL;	/* Caches being modeled, or NULL */
+
+
+/* Labels in the text segments, in order of address, for the report. */
+
+typedef struct text_labels
+{
+  label **labels;
+  int count;
+  int size;
+} text_labels;
+
+
+/* Local functions: */
+
+static void add_text_label (label *l, void *arg);
+static bool cache_access (cache_level *c, mem_addr addr);
+static cache_counts *counts_at (mem_addr addr);
+static int compare_labels (const void *p1, const void *p2);
+static cache_level *make_cache_level (char *spec);
+static void print_rate (char *buf, long long misses, long long accesses);
+static void report_level (char *name, cache_level *c);
+static void report_segment (cache_counts *counts, int words, mem_addr bot,
+			    text_labels *labels);
+
+
+
+/* Return a cache described by SPEC, "SIZE:ASSOC:LINE" (its size and
+   line size in bytes, and its associativity), or NULL if SPEC does not
+   describe a cache whose line size and number of sets are powers of 2. */
+
+static cache_level *
+make_cache_level (char *spec)
+{
+  int size, assoc, line_size, sets, shift;
+  cache_level *c;
+
+  if (sscanf (spec, "%d:%d:%d", &size, &assoc, &line_size) != 3
+      || size <= 0 || assoc <= 0 || line_size <= 0
+      || (line_size & (line_size - 1)) != 0
+      || size % (assoc * line_size) != 0)
+    return (NULL);
+  sets = size / (assoc * line_size);
+  if ((sets & (sets - 1)) != 0)
+    return (NULL);
+  for (shift = 0; (1 << shift) < line_size; shift ++) ;
+
+  c = (cache_level *) zmalloc (sizeof (cache_level));
+  c->size = size;
+  c->assoc = assoc;
+  c->line_size = line_size;
+  c->sets = sets;
+  c->line_shift = shift;
+  c->lines = (mem_addr *) zmalloc (sets * assoc * sizeof (mem_addr));
+  c->used = (unsigned long long *) zmalloc (sets * assoc * sizeof (unsigned long long));
+  return (c);
+}
+
+
+/* Return a model of the instruction cache described by L1I_SPEC and the
+   data cache described by L1D_SPEC (see make_cache_level), for the
+   program now in the text segments.  A NULL spec leaves that cache out.
+   Return NULL if either spec is not valid. */
+
+cache_model *
+cache_create (char *l1i_spec, char *l1d_spec)
+{
+  cache_model *cache = (cache_model *) zmalloc (sizeof (cache_model));
+
+  if (l1i_spec != NULL && (cache->l1i = make_cache_level (l1i_spec)) == NULL)
+    {
+      error ("Bad instruction cache: %s (want SIZE:ASSOC:LINE)\n", l1i_spec);
+      cache_free (cache);
+      return (NULL);
+    }
+  if (l1d_spec != NULL && (cache->l1d = make_cache_level (l1d_spec)) == NULL)
+    {
+      error ("Bad data cache: %s (want SIZE:ASSOC:LINE)\n", l1d_spec);
+      cache_free (cache);
+      return (NULL);
+    }
+  cache->text_words = (text_top - TEXT_BOT) / BYTES_PER_WORD;
+  cache->text_counts = (cache_counts *) zmalloc (cache->text_words * sizeof (cache_counts));
+  cache->k_text_words = (k_text_top - K_TEXT_BOT) / BYTES_PER_WORD;
+  cache->k_text_counts = (cache_counts *) zmalloc (cache->k_text_words * sizeof (cache_counts));
+  return (cache);
+}
+
+
+void
+cache_free (cache_model *cache)
+{
+  cache_level *levels[2];
+  int i;
+
+  if (cache == NULL)
+    return;
+  levels[0] = cache->l1i;
+  levels[1] = cache->l1d;
+  for (i = 0; i < 2; i ++)
+    if (levels[i] != NULL)
+      {
+	free (levels[i]->lines);
+	free (levels[i]->used);
+	free (levels[i]);
+      }
+  free (cache->text_counts);
+  free (cache->k_text_counts);
+  free (cache);
+}
+
+
+/* Look up ADDR in the cache C, bringing its line in if it is not there.
+   Return true if it was there. */
+
+static bool
+cache_access (cache_level *c, mem_addr addr)
+{
+  mem_addr line = addr >> c->line_shift;
+  int first = (line & (c->sets - 1)) * c->assoc;
+  int way, victim = first;
+
+  c->clock += 1;
+  c->accesses += 1;
+  for (way = first; way < first + c->assoc; way ++)
+    {
+      if (c->used[way] != 0 && c->lines[way] == line)
+	{
+	  c->used[way] = c->clock;
+	  return (true);
+	}
+      if (c->used[way] < c->used[victim])
+	victim = way;
+    }
+  c->misses += 1;
+  c->lines[victim] = line;
+  c->used[victim] = c->clock;
+  return (false);
+}
+
+
+/* Return the counts of the instruction at ADDR, or NULL if ADDR is not
+   in the text segments as they were when the model was made. */
+
+static cache_counts *
+counts_at (mem_addr addr)
+{
+  if (addr >= TEXT_BOT && addr < TEXT_BOT + spim_cache->text_words * BYTES_PER_WORD)
+    return (&spim_cache->text_counts [(addr - TEXT_BOT) >> 2]);
+  else if (addr >= K_TEXT_BOT
+	   && addr < K_TEXT_BOT + spim_cache->k_text_words * BYTES_PER_WORD)
+    return (&spim_cache->k_text_counts [(addr - K_TEXT_BOT) >> 2]);
+  else
+    return (NULL);
+}
+
+
+/* Count the fetch of the instruction at ADDR. */
+
+void
+cache_fetch (mem_addr addr)
+{
+  cache_counts *counts;
+  bool hit;
+
+  if (spim_cache->l1i == NULL)
+    return;
+  hit = cache_access (spim_cache->l1i, addr);
+  if ((counts = counts_at (addr)) != NULL)
+    {
+      counts->fetches += 1;
+      counts->fetch_misses += !hit;
+    }
+}
+
+
+/* Count a read or write of the data at ADDR, made by the instruction at
+   PC. */
+
+void
+cache_data_access (mem_addr addr)
+{
+  cache_counts *counts;
+  bool hit;
+
+  if (spim_cache->l1d == NULL)
+    return;
+  hit = cache_access (spim_cache->l1d, addr);
+  if ((counts = counts_at (PC)) != NULL)
+    {
+      counts->accesses += 1;
+      counts->misses += !hit;
+    }
+}
+
+
+
+/* Reporting. */
+
+static void
+add_text_label (label *l, void *arg)
+{
+  text_labels *labels = (text_labels *) arg;
+
+  if (!SYMBOL_IS_DEFINED (l)
+      || !(((mem_addr) l->addr >= TEXT_BOT && (mem_addr) l->addr < text_top)
+	   || ((mem_addr) l->addr >= K_TEXT_BOT && (mem_addr) l->addr < k_text_top)))
+    return;
+  if (labels->count == labels->size)
+    {
+      labels->size = labels->size == 0 ? 64 : 2 * labels->size;
+      labels->labels = (label **) realloc (labels->labels, labels->size * sizeof (label *));
+      if (labels->labels == NULL)
+	fatal_error ("Out of memory at request for %d bytes.\n",
+		     labels->size * (int) sizeof (label *));
+    }
+  labels->labels [labels->count ++] = l;
+}
+
+
+static int
+compare_labels (const void *p1, const void *p2)
+{
+  label *l1 = *(label **) p1;
+  label *l2 = *(label **) p2;
+
+  if (l1->addr != l2->addr)
+    return (l1->addr < l2->addr ? -1 : 1);
+  return (strcmp (l1->name, l2->name));
+}
+
+
+static void
+print_rate (char *buf, long long misses, long long accesses)
+{
+  if (accesses == 0)
+    strcpy (buf, "-");
+  else
+    sprintf (buf, "%.4f", (double) misses / (double) accesses);
+}
+
+
+static void
+report_level (char *name, cache_level *c)
+{
+  char rate[32];
+
+  if (c == NULL)
+    return;
+  print_rate (rate, c->misses, c->accesses);
+  error ("%s\t%d\t%d\t%d\t%lld\t%lld\t%s\n", name, c->size, c->assoc,
+	 c->line_size, c->accesses, c->misses, rate);
+}
+
+
+/* Report the COUNTS of the WORDS of the text segment starting at BOT,
+   summed by the nearest of LABELS (sorted) below each word. */
+
+static void
+report_segment (cache_counts *counts, int words, mem_addr bot,
+		text_labels *labels)
+{
+  int i, l = 0;
+  int current = -1;		/* Index of the label being summed */
+  long long sums[4] = {0, 0, 0, 0};
+
+  for (i = 0; i <= words; i ++)
+    {
+      mem_addr addr = bot + i * BYTES_PER_WORD;
+      int nearest = current;
+
+      while (i < words && l < labels->count && (mem_addr) labels->labels [l]->addr <= addr)
+	{
+	  if ((mem_addr) labels->labels [l]->addr >= bot)
+	    nearest = l;
+	  l += 1;
+	}
+      if (nearest != current || i == words)
+	{
+	  if (sums[0] != 0 || sums[2] != 0)
+	    {
+	      char fetch_rate[32], rate[32];
+
+	      print_rate (fetch_rate, sums[1], sums[0]);
+	      print_rate (rate, sums[3], sums[2]);
+	      error ("%s\t%lld\t%lld\t%s\t%lld\t%lld\t%s\n",
+		     current < 0 ? "-" : labels->labels [current]->name,
+		     sums[0], sums[1], fetch_rate, sums[2], sums[3], rate);
+	    }
+	  current = nearest;
+	  memset (sums, 0, sizeof (sums));
+	}
+      if (i < words)
+	{
+	  sums[0] += counts[i].fetches;
+	  sums[1] += counts[i].fetch_misses;
+	  sums[2] += counts[i].accesses;
+	  sums[3] += counts[i].misses;
+	}
+    }
+}
+
+
+/* Report, on standard error, the accesses to and misses in each cache,
+   and then the fetches, data accesses, and misses of each text label
+   (the instructions from it up to the next label), all as lines of
+   fields separated by tabs, each table after a line naming its
+   fields. */
+
+void
+cache_report (cache_model *cache)
+{
+  text_labels labels = {NULL, 0, 0};
+
+  error ("cache\tsize\tassoc\tline\taccesses\tmisses\tmiss_rate\n");
+  report_level ("l1i", cache->l1i);
+  report_level ("l1d", cache->l1d);
+
+  map_symbols (add_text_label, &labels);
+  if (labels.count > 0)
+    qsort (labels.labels, labels.count, sizeof (label *), compare_labels);
+  error ("label\tfetches\tfetch_misses\tfetch_miss_rate\taccesses\tmisses\tmiss_rate\n");
+  report_segment (cache->text_counts, cache->text_words, TEXT_BOT, &labels);
+  report_segment (cache->k_text_counts, cache->k_text_words, K_TEXT_BOT, &labels);
+  free (labels.labels);
+}
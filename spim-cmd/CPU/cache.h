@@ -0,0 +1,67 @@
+/* SPIM S20 MIPS simulator.
+   Model of first-level instruction and data caches.
+
+   Each cache is set-associative, with least-recently-used replacement,
+   and allocates a line on every miss, whether a read or a write.  The
+   model only counts hits and misses; it does not change what the
+   program computes or how long spim takes to run it.
+
+   run_spim reports each instruction fetch, and the address of each load
+   and store (before it executes), to the model in spim_cache.  An
+   access of a double counts as one access.  Counts are kept for each instruction,
+   attributing a data access to the instruction making it, and are
+   summed by the nearest text label below each instruction when the
+   model reports. */
+
+
+#ifndef CACHE_H
+#define CACHE_H
+
+typedef struct cache_level
+{
+  int size;			/* Bytes */
+  int assoc;			/* Ways in each set */
+  int line_size;		/* Bytes */
+  int sets;
+  int line_shift;		/* log2 (line_size) */
+  mem_addr *lines;		/* Line held in each way, sets * assoc */
+  unsigned long long *used;	/* When each way was last used, 0 => empty */
+  unsigned long long clock;
+  long long accesses, misses;
+} cache_level;
+
+
+/* Counts for one instruction: */
+
+typedef struct cache_counts
+{
+  uint32 fetches, fetch_misses;
+  uint32 accesses, misses;	/* Data accesses */
+} cache_counts;
+
+
+typedef struct cache_model
+{
+  cache_level *l1i;		/* NULL => fetches are not modeled */
+  cache_level *l1d;		/* NULL => data accesses are not modeled */
+  cache_counts *text_counts;	/* For each word of the text segment */
+  int text_words;
+  cache_counts *k_text_counts;	/* For each word of the kernel text */
+  int k_text_words;
+} cache_model;
+
+
+/* Exported variables: */
+
+extern cache_model *spim_cache;	/* Caches being modeled, or NULL */
+
+
+/* Exported functions: */
+
+cache_model *cache_create (char *l1i_spec, char *l1d_spec);
+void cache_data_access (mem_addr addr);
+void cache_fetch (mem_addr addr);
+void cache_free (cache_model *cache);
+void cache_report (cache_model *cache);
+
+#endif
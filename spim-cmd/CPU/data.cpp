@@ -76,6 +76,7 @@ user_kernel_data_segment (bool to_kernel)
 void
 end_of_assembly_file ()
 {
+  resolve_label_uses ();
   in_kernel = false;
   auto_alignment = true;
 }
@@ -218,7 +219,7 @@ lcomm_directive (char *name, int size)
       && size > 0 && size <= SMALL_DATA_SEG_MAX_SIZE
       && next_gp_item_addr + size < gp_midpoint + 32*K)
     {
-      label *sym = record_label (name, next_gp_item_addr, 1);
+      label *sym = record_label (name, next_gp_item_addr);
       sym->gp_flag = 1;
 
       next_gp_item_addr += size;
@@ -226,7 +227,7 @@ lcomm_directive (char *name, int size)
     }
   else
     {
-      (void)record_label (name, next_data_pc, 1);
+      (void)record_label (name, next_data_pc);
 
       for ( ; size > 0; size --)
 	{
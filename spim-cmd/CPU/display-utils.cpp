@@ -176,7 +176,8 @@ format_registers (str_stream *ss, int print_gpr_hex, int print_fpr_hex)
 
 
 /* Write to the stream a printable representation of the instructions in
-   memory addresses: FROM...TO. */
+   memory addresses: FROM...TO.  If the stream has a sink (see ss_sink),
+   the lines go to it as they are finished. */
 
 void
 format_insts (str_stream *ss, mem_addr from, mem_addr to)
@@ -190,6 +191,7 @@ format_insts (str_stream *ss, mem_addr from, mem_addr to)
       if (inst != NULL)
 	{
 	  format_an_inst (ss, inst, i);
+	  ss_flush (ss);
 	}
     }
 }
@@ -216,7 +218,7 @@ format_data_segs (str_stream *ss)
 
 
 /* Write to the stream a printable representation of the data in memory
-   address: FROM...TO. */
+   address: FROM...TO.  As with format_insts, a sink gets finished lines. */
 
 void
 format_mem (str_stream *ss, mem_addr from, mem_addr to)
@@ -248,6 +250,7 @@ format_mem (str_stream *ss, mem_addr from, mem_addr to)
 
 	  i = i + (uint32) j * BYTES_PER_WORD;
 	  i = format_partial_line (ss, i);
+	  ss_flush (ss);
 	}
       else
 	{
@@ -262,6 +265,7 @@ format_mem (str_stream *ss, mem_addr from, mem_addr to)
 	  while (i % BYTES_PER_LINE != 0);
 
 	  ss_printf (ss, "\n");
+	  ss_flush (ss);
 	}
     }
 }
@@ -841,13 +841,10 @@ format_an_inst (str_stream *ss, instruction *inst, mem_addr addr)
     {
       /* Comment is source line text of current line. */
       int gap_length = 57 - (ss_length (ss) - line_start);
-      for ( ; 0 < gap_length; gap_length -= 1)
-	{
-	  ss_printf (ss, " ");
-	}
+      if (0 < gap_length)
+	ss_printf (ss, "%*s", gap_length, "");
 
-      ss_printf (ss, "; ");
-      ss_printf (ss, "%s", SOURCE (inst));
+      ss_printf (ss, "; %s", SOURCE (inst));
     }
 
   ss_printf (ss, "\n");
@@ -58,33 +58,35 @@ typedef struct addrexpr
    overlapping manner similar to the real encoding (but not identical, to
    speed decoding in C code, as opposed to hardware).. */
 
-typedef struct inst_s
+typedef union
 {
-  short opcode;
-
-  union
+  /* R-type or I-type: */
+  struct
     {
-      /* R-type or I-type: */
-      struct
+      unsigned char rs;
+      unsigned char rt;
+
+      union
 	{
-	  unsigned char rs;
-	  unsigned char rt;
+	  short imm;
 
-	  union
+	  struct
 	    {
-	      short imm;
-
-	      struct
-		{
-		  unsigned char rd;
-		  unsigned char shamt;
-		} r;
-	    } r_i;
+	      unsigned char rd;
+	      unsigned char shamt;
+	    } r;
 	} r_i;
+    } r_i;
 
-      /* J-type: */
-      mem_addr target;
-    } r_t;
+  /* J-type: */
+  mem_addr target;
+} inst_fields;
+
+
+typedef struct inst_s
+{
+  short opcode;
+  inst_fields r_t;
 
   int32 encoding;
   imm_expr *expr;
@@ -92,6 +94,27 @@ typedef struct inst_s
 } instruction;
 
 
+/* The decoded fields of an instruction alone, as run_spim executes
+   them.  The text segments keep a contiguous array of these alongside
+   their instructions (see mem.h), so that the simulator's inner loop
+   reads 8 dense bytes per instruction rather than following a pointer
+   to a separately allocated instruction.  The fields macros below apply
+   to both types.  An opcode of 0 marks a word that cannot run: no
+   instruction, or one that uses an undefined label.
+
+   This is an array of records rather than separate arrays of opcodes
+   and of fields: every step dispatches on the opcode and then reads
+   the fields of that same instruction, so keeping the two in one
+   8-byte record makes each step touch one cache line rather than
+   two.  The cold parts of an instruction stay out of it either way. */
+
+typedef struct
+{
+  short opcode;
+  inst_fields r_t;
+} inst_code;
+
+
 #define OPCODE(INST)		(INST)->opcode
 #define SET_OPCODE(INST, VAL)	(INST)->opcode = (short)(VAL)
 
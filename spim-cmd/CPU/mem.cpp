@@ -37,6 +37,7 @@
 #include "inst.h"
 #include "reg.h"
 #include "mem.h"
+#include "sym-tbl.h"
 
 /* Exported Variables: */
 
@@ -50,6 +51,7 @@ int *FWR;			/* is possible */
 reg_word CCR[4][32], CPR[4][32];
 
 instruction **text_seg;
+inst_code *text_code;
 bool text_modified;		/* => text segment was written */
 mem_addr text_top;
 mem_word *data_seg;
@@ -63,6 +65,7 @@ short *stack_seg_h;		/* Points to same vector as STACK_SEG */
 BYTE_TYPE *stack_seg_b;		/* Ditto */
 mem_addr stack_bot;
 instruction **k_text_seg;
+inst_code *k_text_code;
 mem_addr k_text_top;
 mem_word *k_data_seg;
 short *k_data_seg_h;
@@ -77,6 +80,7 @@ static void bad_mem_write (mem_addr addr, mem_word value, int mask);
 static instruction *bad_text_read (mem_addr addr);
 static void bad_text_write (mem_addr addr, instruction *inst);
 static void free_instructions (instruction **inst, int n);
+static void code_inst (inst_code *code, instruction *inst);
 static mem_word read_memory_mapped_IO (mem_addr addr);
 static void write_memory_mapped_IO (mem_addr addr, mem_word value);
 
@@ -85,6 +89,16 @@ static void write_memory_mapped_IO (mem_addr addr, mem_word value);
 
 static int32 data_size_limit, stack_size_limit, k_data_size_limit;
 
+/* The text_code arrays mirror the text segments.  Each store of an
+   instruction updates its entry, but the assembler goes on to patch
+   instructions in place (e.g., to resolve labels), so a store also
+   marks the arrays stale, and run_spim resynchronizes them before it
+   runs. */
+
+static bool text_code_stale;
+
+static int text_code_used, k_text_code_used; /* Entries ever stored */
+
 
 
 /* Memory is allocated in five chunks:
@@ -116,6 +130,8 @@ static int32 data_size_limit, stack_size_limit, k_data_size_limit;
 
 #define BYTES_TO_INST(N) (((N) + BYTES_PER_WORD - 1) / BYTES_PER_WORD * sizeof(instruction*))
 
+#define BYTES_TO_CODE(N) (((N) + BYTES_PER_WORD - 1) / BYTES_PER_WORD * sizeof(inst_code))
+
 
 void
 make_memory (int text_size, int data_size, int data_limit,
@@ -135,6 +151,9 @@ make_memory (int text_size, int data_size, int data_limit,
     }
   memclr (text_seg, BYTES_TO_INST(text_size));
   text_top = TEXT_BOT + text_size;
+  free (text_code);
+  text_code = (inst_code *) zmalloc (BYTES_TO_CODE(text_size));
+  text_code_used = 0;
 
   data_size = ROUND_UP(data_size, BYTES_PER_WORD); /* Keep word aligned */
   if (data_seg == NULL)
@@ -169,6 +188,9 @@ make_memory (int text_size, int data_size, int data_limit,
     }
   memclr (k_text_seg, BYTES_TO_INST(k_text_size));
   k_text_top = K_TEXT_BOT + k_text_size;
+  free (k_text_code);
+  k_text_code = (inst_code *) zmalloc (BYTES_TO_CODE(k_text_size));
+  k_text_code_used = 0;
 
   k_data_size = ROUND_UP(k_data_size, BYTES_PER_WORD); /* Keep word aligned */
   if (k_data_seg == NULL)
@@ -373,15 +395,64 @@ void
 set_mem_inst(mem_addr addr, instruction* inst)
 {
   text_modified = true;
+  text_code_stale = true;
   if ((addr >= TEXT_BOT) && (addr < text_top) && !(addr & 0x3))
-    text_seg [(addr - TEXT_BOT) >> 2] = inst;
+    {
+      int i = (addr - TEXT_BOT) >> 2;
+
+      text_seg [i] = inst;
+      code_inst (&text_code [i], inst);
+      text_code_used = MAX (text_code_used, i + 1);
+    }
   else if ((addr >= K_TEXT_BOT) && (addr < k_text_top) && !(addr & 0x3))
-    k_text_seg [(addr - K_TEXT_BOT) >> 2] = inst;
+    {
+      int i = (addr - K_TEXT_BOT) >> 2;
+
+      k_text_seg [i] = inst;
+      code_inst (&k_text_code [i], inst);
+      k_text_code_used = MAX (k_text_code_used, i + 1);
+    }
   else
     bad_text_write (addr, inst);
 }
 
 
+/* Set CODE to the decoded fields of INST. */
+
+static void
+code_inst (inst_code *code, instruction *inst)
+{
+  if (inst == NULL
+      || (EXPR (inst) != NULL
+	  && EXPR (inst)->symbol != NULL
+	  && EXPR (inst)->symbol->addr == 0))
+    code->opcode = 0;
+  else
+    {
+      code->opcode = OPCODE (inst);
+      code->r_t = inst->r_t;
+    }
+}
+
+
+/* Bring the text_code arrays up to date with the instructions in the
+   text segments, if any may have changed in place. */
+
+void
+sync_inst_code ()
+{
+  int i;
+
+  if (!text_code_stale)
+    return;
+  for (i = 0; i < text_code_used; i ++)
+    code_inst (&text_code [i], text_seg [i]);
+  for (i = 0; i < k_text_code_used; i ++)
+    code_inst (&k_text_code [i], k_text_seg [i]);
+  text_code_stale = false;
+}
+
+
 void
 set_mem_byte(mem_addr addr, reg_word value)
 {
@@ -551,6 +622,9 @@ bad_mem_write (mem_addr addr, mem_word value, int mask)
       free_inst (text_seg[(addr - TEXT_BOT) >> 2]);
     }
     text_seg [(addr - TEXT_BOT) >> 2] = inst_decode (tmp);
+    code_inst (&text_code [(addr - TEXT_BOT) >> 2],
+	       text_seg [(addr - TEXT_BOT) >> 2]);
+    text_code_used = MAX (text_code_used, (int) ((addr - TEXT_BOT) >> 2) + 1);
 
     text_modified = true;
   }
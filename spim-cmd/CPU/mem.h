@@ -44,6 +44,8 @@ typedef int32 /*@alt unsigned int @*/ mem_word;
 
 extern instruction **text_seg;
 
+extern inst_code *text_code;	/* Decoded copy of text_seg for run_spim */
+
 extern bool text_modified;	/* => text segment was written */
 
 #define TEXT_BOT ((mem_addr) 0x400000)
@@ -95,6 +97,8 @@ extern mem_addr stack_bot;
 
 extern instruction **k_text_seg;
 
+extern inst_code *k_text_code;
+
 #define K_TEXT_BOT ((mem_addr) 0x80000000)
 
 extern mem_addr k_text_top;
@@ -152,6 +156,7 @@ void make_memory (int text_size, int data_size, int data_limit,
 void* mem_reference(mem_addr addr);
 void print_mem (mem_addr addr);
 instruction* read_mem_inst(mem_addr addr);
+void sync_inst_code ();
 reg_word read_mem_byte(mem_addr addr);
 reg_word read_mem_half(mem_addr addr);
 reg_word read_mem_word(mem_addr addr);
@@ -159,3 +164,19 @@ void set_mem_inst(mem_addr addr, instruction* inst);
 void set_mem_byte(mem_addr addr, reg_word value);
 void set_mem_half(mem_addr addr, reg_word value);
 void set_mem_word(mem_addr addr, reg_word value);
+
+
+/* Return the decoded instruction at ADDR, or NULL if ADDR is not an
+   instruction address.  Call sync_inst_code first if instructions may
+   have been changed in place since they were stored. */
+
+static inline inst_code *
+read_inst_code (mem_addr addr)
+{
+  if ((addr >= TEXT_BOT) && (addr < text_top) && !(addr & 0x3))
+    return &text_code [(addr - TEXT_BOT) >> 2];
+  else if ((addr >= K_TEXT_BOT) && (addr < k_text_top) && !(addr & 0x3))
+    return &k_text_code [(addr - K_TEXT_BOT) >> 2];
+  else
+    return NULL;
+}
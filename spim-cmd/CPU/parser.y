@@ -522,15 +522,14 @@ LBL_CMD:	OPT_LBL CMD
 OPT_LBL: ID ':' {
 		  /* Call outside of cons_label, since an error sets that variable to NULL. */
 		  label* l = record_label ((char*)$1.p,
-					   text_dir ? current_text_pc () : current_data_pc (),
-					   0);
+					   text_dir ? current_text_pc () : current_data_pc ());
 		  this_line_labels = cons_label (l, this_line_labels);
 		  free ((char*)$1.p);
 		}
 
 	|	ID '=' EXPR
 		{
-		  label *l = record_label ((char*)$1.p, (mem_addr)$3.i, 1);
+		  label *l = record_label ((char*)$1.p, (mem_addr)$3.i);
 		  free ((char*)$1.p);
 
 		  l->const_flag = 1;
@@ -2138,7 +2137,7 @@ ASM_DIRECTIVE:	Y_ALIAS_DIR	Y_REG	Y_REG
 		  align_data (2);
 		  if (lookup_label ((char*)$2.p)->addr == 0)
 		  {
-		    (void)record_label ((char*)$2.p, current_data_pc (), 1);
+		    (void)record_label ((char*)$2.p, current_data_pc ());
 		    free ((char*)$2.p);
 		  }
 		  increment_data_pc ($3.i);
@@ -2253,8 +2252,7 @@ ASM_DIRECTIVE:	Y_ALIAS_DIR	Y_REG	Y_REG
 	|	Y_LABEL_DIR	ID
 		{
 		  (void)record_label ((char*)$2.p,
-				      text_dir ? current_text_pc () : current_data_pc (),
-				      1);
+				      text_dir ? current_text_pc () : current_data_pc ());
 		  free ((char*)$2.p);
 		}
 
@@ -2693,7 +2691,6 @@ clear_labels ()
 
   for ( ; this_line_labels != NULL; this_line_labels = n)
     {
-      resolve_label_uses (this_line_labels->head);
       n = this_line_labels->tail;
       free (this_line_labels);
     }
@@ -0,0 +1,382 @@
+/* SPIM S20 MIPS simulator.
+   Sampling profiler that records call stacks.
+   See profile.h for how stacks are found. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spim.h"
+#include "string-stream.h"
+#include "spim-utils.h"
+#include "inst.h"
+#include "reg.h"
+#include "mem.h"
+#include "sym-tbl.h"
+#include "parser_yacc.h"
+#include "profile.h"
+
+
+/* Exported variables: */
+
+profile_model *spim_profile = NULL; /* Profile being taken, or NULL */
+
+
+/* Offsets from $fp of the registers ENTER saves. */
+
+#define SAVED_RA_OFFSET		(-4)
+#define SAVED_FP_OFFSET		(-8)
+
+/* Instructions of ENTER that run before it sets $fp. */
+
+#define PROLOGUE_WORDS		3
+
+
+/* Local functions: */
+
+static void add_func (profile_model *profile, mem_addr addr);
+static void add_global_label (label *l, void *arg);
+static int compare_funcs (const void *p1, const void *p2);
+static int find_func (profile_model *profile, mem_addr addr);
+static void free_nodes (profile_node *node);
+static bool frame_is_set_up (profile_model *profile, int func);
+static bool is_return (mem_addr addr);
+static void name_func (label *l, void *arg);
+static int next_countdown (profile_model *profile);
+static bool read_stack_word (mem_addr addr, mem_addr *value);
+static void scan_calls (profile_model *profile, mem_addr bot, mem_addr top);
+static void write_nodes (FILE *fp, profile_model *profile, profile_node *node,
+			 int *chain, int depth);
+
+
+
+/* Return a profile that samples every INTERVAL instructions, on
+   average, with the functions of the loaded program. */
+
+profile_model *
+profile_create (int interval)
+{
+  profile_model *profile = (profile_model *) zmalloc (sizeof (profile_model));
+  int i, n;
+
+  profile->interval = interval < 1 ? 1 : interval;
+  profile->seed = 0x2545f491;
+  profile->root.func = -1;
+
+  sync_inst_code ();
+  scan_calls (profile, TEXT_BOT, text_top);
+  scan_calls (profile, K_TEXT_BOT, k_text_top);
+  map_symbols (add_global_label, profile);
+
+  if (profile->func_count > 0)
+    qsort (profile->funcs, profile->func_count, sizeof (profile_func), compare_funcs);
+  for (i = 0, n = 0; i < profile->func_count; i ++)
+    if (n == 0 || profile->funcs[n - 1].addr != profile->funcs[i].addr)
+      profile->funcs[n ++] = profile->funcs[i];
+  profile->func_count = n;
+  map_symbols (name_func, profile);
+
+  profile->countdown = next_countdown (profile);
+  return (profile);
+}
+
+
+void
+profile_free (profile_model *profile)
+{
+  int i;
+
+  if (profile == NULL)
+    return;
+  free_nodes (profile->root.child);
+  for (i = 0; i < profile->func_count; i ++)
+    free (profile->funcs[i].name);
+  free (profile->funcs);
+  free (profile);
+}
+
+
+static void
+free_nodes (profile_node *node)
+{
+  while (node != NULL)
+    {
+      profile_node *next = node->sibling;
+
+      free_nodes (node->child);
+      free (node);
+      node = next;
+    }
+}
+
+
+/* Add each function called by a jal between BOT and TOP. */
+
+static void
+scan_calls (profile_model *profile, mem_addr bot, mem_addr top)
+{
+  mem_addr addr;
+
+  for (addr = bot; addr < top; addr += BYTES_PER_WORD)
+    {
+      inst_code *inst = read_inst_code (addr);
+
+      if (inst != NULL && OPCODE (inst) == Y_JAL_OP)
+	add_func (profile, (addr & 0xf0000000) | (TARGET (inst) << 2));
+    }
+}
+
+
+static void
+add_global_label (label *l, void *arg)
+{
+  if (SYMBOL_IS_DEFINED (l) && l->global_flag
+      && read_inst_code ((mem_addr) l->addr) != NULL)
+    add_func ((profile_model *) arg, (mem_addr) l->addr);
+}
+
+
+static void
+add_func (profile_model *profile, mem_addr addr)
+{
+  if (profile->func_count == profile->func_size)
+    {
+      profile->func_size = profile->func_size == 0 ? 64 : 2 * profile->func_size;
+      profile->funcs = (profile_func *) realloc (profile->funcs,
+						 profile->func_size * sizeof (profile_func));
+      if (profile->funcs == NULL)
+	fatal_error ("Out of memory at request for %d bytes.\n",
+		     profile->func_size * (int) sizeof (profile_func));
+    }
+  profile->funcs[profile->func_count].addr = addr;
+  profile->funcs[profile->func_count].name = NULL;
+  profile->func_count ++;
+}
+
+
+static int
+compare_funcs (const void *p1, const void *p2)
+{
+  mem_addr a1 = ((profile_func *) p1)->addr;
+  mem_addr a2 = ((profile_func *) p2)->addr;
+
+  return (a1 < a2 ? -1 : (a1 > a2 ? 1 : 0));
+}
+
+
+/* Name a function by the first label found at its start. */
+
+static void
+name_func (label *l, void *arg)
+{
+  profile_model *profile = (profile_model *) arg;
+  int func;
+
+  if (!SYMBOL_IS_DEFINED (l))
+    return;
+  func = find_func (profile, (mem_addr) l->addr);
+  if (func >= 0 && profile->funcs[func].addr == (mem_addr) l->addr
+      && profile->funcs[func].name == NULL)
+    profile->funcs[func].name = str_copy (l->name);
+}
+
+
+/* Return the index of the function containing ADDR, the last that
+   starts at or before it, or -1 if there is none. */
+
+static int
+find_func (profile_model *profile, mem_addr addr)
+{
+  int lo = 0, hi = profile->func_count; /* Answer is in [lo - 1, hi) */
+
+  while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+
+      if (profile->funcs[mid].addr <= addr)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return (lo - 1);
+}
+
+
+static int
+next_countdown (profile_model *profile)
+{
+  uint32 x = profile->seed;
+
+  if (profile->interval == 1)
+    return (1);
+  /* xorshift32 */
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  profile->seed = x;
+  return (profile->interval / 2 + (int) (x % (uint32) profile->interval));
+}
+
+
+/* Record a sample of the PC and the calls that reached it. */
+
+void
+profile_sample (profile_model *profile)
+{
+  int chain[PROFILE_MAX_DEPTH]; /* Innermost function first */
+  int depth = 0;
+  int func = find_func (profile, PC);
+  mem_addr fp = R[REG_FP];
+  mem_addr ra;
+  bool set_up = false;
+  profile_node *node;
+  int i;
+
+  chain[depth ++] = func;
+  if (PC >= K_TEXT_BOT)
+    ra = 0;			/* Kernel code keeps no frames */
+  else if ((set_up = frame_is_set_up (profile, func)))
+    {
+      if (!read_stack_word (fp + SAVED_RA_OFFSET, &ra))
+	ra = 0;
+    }
+  else
+    ra = R[REG_RA];
+
+  /* Each return address is just past a call in the caller.  Stop at
+     a return into kernel code or where the chain of frames ends. */
+  while (ra != 0 && ra < K_TEXT_BOT && depth < PROFILE_MAX_DEPTH)
+    {
+      mem_addr call = ra - (delayed_branches ? 2 : 1) * BYTES_PER_WORD;
+      mem_addr next_fp;
+
+      if (read_inst_code (call) == NULL || (func = find_func (profile, call)) < 0)
+	break;
+      chain[depth ++] = func;
+      if (set_up)
+	{
+	  /* Frames grow down, so older ones are at higher addresses. */
+	  if (!read_stack_word (fp + SAVED_FP_OFFSET, &next_fp) || next_fp <= fp)
+	    break;
+	  fp = next_fp;
+	}
+      set_up = true;
+      if (!read_stack_word (fp + SAVED_RA_OFFSET, &ra))
+	break;
+    }
+
+  node = &profile->root;
+  for (i = depth - 1; i >= 0; i --)
+    {
+      profile_node *child;
+
+      for (child = node->child; child != NULL; child = child->sibling)
+	if (child->func == chain[i])
+	  break;
+      if (child == NULL)
+	{
+	  child = (profile_node *) zmalloc (sizeof (profile_node));
+	  child->func = chain[i];
+	  child->sibling = node->child;
+	  node->child = child;
+	}
+      node = child;
+    }
+  node->samples ++;
+  profile->samples ++;
+  profile->countdown = next_countdown (profile);
+}
+
+
+/* Return true if the PC is where FUNC's $fp is its own: not in the
+   prologue before ENTER sets $fp, and not after LEAVE restores it. */
+
+static bool
+frame_is_set_up (profile_model *profile, int func)
+{
+  inst_code *inst;
+
+  if (func < 0 || PC - profile->funcs[func].addr < PROLOGUE_WORDS * BYTES_PER_WORD)
+    return (false);
+  if (is_return (PC))
+    return (false);
+  inst = read_inst_code (PC);
+  return (inst == NULL
+	  || !((OPCODE (inst) == Y_ADDI_OP || OPCODE (inst) == Y_ADDIU_OP)
+	       && RS (inst) == REG_SP && RT (inst) == REG_SP
+	       && is_return (PC + BYTES_PER_WORD)));
+}
+
+
+static bool
+is_return (mem_addr addr)
+{
+  inst_code *inst = read_inst_code (addr);
+
+  return (inst != NULL && OPCODE (inst) == Y_JR_OP && RS (inst) == REG_RA);
+}
+
+
+/* Read the stack word at ADDR into VALUE, without raising an exception
+   if ADDR is not in the stack.  Return false if it is not. */
+
+static bool
+read_stack_word (mem_addr addr, mem_addr *value)
+{
+  if (addr < stack_bot || addr >= STACK_TOP || (addr & 0x3))
+    return (false);
+  *value = (mem_addr) stack_seg [(addr - stack_bot) >> 2];
+  return (true);
+}
+
+
+/* Write the samples of PROFILE as folded stacks to FILE_NAME.  Return
+   false if the file cannot be written. */
+
+bool
+profile_write (profile_model *profile, char *file_name)
+{
+  int chain[PROFILE_MAX_DEPTH];
+  FILE *fp = fopen (file_name, "w");
+  bool ok;
+
+  if (fp == NULL)
+    return (false);
+  write_nodes (fp, profile, profile->root.child, chain, 0);
+  ok = !ferror (fp);
+  if (fclose (fp) != 0)
+    ok = false;
+  return (ok);
+}
+
+
+static void
+write_nodes (FILE *fp, profile_model *profile, profile_node *node,
+	     int *chain, int depth)
+{
+  int i;
+
+  for ( ; node != NULL; node = node->sibling)
+    {
+      chain[depth] = node->func;
+      if (node->samples > 0)
+	{
+	  for (i = 0; i <= depth; i ++)
+	    {
+	      int func = chain[i];
+
+	      if (i > 0)
+		putc (';', fp);
+	      if (func < 0)
+		fputs ("[unknown]", fp);
+	      else if (profile->funcs[func].name != NULL)
+		fputs (profile->funcs[func].name, fp);
+	      else
+		fprintf (fp, "0x%08x", profile->funcs[func].addr);
+	    }
+	  fprintf (fp, " %lld\n", node->samples);
+	}
+      write_nodes (fp, profile, node->child, chain, depth + 1);
+    }
+}
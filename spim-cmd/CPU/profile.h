@@ -0,0 +1,81 @@
+/* SPIM S20 MIPS simulator.
+   Sampling profiler that records call stacks.
+
+   Every so many instructions (the interval, jittered so that samples
+   do not fall into step with a loop), the profiler records the PC and
+   the chain of calls that led to it, and at exit writes the number of
+   samples of each distinct chain as a "folded stack", one per line:
+
+	main;fib;fib 42
+
+   naming each frame by the function that contains it, outermost
+   first, as flame graph tools expect.  A function starts at the target
+   of some jal or at a global label, and is named by a label at its
+   start.
+
+   The chain is found by walking the frames that DwiSlpy's compiler
+   lays out (see ENTER::toMIPS): on entry a function saves $ra at
+   $fp-4 and the caller's $fp at $fp-8, relative to its own $fp.  While
+   the PC is in the first three instructions of a function, or past the
+   restore of $fp at its end, $fp is still the caller's, and $ra holds
+   the current return address.  Samples in code that keeps some other
+   frame layout record only the frames that can be found this way.
+
+   When it is on, run_spim counts down one per instruction to the next
+   sample of spim_profile. */
+
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/* Instructions between samples, on average, by default. */
+
+#define PROFILE_DEFAULT_INTERVAL	1000
+
+/* Deepest call chain recorded; older frames are dropped. */
+
+#define PROFILE_MAX_DEPTH		256
+
+
+typedef struct profile_func
+{
+  mem_addr addr;		/* First instruction */
+  char *name;			/* Label there, or NULL */
+} profile_func;
+
+
+typedef struct profile_node
+{
+  int func;			/* Index into funcs, -1 for the root */
+  long long samples;		/* Samples with this chain exactly */
+  struct profile_node *child;	/* First function it calls */
+  struct profile_node *sibling; /* Next function its caller calls */
+} profile_node;
+
+
+typedef struct profile_model
+{
+  int interval;			/* Mean instructions between samples */
+  int countdown;		/* Instructions until the next sample */
+  uint32 seed;			/* Jitter's random number state */
+  profile_func *funcs;		/* Sorted by address */
+  int func_count;
+  int func_size;		/* Entries allocated in funcs */
+  profile_node root;		/* Tree of the chains sampled */
+  long long samples;
+} profile_model;
+
+
+/* Exported variables: */
+
+extern profile_model *spim_profile; /* Profile being taken, or NULL */
+
+
+/* Exported functions: */
+
+profile_model *profile_create (int interval);
+void profile_free (profile_model *profile);
+void profile_sample (profile_model *profile);
+bool profile_write (profile_model *profile, char *file_name);
+
+#endif
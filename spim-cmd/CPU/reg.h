@@ -67,6 +67,12 @@ extern mem_addr PC, nPC;
 
 #define REG_GP		28
 
+
+/* Frame pointer and return address registers */
+
+#define REG_FP		30
+#define REG_RA		31
+
 extern char *int_reg_names[];
 
 
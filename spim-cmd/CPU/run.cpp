@@ -58,11 +58,21 @@
 #include "reg.h"
 #include "mem.h"
 #include "sym-tbl.h"
+#include "trace-ring.h"
 #include "parser_yacc.h"
 #include "syscall.h"
 #include "run.h"
+#include "cache.h"
+#include "timing.h"
+#include "profile.h"
 
 bool force_break = false;	/* For the execution env. to force an execution break */
+trace_ring *spim_trace = NULL;	/* Trace being recorded, or NULL */
+int spim_trace_interval = 1000;	/* Steps between PC samples in trace */
+long long spim_steps = 0;	/* Instructions run_spim has executed */
+bool spim_timed_out = false;	/* => a run stopped at its time limit */
+long long spim_syscall_steps = 0; /* spim_steps, counting the syscall
+				     running now */
 
 #ifdef _MSC_BUILD
 /* Disable MS VS warning about constant predicate in conditional. */
@@ -73,6 +83,8 @@ bool force_break = false;	/* For the execution env. to force an execution break
 /* Local functions: */
 
 static void bump_CP0_timer ();
+static void poll_CP0_timer ();
+static bool run_time_expired ();
 static void set_fpu_cc (int cond, int cc, int less, int equal, int unordered);
 static void signed_multiply (reg_word v1, reg_word v2);
 static void start_CP0_timer ();
@@ -94,6 +106,13 @@ static void unsigned_multiply (reg_word v1, reg_word v2);
 slot of another instruction. */
 static int running_in_delay_slot = 0;
 
+/* Steps until the next PC sample in the trace. */
+static int trace_countdown = 0;
+
+/* When a run must stop, if run_has_deadline (see set_run_time_limit). */
+static bool run_has_deadline = false;
+static struct timeval run_deadline;
+
 
 /* Executed delayed branch and jump instructions by running the
    instruction from the delay slot before transfering control.  Note,
@@ -188,12 +207,24 @@ static int running_in_delay_slot = 0;
 bool
 run_spim (mem_addr initial_PC, int steps_to_run, bool display)
 {
-  instruction *inst;
+  inst_code *inst;
   static reg_word *delayed_load_addr1 = NULL, delayed_load_value1;
   static reg_word *delayed_load_addr2 = NULL, delayed_load_value2;
-  int step, step_size, next_step;
+  int step, step_size, next_step, next_check;
+  int steps_requested = steps_to_run;
+  /* The trace, the cache and timing models, and the profiler are each
+     reached only through this one test, made once per instruction, so
+     none of them costs anything more when all are off (the default). */
+  bool observed = (spim_trace != NULL || spim_cache != NULL
+		   || spim_timing != NULL
+		   || spim_profile != NULL); /* => trace, model, or profile */
+
+  /* Instructions executed so far in this call, counting the current one
+     if it has started. */
+#define STEPS_RUN(STARTED) (steps_requested - steps_to_run + step + (STARTED))
 
   PC = initial_PC;
+  sync_inst_code ();
   if (!bare_machine && mapped_io)
     next_step = IO_INTERVAL;
   else
@@ -226,62 +257,79 @@ run_spim (mem_addr initial_PC, int steps_to_run, bool display)
 	}
 
       force_break = false;
+      next_check = 0;
       for (step = 0; step < step_size; step += 1)
 	{
-	  if (force_break)
+	  /* Every CHECK_INTERVAL steps, rather than on every step, see if
+	     the run must stop and whether the CP0 timer has ticked. */
+	  if (step == next_check)
 	    {
-              return true;
+	      if (force_break || run_time_expired ())
+		{
+		  spim_steps += STEPS_RUN (0);
+		  return true;
+		}
+	      poll_CP0_timer ();
+	      next_check += CHECK_INTERVAL;
 	    }
 
 	  R[0] = 0;		/* Maintain invariant value */
 
-#ifdef _WIN32
-	  SleepEx(0, TRUE);	      /* Put thread in awaitable state for WaitableTimer */
-#else
-	  {
-	    /* Poll for timer expiration */
-	    struct itimerval time;
-	    if (-1 == getitimer (ITIMER_REAL, &time))
-	      {
-		perror ("getitmer failed");
-	      }
-	    if (time.it_value.tv_usec == 0 && time.it_value.tv_sec == 0)
-	      {
-		/* Timer expired */
-		bump_CP0_timer ();
-
-		/* Restart timer for next interval */
-                start_CP0_timer ();
-	      }
-	  }
-#endif
-
 	  exception_occurred = 0;
-	  inst = read_mem_inst (PC);
-	  if (exception_occurred) /* In reading instruction */
-	    {
-	      exception_occurred = 0;
-	      handle_exception ();
-	      continue;
-	    }
-	  else if (inst == NULL)
+	  inst = read_inst_code (PC);
+	  if (inst == NULL || OPCODE (inst) == 0)
 	    {
-	      run_error ("Attempt to execute non-instruction at 0x%08x\n", PC);
-	      return false;
+	      /* Not a runnable instruction: find out why. */
+	      instruction *full = read_mem_inst (PC);
+
+	      if (exception_occurred) /* In reading instruction */
+		{
+		  exception_occurred = 0;
+		  handle_exception ();
+		  continue;
+		}
+	      else if (full == NULL)
+		{
+		  spim_steps += STEPS_RUN (0);
+		  run_error ("Attempt to execute non-instruction at 0x%08x\n", PC);
+		  return false;
+		}
+	      else
+		{
+		  spim_steps += STEPS_RUN (0);
+		  run_error ("Instruction references undefined symbol at 0x%08x\n  %s", PC, inst_to_string(PC));
+		  return false;
+		}
 	    }
-	  else if (EXPR (inst) != NULL
-		   && EXPR (inst)->symbol != NULL
-		   && EXPR (inst)->symbol->addr == 0)
+
+	  /* Sample the PC for the trace, show the caches the fetch and
+	     any load or store, time the instruction in the pipeline, and
+	     sample the call stack for the profile, in one test when none
+	     is on. */
+	  if (observed)
 	    {
-              run_error ("Instruction references undefined symbol at 0x%08x\n  %s", PC, inst_to_string(PC));
-	      return false;
+	      if (spim_trace != NULL && --trace_countdown <= 0)
+		{
+		  trace_record (spim_trace, TRACE_PC, PC);
+		  trace_countdown = spim_trace_interval;
+		}
+	      if (spim_cache != NULL)
+		{
+		  cache_fetch (PC);
+		  if (opcode_is_load_store (OPCODE (inst)))
+		    cache_data_access (R[BASE (inst)] + IOFFSET (inst));
+		}
+	      if (spim_timing != NULL)
+		timing_step (inst);
+	      if (spim_profile != NULL && --spim_profile->countdown <= 0)
+		profile_sample (spim_profile);
 	    }
 
 	  if (display)
 	    print_inst (PC);
 
 #ifdef TEST_ASM
-	  test_assembly (inst);
+	  test_assembly (read_mem_inst (PC));
 #endif
 
 	  DO_DELAYED_UPDATE ();
@@ -436,7 +484,11 @@ run_spim (mem_addr initial_PC, int steps_to_run, bool display)
 	    case Y_BREAK_OP:
 	      if (RD (inst) == 1)
 		/* Debugger breakpoint */
-		RAISE_EXCEPTION (ExcCode_Bp, return true)
+		RAISE_EXCEPTION (ExcCode_Bp,
+				 {
+				   spim_steps += STEPS_RUN (1);
+				   return true;
+				 })
 	      else
 		RAISE_EXCEPTION (ExcCode_Bp, break);
 
@@ -1101,8 +1153,14 @@ run_spim (mem_addr initial_PC, int steps_to_run, bool display)
 	      break;		/* Memory details not implemented */
 
 	    case Y_SYSCALL_OP:
+	      if (spim_trace != NULL)
+		trace_record (spim_trace, TRACE_SYSCALL, R[REG_V0]);
+	      spim_syscall_steps = spim_steps + STEPS_RUN (1);
 	      if (!do_syscall ())
-		return false;
+		{
+		  spim_steps += STEPS_RUN (1);
+		  return false;
+		}
 	      break;
 
 	    case Y_TEQ_OP:
@@ -1644,7 +1702,49 @@ run_spim (mem_addr initial_PC, int steps_to_run, bool display)
     }				/* End: for ( ; steps_to_run > 0 ... */
 
   /* Executed enought steps, return, but are able to continue. */
+  spim_steps += steps_requested;
   return true;
+#undef STEPS_RUN
+}
+
+
+/* Stop runs that last longer than MS milliseconds from now.  No limit
+   if MS is not positive.  spim_timed_out is set when a run stops at the
+   limit. */
+
+void
+set_run_time_limit (int ms)
+{
+  spim_timed_out = false;
+  run_has_deadline = (ms > 0);
+  if (run_has_deadline)
+    {
+      gettimeofday (&run_deadline, NULL);
+      run_deadline.tv_sec += ms / 1000;
+      run_deadline.tv_usec += (ms % 1000) * 1000;
+      if (run_deadline.tv_usec >= 1000000)
+	{
+	  run_deadline.tv_sec += 1;
+	  run_deadline.tv_usec -= 1000000;
+	}
+    }
+}
+
+
+/* Return true if the run has passed its time limit. */
+
+static bool
+run_time_expired ()
+{
+  struct timeval now;
+
+  if (!run_has_deadline)
+    return (false);
+  gettimeofday (&now, NULL);
+  if (timercmp (&now, &run_deadline, <))
+    return (false);
+  spim_timed_out = true;
+  return (true);
 }
 
 
@@ -1674,6 +1774,31 @@ bump_CP0_timer ()
 }
 
 
+/* See if the CP0 timer has expired, and if so, count a tick. */
+
+static void
+poll_CP0_timer ()
+{
+#ifdef _WIN32
+  SleepEx(0, TRUE);	      /* Put thread in awaitable state for WaitableTimer */
+#else
+  struct itimerval time;
+  if (-1 == getitimer (ITIMER_REAL, &time))
+    {
+      perror ("getitmer failed");
+    }
+  if (time.it_value.tv_usec == 0 && time.it_value.tv_sec == 0)
+    {
+      /* Timer expired */
+      bump_CP0_timer ();
+
+      /* Restart timer for next interval */
+      start_CP0_timer ();
+    }
+#endif
+}
+
+
 static void
 start_CP0_timer ()
 {
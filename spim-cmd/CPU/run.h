@@ -31,6 +31,17 @@
 */
 
 
+/* Exported variables: */
+
+extern struct trace_ring *spim_trace; /* Trace being recorded, or NULL */
+extern int spim_trace_interval;	/* Steps between PC samples in trace */
+extern long long spim_steps;	/* Instructions run_spim has executed */
+extern bool spim_timed_out;	/* => a run stopped at its time limit */
+extern long long spim_syscall_steps; /* spim_steps, counting the syscall
+					running now */
+
+
 /* Exported functions: */
 
 bool run_spim (mem_addr initial_PC, register int steps, bool display);
+void set_run_time_limit (int ms);
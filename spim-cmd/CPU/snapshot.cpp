@@ -0,0 +1,522 @@
+/* SPIM S20 MIPS simulator.
+   Snapshot and restore of the complete simulator state.
+   See snapshot.h for the layout of a snapshot. */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "spim.h"
+#include "string-stream.h"
+#include "spim-utils.h"
+#include "inst.h"
+#include "reg.h"
+#include "mem.h"
+#include "data.h"
+#include "sym-tbl.h"
+#include "snapshot.h"
+
+
+#define SNAPSHOT_MAGIC "SPIMSNP1"
+
+
+typedef struct snapshot_header
+{
+  char magic[8];		/* SNAPSHOT_MAGIC */
+  uint32 text_bytes;		/* text_top - TEXT_BOT */
+  uint32 text_words;		/* Words saved, up to the last instruction */
+  uint32 k_text_bytes;		/* k_text_top - K_TEXT_BOT */
+  uint32 k_text_words;
+  uint32 data_bytes;		/* data_top - DATA_BOT */
+  uint32 stack_bytes;		/* STACK_TOP - stack_bot */
+  uint32 k_data_bytes;		/* k_data_top - K_DATA_BOT */
+  mem_addr text_pc, k_text_pc;	/* Where the assembler was in each segment */
+  mem_addr data_pc, k_data_pc;
+  mem_addr gp_midpoint;
+  uint32 label_count;
+  uint32 labels_bytes;
+  uint32 use_count;		/* Label uses not yet resolved */
+  uint32 uses_bytes;
+  reg_word R[R_LENGTH];
+  reg_word HI, LO;
+  mem_addr PC, nPC;
+  reg_word CCR[4][32], CPR[4][32];
+  double FPR[FPR_LENGTH];
+} snapshot_header;
+
+
+/* Flags of a saved label: */
+
+#define SNAP_LABEL_GLOBAL	0x1
+#define SNAP_LABEL_GP		0x2
+#define SNAP_LABEL_CONST	0x4
+#define SNAP_LABEL_FLUSHED	0x8	/* Local label of an earlier file */
+
+
+/* Kinds of a saved label use: */
+
+#define SNAP_USE_DATA		0	/* A word of data */
+#define SNAP_USE_TEXT		1	/* The instruction in the text at addr */
+#define SNAP_USE_COPY		2	/* A copy of an instruction, stored in data */
+
+/* Words in a saved label use before the label's name: */
+
+#define SNAP_USE_WORDS		7
+
+
+/* Local functions: */
+
+static void count_label (label *l, void *arg);
+static void count_use (label_use *use, void *arg);
+static char *get_text (char *p, mem_addr bot, uint32 words);
+static char *get_use (char *p, char *end);
+static uint32 last_inst (instruction **seg, uint32 bytes);
+static char *put_label (char *p, label *l);
+static void save_label (label *l, void *arg);
+static void save_use (label_use *use, void *arg);
+static char *put_text (char *p, instruction **seg, uint32 words);
+static uint32 snapshot_size (snapshot_header *h);
+static instruction **text_slot (mem_addr addr);
+static size_t text_section_size (uint32 words);
+
+
+
+/* Return the number of words of the segment SEG, BYTES long, up to and
+   including its last instruction. */
+
+static uint32
+last_inst (instruction **seg, uint32 bytes)
+{
+  uint32 n = bytes / BYTES_PER_WORD;
+
+  while (n > 0 && seg[n - 1] == NULL)
+    n -= 1;
+  return (n);
+}
+
+
+static size_t
+text_section_size (uint32 words)
+{
+  return (words * sizeof (int32) + ROUND_UP (words, BYTES_PER_WORD));
+}
+
+
+static uint32
+snapshot_size (snapshot_header *h)
+{
+  return (sizeof (snapshot_header)
+	  + text_section_size (h->text_words)
+	  + text_section_size (h->k_text_words)
+	  + h->data_bytes + h->stack_bytes + h->k_data_bytes
+	  + h->labels_bytes + h->uses_bytes);
+}
+
+
+/* Return the slot in the text segments holding the instruction at
+   ADDR, or NULL if ADDR is not in them. */
+
+static instruction **
+text_slot (mem_addr addr)
+{
+  if (addr >= TEXT_BOT && addr < text_top && !(addr & 0x3))
+    return (&text_seg [(addr - TEXT_BOT) >> 2]);
+  else if (addr >= K_TEXT_BOT && addr < k_text_top && !(addr & 0x3))
+    return (&k_text_seg [(addr - K_TEXT_BOT) >> 2]);
+  else
+    return (NULL);
+}
+
+
+/* Add the size of label L's record to the header ARG. */
+
+static void
+count_label (label *l, void *arg)
+{
+  snapshot_header *h = (snapshot_header *) arg;
+
+  h->label_count += 1;
+  h->labels_bytes += 3 * sizeof (uint32) + ROUND_UP (strlen (l->name), BYTES_PER_WORD);
+}
+
+
+static char *
+put_label (char *p, label *l)
+{
+  uint32 addr = (uint32) l->addr;
+  uint32 flags = 0;
+  uint32 len = (uint32) strlen (l->name);
+
+  if (l->global_flag) flags |= SNAP_LABEL_GLOBAL;
+  if (l->gp_flag) flags |= SNAP_LABEL_GP;
+  if (l->const_flag) flags |= SNAP_LABEL_CONST;
+  if (label_is_defined (l->name) != l) flags |= SNAP_LABEL_FLUSHED;
+
+  memcpy (p, &addr, sizeof (addr));
+  memcpy (p + sizeof (uint32), &flags, sizeof (flags));
+  memcpy (p + 2 * sizeof (uint32), &len, sizeof (len));
+  memset (p + 3 * sizeof (uint32), 0, ROUND_UP (len, BYTES_PER_WORD));
+  memcpy (p + 3 * sizeof (uint32), l->name, len);
+  return (p + 3 * sizeof (uint32) + ROUND_UP (len, BYTES_PER_WORD));
+}
+
+
+/* Add the size of the record of the label use USE to the header ARG. */
+
+static void
+count_use (label_use *use, void *arg)
+{
+  snapshot_header *h = (snapshot_header *) arg;
+
+  h->use_count += 1;
+  h->uses_bytes += SNAP_USE_WORDS * sizeof (uint32)
+    + ROUND_UP (strlen (use->sym->name), BYTES_PER_WORD);
+}
+
+
+/* Append the record of the label use USE at the cursor ARG: its
+   address, kind, the instruction's encoding and immediate expression
+   (if it is in an instruction), and the label's name. */
+
+static void
+save_use (label_use *use, void *arg)
+{
+  char **p = (char **) arg;
+  uint32 w[SNAP_USE_WORDS - 1];
+  instruction **slot;
+  uint32 len = (uint32) strlen (use->sym->name);
+
+  memset (w, 0, sizeof (w));
+  w[0] = (uint32) use->addr;
+  if (use->inst == NULL)
+    w[1] = SNAP_USE_DATA;
+  else
+    {
+      slot = text_slot (use->addr);
+      w[1] = (slot != NULL && *slot == use->inst) ? SNAP_USE_TEXT : SNAP_USE_COPY;
+      w[2] = (uint32) inst_encode (use->inst);
+      if (EXPR (use->inst) != NULL)
+	{
+	  w[3] = (uint32) EXPR (use->inst)->offset;
+	  w[4] = (uint32) (int32) EXPR (use->inst)->bits;
+	  w[5] = EXPR (use->inst)->pc_relative;
+	}
+    }
+  memcpy (*p, w, sizeof (w));
+  memcpy (*p + sizeof (w), &len, sizeof (len));
+  *p += SNAP_USE_WORDS * sizeof (uint32);
+  memset (*p, 0, ROUND_UP (len, BYTES_PER_WORD));
+  memcpy (*p, use->sym->name, len);
+  *p += ROUND_UP (len, BYTES_PER_WORD);
+}
+
+
+/* Append label L's record at the cursor ARG. */
+
+static void
+save_label (label *l, void *arg)
+{
+  char **p = (char **) arg;
+
+  *p = put_label (*p, l);
+}
+
+
+static char *
+put_text (char *p, instruction **seg, uint32 words)
+{
+  uint32 i;
+  char *present = p + words * sizeof (int32);
+
+  for (i = 0; i < words; i ++)
+    {
+      int32 code = inst_encode (seg[i]);
+
+      memcpy (p + i * sizeof (int32), &code, sizeof (code));
+      present[i] = (seg[i] != NULL);
+    }
+  memset (present + words, 0, ROUND_UP (words, BYTES_PER_WORD) - words);
+  return (p + text_section_size (words));
+}
+
+
+/* Return a snapshot, in memory, of the simulator's current state. */
+
+spim_snapshot *
+take_snapshot ()
+{
+  spim_snapshot *snap = (spim_snapshot *) xmalloc (sizeof (spim_snapshot));
+  snapshot_header h;
+  char *p;
+
+  memset (&h, 0, sizeof (h));
+  memcpy (h.magic, SNAPSHOT_MAGIC, sizeof (h.magic));
+  h.text_bytes = text_top - TEXT_BOT;
+  h.text_words = last_inst (text_seg, h.text_bytes);
+  h.k_text_bytes = k_text_top - K_TEXT_BOT;
+  h.k_text_words = last_inst (k_text_seg, h.k_text_bytes);
+  h.data_bytes = data_top - DATA_BOT;
+  h.stack_bytes = STACK_TOP - stack_bot;
+  h.k_data_bytes = k_data_top - K_DATA_BOT;
+  user_kernel_text_segment (true);
+  h.k_text_pc = current_text_pc ();
+  user_kernel_text_segment (false);
+  h.text_pc = current_text_pc ();
+  user_kernel_data_segment (true);
+  h.k_data_pc = current_data_pc ();
+  user_kernel_data_segment (false);
+  h.data_pc = current_data_pc ();
+  h.gp_midpoint = gp_midpoint;
+  map_symbols (count_label, &h);
+  map_label_uses (count_use, &h);
+  memcpy (h.R, R, sizeof (h.R));
+  h.HI = HI;
+  h.LO = LO;
+  h.PC = PC;
+  h.nPC = nPC;
+  memcpy (h.CCR, CCR, sizeof (h.CCR));
+  memcpy (h.CPR, CPR, sizeof (h.CPR));
+  memcpy (h.FPR, FPR, sizeof (h.FPR));
+
+  snap->size = snapshot_size (&h);
+  snap->image = (char *) xmalloc (snap->size);
+  snap->mapped = false;
+
+  p = snap->image;
+  memcpy (p, &h, sizeof (h));
+  p += sizeof (h);
+  p = put_text (p, text_seg, h.text_words);
+  p = put_text (p, k_text_seg, h.k_text_words);
+  memcpy (p, data_seg, h.data_bytes);
+  p += h.data_bytes;
+  memcpy (p, stack_seg, h.stack_bytes);
+  p += h.stack_bytes;
+  memcpy (p, k_data_seg, h.k_data_bytes);
+  p += h.k_data_bytes;
+  map_symbols (save_label, &p);
+  map_label_uses (save_use, &p);
+  return (snap);
+}
+
+
+/* Restore the text segment starting at BOT from its section at P. */
+
+static char *
+get_text (char *p, mem_addr bot, uint32 words)
+{
+  uint32 i;
+  char *present = p + words * sizeof (int32);
+
+  for (i = 0; i < words; i ++)
+    if (present[i])
+      {
+	int32 code;
+
+	memcpy (&code, p + i * sizeof (int32), sizeof (code));
+	set_mem_inst (bot + i * BYTES_PER_WORD, inst_decode (code));
+      }
+  return (p + text_section_size (words));
+}
+
+
+/* Record again the label use saved at P, which ends before END.
+   Return the cursor after it, or NULL if it is cut short. */
+
+static char *
+get_use (char *p, char *end)
+{
+  uint32 w[SNAP_USE_WORDS];
+  char *name;
+  label *sym;
+  instruction *inst = NULL;
+
+  if (p + sizeof (w) > end)
+    return (NULL);
+  memcpy (w, p, sizeof (w));
+  p += sizeof (w);
+  if (p + ROUND_UP (w[6], BYTES_PER_WORD) > end)
+    return (NULL);
+  name = (char *) xmalloc (w[6] + 1);
+  memcpy (name, p, w[6]);
+  name[w[6]] = '\0';
+  p += ROUND_UP (w[6], BYTES_PER_WORD);
+  sym = lookup_label (name);
+  free (name);
+
+  if (w[1] == SNAP_USE_TEXT)
+    {
+      instruction **slot = text_slot (w[0]);
+
+      if (slot == NULL || *slot == NULL)
+	return (p);
+      inst = *slot;
+    }
+  else if (w[1] == SNAP_USE_COPY)
+    inst = inst_decode ((int32) w[2]);
+  if (inst != NULL)
+    {
+      if (EXPR (inst) != NULL)
+	free (EXPR (inst));
+      SET_EXPR (inst, make_imm_expr ((int32) w[3], NULL, w[5] != 0));
+      EXPR (inst)->symbol = sym;
+      EXPR (inst)->bits = (short) (int32) w[4];
+    }
+  record_fixup (sym, inst, w[0]);
+  return (p);
+}
+
+
+/* Restore the simulator's state saved in SNAP.  Return false if SNAP
+   is not a valid snapshot. */
+
+bool
+restore_snapshot (spim_snapshot *snap)
+{
+  snapshot_header h;
+  char *p, *end;
+  uint32 i;
+
+  if (snap->size < sizeof (h))
+    return (false);
+  memcpy (&h, snap->image, sizeof (h));
+  if (memcmp (h.magic, SNAPSHOT_MAGIC, sizeof (h.magic)) != 0
+      || snapshot_size (&h) != snap->size)
+    return (false);
+
+  if (FPR == NULL)
+    FPR = (double *) xmalloc (FPR_LENGTH * sizeof (double));
+  make_memory (h.text_bytes,
+	       h.data_bytes, initial_data_limit,
+	       h.stack_bytes, initial_stack_limit,
+	       h.k_text_bytes,
+	       h.k_data_bytes, initial_k_data_limit);
+  initialize_inst_tables ();
+  initialize_symbol_table ();
+
+  p = snap->image + sizeof (h);
+  p = get_text (p, TEXT_BOT, h.text_words);
+  p = get_text (p, K_TEXT_BOT, h.k_text_words);
+  memcpy (data_seg, p, h.data_bytes);
+  p += h.data_bytes;
+  memcpy (stack_seg, p, h.stack_bytes);
+  p += h.stack_bytes;
+  memcpy (k_data_seg, p, h.k_data_bytes);
+  p += h.k_data_bytes;
+
+  end = snap->image + snap->size;
+  for (i = 0; i < h.label_count && p + 3 * sizeof (uint32) <= end; i ++)
+    {
+      uint32 addr, flags, len;
+      char *name;
+      label *l;
+
+      memcpy (&addr, p, sizeof (addr));
+      memcpy (&flags, p + sizeof (uint32), sizeof (flags));
+      memcpy (&len, p + 2 * sizeof (uint32), sizeof (len));
+      p += 3 * sizeof (uint32);
+      if (p + ROUND_UP (len, BYTES_PER_WORD) > end)
+	break;
+      name = (char *) xmalloc (len + 1);
+      memcpy (name, p, len);
+      name[len] = '\0';
+      p += ROUND_UP (len, BYTES_PER_WORD);
+
+      l = (flags & SNAP_LABEL_FLUSHED) ? record_flushed_label (name) : lookup_label (name);
+      l->addr = addr;
+      l->global_flag = (flags & SNAP_LABEL_GLOBAL) != 0;
+      l->gp_flag = (flags & SNAP_LABEL_GP) != 0;
+      l->const_flag = (flags & SNAP_LABEL_CONST) != 0;
+      free (name);
+    }
+  for (i = 0; i < h.use_count && p != NULL; i ++)
+    p = get_use (p, end);
+
+  memcpy (R, h.R, sizeof (h.R));
+  HI = h.HI;
+  LO = h.LO;
+  PC = h.PC;
+  nPC = h.nPC;
+  memcpy (CCR, h.CCR, sizeof (h.CCR));
+  memcpy (CPR, h.CPR, sizeof (h.CPR));
+  memcpy (FPR, h.FPR, sizeof (h.FPR));
+  FGR = (float *) FPR;
+  FWR = (int *) FPR;
+  gp_midpoint = h.gp_midpoint;
+  user_kernel_text_segment (false);
+  user_kernel_data_segment (false);
+  text_begins_at_point (h.text_pc);
+  k_text_begins_at_point (h.k_text_pc);
+  data_begins_at_point (h.data_pc);
+  k_data_begins_at_point (h.k_data_pc);
+  return (true);
+}
+
+
+/* Write SNAP to the file FILE_NAME.  Return false if it cannot be
+   written. */
+
+bool
+write_snapshot (spim_snapshot *snap, char *file_name)
+{
+  FILE *f = fopen (file_name, "wb");
+  bool ok;
+
+  if (f == NULL)
+    return (false);
+  ok = fwrite (snap->image, 1, snap->size, f) == snap->size;
+  ok = (fclose (f) == 0) && ok;
+  return (ok);
+}
+
+
+/* Return the snapshot in the file FILE_NAME, mapped into memory, or
+   NULL if it cannot be read or is not a snapshot. */
+
+spim_snapshot *
+read_snapshot (char *file_name)
+{
+  int fd = open (file_name, O_RDONLY);
+  struct stat info;
+  void *image;
+  spim_snapshot *snap;
+
+  if (fd < 0)
+    return (NULL);
+  if (fstat (fd, &info) < 0 || (size_t) info.st_size < sizeof (snapshot_header))
+    {
+      close (fd);
+      return (NULL);
+    }
+  image = mmap (NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (image == MAP_FAILED)
+    return (NULL);
+  if (memcmp (image, SNAPSHOT_MAGIC, 8) != 0)
+    {
+      munmap (image, info.st_size);
+      return (NULL);
+    }
+
+  snap = (spim_snapshot *) xmalloc (sizeof (spim_snapshot));
+  snap->image = (char *) image;
+  snap->size = info.st_size;
+  snap->mapped = true;
+  return (snap);
+}
+
+
+void
+free_snapshot (spim_snapshot *snap)
+{
+  if (snap == NULL)
+    return;
+  if (snap->mapped)
+    munmap (snap->image, snap->size);
+  else
+    free (snap->image);
+  free (snap);
+}
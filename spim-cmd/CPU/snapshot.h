@@ -0,0 +1,53 @@
+/* SPIM S20 MIPS simulator.
+   Snapshots of the complete simulator state.
+
+   A snapshot holds everything needed to start a loaded program again
+   without re-assembling it: the registers (general, HI/LO, PC,
+   floating point, and the coprocessor registers, including CP0), the
+   contents of all five memory segments, and the label table with the
+   uses of labels not yet defined, which a later file may define.  Test
+   harnesses that run the same program many times load it once, take a
+   snapshot, and restore it before each run.
+
+   A snapshot is one flat image, the same in memory and in a file:
+
+	header		(struct snapshot_header)
+	text		(encoding of each word, then a byte per word that
+			 is non-zero if the word holds an instruction)
+	kernel text	(the same)
+	data, stack, kernel data	(their bytes)
+	labels		(for each, its address, flags, name length, and
+			 name, padded to a word)
+	label uses	(for each use of a label not yet defined, its
+			 address, instruction, immediate expression, and
+			 the label's name)
+
+   Instructions are kept as their encodings and decoded again on
+   restore, so a restored program runs the same but is disassembled
+   without its source lines.  A snapshot read from a file is mapped
+   into memory privately (copy-on-write), so its pages are read in
+   only as a restore touches them, and are shared by all the
+   processes that restore the same file.  The segments themselves are
+   copied out of the mapping, since the simulator grows them in place. */
+
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+typedef struct spim_snapshot
+{
+  char *image;			/* The flat image, see above */
+  size_t size;
+  bool mapped;			/* => image is mapped from a file */
+} spim_snapshot;
+
+
+/* Exported functions: */
+
+void free_snapshot (spim_snapshot *snap);
+spim_snapshot *read_snapshot (char *file_name);
+bool restore_snapshot (spim_snapshot *snap);
+spim_snapshot *take_snapshot ();
+bool write_snapshot (spim_snapshot *snap, char *file_name);
+
+#endif
@@ -50,3 +50,11 @@
 #define CLOSE_SYSCALL		16
 
 #define EXIT2_SYSCALL		17
+
+#define READ_COUNTER_SYSCALL	18
+
+/* Counters READ_COUNTER_SYSCALL reads (its $a0): */
+
+#define INSTRUCTIONS_COUNTER	0	/* Instructions executed */
+#define CYCLES_COUNTER		1	/* Estimated cycles taken */
+#define SYSCALLS_COUNTER	2	/* Syscalls made, including this one */
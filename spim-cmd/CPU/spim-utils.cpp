@@ -133,7 +133,7 @@ initialize_world (char* exception_file_names, bool print_message)
       if (!bare_machine)
       {
 	(void)make_label_global ("main"); /* In case .globl main forgotten */
-	(void)record_label ("main", 0, 0);
+	(void)record_label ("main", 0);
       }
     }
   initialize_scanner (stdin);
@@ -499,6 +499,152 @@ map_string_to_name_val_val (name_val_val tbl[], int tbl_len, char *id)
 }
 
 
+/* Return a hash code for the string NAME (FNV-1a). */
+
+uint32
+hash_name (char *name)
+{
+  uint32 h = 2166136261u;
+
+  for ( ; *name != '\0'; name ++)
+    h = (h ^ (unsigned char) *name) * 16777619u;
+  return (h);
+}
+
+
+/* Return the slot for a name with hash code H under displacement D. */
+
+static inline uint32
+displaced_slot (uint32 h, uint32 d, uint32 slot_mask)
+{
+  h ^= d * 0x9e3779b9u;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return (h & slot_mask);
+}
+
+
+/* Build a perfect hash HASH of the TBL_LEN entries of TBL, whose names
+   must be distinct, by hash and displace.  The names are split into
+   buckets on their hash codes, and then, biggest bucket first, each
+   bucket is given the first displacement that sends all of its names to
+   slots that are still free.  With twice as many slots as names, this
+   quickly succeeds. */
+
+#define MAX_DISPLACEMENT (1 << 16)
+
+void
+build_name_hash (name_hash *hash, name_val_val tbl[], int tbl_len)
+{
+  uint32 slots = 1, buckets = 1;
+  uint32 *codes = (uint32 *) xmalloc (tbl_len * sizeof (uint32));
+  int *order = (int *) xmalloc (tbl_len * sizeof (int));
+  int *count;
+  int i, j;
+
+  while (slots < 2 * (uint32) tbl_len)
+    slots <<= 1;
+  while (2 * buckets < (uint32) tbl_len)
+    buckets <<= 1;
+  for (i = 0; i < tbl_len; i ++)
+    codes[i] = hash_name (tbl[i].name);
+
+  /* Order the entries by bucket, biggest bucket first. */
+  count = (int *) zmalloc (buckets * sizeof (int));
+  for (i = 0; i < tbl_len; i ++)
+    count[codes[i] & (buckets - 1)] += 1;
+  for (i = 0; i < tbl_len; i ++)
+    order[i] = i;
+  for (i = 1; i < tbl_len; i ++)
+    {
+      int e = order[i];
+      uint32 b = codes[e] & (buckets - 1);
+
+      for (j = i; j > 0; j --)
+	{
+	  uint32 b2 = codes[order[j - 1]] & (buckets - 1);
+	  if (count[b2] > count[b] || (count[b2] == count[b] && b2 <= b))
+	    break;
+	  order[j] = order[j - 1];
+	}
+      order[j] = e;
+    }
+
+  while (true)
+    {
+      bool placed = true;
+
+      hash->slots = (name_val_val **) zmalloc (slots * sizeof (name_val_val *));
+      hash->displace = (uint32 *) zmalloc (buckets * sizeof (uint32));
+      hash->slot_mask = slots - 1;
+      hash->bucket_mask = buckets - 1;
+
+      for (i = 0; placed && i < tbl_len; i = j)
+	{
+	  uint32 b = codes[order[i]] & (buckets - 1);
+	  uint32 d;
+
+	  /* The bucket's entries are order[i .. j-1]. */
+	  for (j = i; j < tbl_len && (codes[order[j]] & (buckets - 1)) == b; j ++)
+	    ;
+	  for (d = 0; d < MAX_DISPLACEMENT; d ++)
+	    {
+	      int k, m;
+
+	      for (k = i; k < j; k ++)
+		{
+		  uint32 slot = displaced_slot (codes[order[k]], d, slots - 1);
+
+		  if (hash->slots[slot] != NULL)
+		    break;
+		  hash->slots[slot] = &tbl[order[k]];
+		}
+	      if (k == j)
+		break;
+	      /* Undo this bucket's placements. */
+	      for (m = i; m < k; m ++)
+		hash->slots[displaced_slot (codes[order[m]], d, slots - 1)] = NULL;
+	    }
+	  if (d == MAX_DISPLACEMENT)
+	    placed = false;
+	  else
+	    hash->displace[b] = d;
+	}
+      if (placed)
+	break;
+
+      /* Very unlikely: try again with more room. */
+      free (hash->slots);
+      free (hash->displace);
+      slots <<= 1;
+    }
+
+  free (codes);
+  free (order);
+  free (count);
+}
+
+
+/* Return the entry in the perfect HASH with key ID, or NULL if no such
+   entry exists. */
+
+name_val_val *
+map_string_to_name_hash (name_hash *hash, char *id)
+{
+  uint32 h = hash_name (id);
+  uint32 d = hash->displace[h & hash->bucket_mask];
+  name_val_val *entry = hash->slots[displaced_slot (h, d, hash->slot_mask)];
+
+  if (entry != NULL && streq (entry->name, id))
+    return (entry);
+  else
+    return (NULL);
+}
+
+
 /* Return the entry in the linear TABLE of length LENGTH with VALUE1 field NUM.
    TABLE must be sorted on the VALUE1 field.
    Return NULL if no such entry exists. */
@@ -42,6 +42,19 @@ typedef struct
 } name_val_val;
 
 
+/* A perfect hash of a table of name_val_val's on their names: each name
+   in the table maps to its own slot, so a lookup hashes the name and
+   compares it against one entry.  See build_name_hash. */
+
+typedef struct
+{
+  name_val_val **slots;		/* Entry in each slot, or NULL */
+  uint32 *displace;		/* Displacement for each bucket */
+  uint32 slot_mask;		/* Number of slots - 1 */
+  uint32 bucket_mask;		/* Number of buckets - 1 */
+} name_hash;
+
+
 
 /* Exported functions: */
 
@@ -56,7 +69,10 @@ void initialize_stack (const char *command_line);
 void initialize_run_stack (int argc, char **argv);
 void initialize_world (char *exception_file_names, bool print_message);
 void list_breakpoints ();
+void build_name_hash (name_hash *hash, name_val_val tbl[], int tbl_len);
+uint32 hash_name (char *name);
 name_val_val *map_int_to_name_val_val (name_val_val tbl[], int tbl_len, int num);
+name_val_val *map_string_to_name_hash (name_hash *hash, char *id);
 name_val_val *map_string_to_name_val_val (name_val_val tbl[], int tbl_len, char *id);
 bool read_assembly_file (char *name);
 bool run_program (mem_addr pc, int steps, bool display, bool cont_bkpt, bool* continuable);
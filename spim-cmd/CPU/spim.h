@@ -200,6 +200,12 @@ typedef uint32 /*@alt int @*/ mem_addr;
 #define IO_INTERVAL 100
 
 
+/* Interval (in instructions) at which a run checks whether it must stop
+   (at its time limit, or for force_break) and polls the CP0 timer. */
+
+#define CHECK_INTERVAL 1024
+
+
 /* Number of IO_INTERVALs that a character remains in receiver buffer,
    even if another character is available. */
 
@@ -44,6 +44,11 @@
 #define SS_BUF_LENGTH 256
 #endif
 
+#ifndef SS_FLUSH_LENGTH
+/* Output a stream with a sink holds before ss_flush writes it */
+#define SS_FLUSH_LENGTH 65536
+#endif
+
 
 void
 ss_init (str_stream* ss)
@@ -52,6 +57,7 @@ ss_init (str_stream* ss)
   ss->max_length = SS_BUF_LENGTH;
   ss->empty_pos = 0;
   ss->initialized = 1;
+  ss->sink = NULL;
 }
 
 
@@ -74,6 +80,40 @@ ss_erase (str_stream* ss, int n)
 }
 
 
+/* Send the output of the stream to the file F as it grows, rather than
+   keeping it all, so that a large dump need not fit in memory.  Output
+   goes to F when ss_flush finds enough of it, at a point that the
+   caller chooses (e.g., the end of a line), and all of it when the sink
+   is changed.  A NULL F makes the stream keep its output again. */
+
+void
+ss_sink (str_stream* ss, FILE* f)
+{
+  if (0 == ss->initialized) ss_init (ss);
+
+  if (ss->sink != NULL && ss->empty_pos > 0)
+    {
+      (void)fwrite (ss->buf, 1, (size_t)ss->empty_pos, ss->sink);
+      ss->empty_pos = 0;
+    }
+  ss->sink = f;
+}
+
+
+/* If the stream has a sink and holds enough output, write the output to
+   it and empty the stream. */
+
+void
+ss_flush (str_stream* ss)
+{
+  if (ss->sink != NULL && ss->empty_pos >= SS_FLUSH_LENGTH)
+    {
+      (void)fwrite (ss->buf, 1, (size_t)ss->empty_pos, ss->sink);
+      ss->empty_pos = 0;
+    }
+}
+
+
 int
 ss_length (str_stream* ss)
 {
@@ -37,12 +37,15 @@ typedef struct str_stm
   int max_length;		/* Length of buffer */
   int empty_pos;		/* Index  of empty char in stream*/
   int initialized;		/* Stream initialized? */
+  FILE *sink;			/* If not NULL, file ss_flush writes to */
 } str_stream;
 
 
 void ss_init (str_stream* ss);
 void ss_clear (str_stream* ss);
 void ss_erase (str_stream* ss, int n);
+void ss_flush (str_stream* ss);
 int ss_length (str_stream* ss);
 char* ss_to_string (str_stream* ss);
 void ss_printf (str_stream* ss, char* fmt, ...);
+void ss_sink (str_stream* ss, FILE* f);
@@ -45,15 +45,17 @@
 
 /* Local functions: */
 
-static void get_hash (char *name, int *slot_no, label **entry);
+static int find_slot (char *name);
+static void grow_label_table ();
+static void remove_label (label *lab);
 static void resolve_a_label_sub (label *sym, instruction *inst, mem_addr pc);
 
-
+
 
 /* Keep track of the memory location that a label represents.  If we
    see a reference to a label that is not yet defined, then record the
-   reference so that we can patch up the instruction when the label is
-   defined.
+   reference so that we can patch up the instruction once the file has
+   been read and the label is defined.
 
    At the end of a file, we flush the hash table of all non-global
    labels so they can't be seen in other files.	 */
@@ -61,75 +63,104 @@ static void resolve_a_label_sub (label *sym, instruction *inst, mem_addr pc);
 
 static label *local_labels = NULL; /* Labels local to current file. */
 
+static label *flushed_labels = NULL; /* Local labels of earlier files. */
+
+
+/* Map from name of a label to a label structure.  This is an open
+   addressing hash table with linear probing.  It doubles in size
+   whenever it becomes half full, so the probes stay short however many
+   labels a program has. */
+
+#define INITIAL_LABEL_TABLE_SIZE 1024
+
+static label **label_table = NULL;
+
+static int label_table_size = 0; /* A power of 2 */
 
-#define HASHBITS 30
+static int label_count = 0;
 
-#define LABEL_HASH_TABLE_SIZE 8191
 
+/* Uses of labels that were not yet defined, in the order seen.  They
+   are fixed up in one batch, by resolve_label_uses, when a file has
+   been read. */
 
-/* Map from name of a label to a label structure. */
+static label_use *fixups = NULL;
 
-static label *label_hash_table [LABEL_HASH_TABLE_SIZE];
+static int fixup_count = 0;
 
+static int fixup_size = 0;
 
-/* Initialize the symbol table by removing and freeing old entries. */
+
+/* Initialize the symbol table by removing and freeing old entries.
+   The local labels of files already read are freed too: they were kept
+   only for the instructions that refer to them, and those are gone once
+   make_memory has replaced the text segments, as it has by the time
+   this is called.  The labels of the current file are still in the
+   table. */
 
 void
 initialize_symbol_table ()
 {
   int i;
+  label *l, *next;
 
-  for (i = 0; i < LABEL_HASH_TABLE_SIZE; i ++)
-  {
-    label *x, *n;
-
-    for (x = label_hash_table [i]; x != NULL; x = n)
+  for (i = 0; i < label_table_size; i ++)
+    if (label_table [i] != NULL)
+      {
+	free (label_table [i]->name);
+	free (label_table [i]);
+	label_table [i] = NULL;
+      }
+  for (l = flushed_labels; l != NULL; l = next)
     {
-      free (x->name);
-      n = x->next;
-      free (x);
+      next = l->next_local;
+      free (l->name);
+      free (l);
     }
-    label_hash_table [i] = NULL;
-  }
+  if (label_table == NULL)
+    {
+      label_table_size = INITIAL_LABEL_TABLE_SIZE;
+      label_table = (label **) zmalloc (label_table_size * sizeof (label *));
+    }
+  label_count = 0;
 
   local_labels = NULL;
+  flushed_labels = NULL;
+  fixup_count = 0;
 }
 
 
 
-/* Lookup for a label with the given NAME.  Set the SLOT_NO to be the hash
-   table bucket that contains (or would contain) the label's record.  If the
-   record is already in the table, set ENTRY to point to it.  Otherwise,
-   set ENTRY to be NULL. */
+/* Return the slot of the hash table that holds the label named NAME,
+   or the empty slot where it would go. */
 
-static void
-get_hash (char *name, int *slot_no, label **entry)
+static int
+find_slot (char *name)
 {
-  int hi;
-  int i;
-  label *lab;
-  int len;
+  int mask = label_table_size - 1;
+  int i = (int) (hash_name (name) & mask);
 
-  /* Compute length of name in len.  */
-  for (len = 0; name[len]; len++) ;
+  while (label_table [i] != NULL && !streq (label_table [i]->name, name))
+    i = (i + 1) & mask;
+  return (i);
+}
 
-  /* Compute hash code */
-  hi = len;
-  for (i = 0; i < len; i++)
-    hi = ((hi * 613) + (unsigned)(name[i]));
 
-  hi &= (1 << HASHBITS) - 1;
-  hi %= LABEL_HASH_TABLE_SIZE;
+/* Double the size of the hash table, reinserting its labels. */
 
-  *slot_no = hi;
-  /* Search table for entry */
-  for (lab = label_hash_table [hi]; lab; lab = lab->next)
-    if (streq (lab->name, name))
-      {
-	*entry = lab;		/* <-- return if found */
-	return;
-      }
-  *entry = NULL;
+static void
+grow_label_table ()
+{
+  label **old_table = label_table;
+  int old_size = label_table_size;
+  int i;
+
+  label_table_size = 2 * old_size;
+  label_table = (label **) zmalloc (label_table_size * sizeof (label *));
+  for (i = 0; i < old_size; i ++)
+    if (old_table [i] != NULL)
+      label_table [find_slot (old_table [i]->name)] = old_table [i];
+  free (old_table);
 }
 
 
@@ -139,12 +170,9 @@ get_hash (char *name, int *slot_no, label **entry)
 label *
 label_is_defined (char *name)
 {
-  int hi;
-  label *entry;
-
-  get_hash (name, &hi, &entry);
-
-  return (entry);
+  if (label_table == NULL)
+    return (NULL);
+  return (label_table [find_slot (name)]);
 }
 
 
@@ -154,34 +182,68 @@ label_is_defined (char *name)
 label *
 lookup_label (char *name)
 {
-  int hi;
-  label *entry, *lab;
-
-  get_hash (name, &hi, &entry);
+  int i;
+  label *lab;
 
-  if (entry != NULL)
-    return (entry);
+  if (label_table == NULL)
+    initialize_symbol_table ();
+  i = find_slot (name);
+  if (label_table [i] != NULL)
+    return (label_table [i]);
 
-  /* Not found, create one, add to chain */
+  /* Not found, create one, add to table */
   lab = (label *) xmalloc (sizeof (label));
   lab->name = str_copy (name);
   lab->addr = 0;
   lab->global_flag = 0;
   lab->const_flag = 0;
   lab->gp_flag = 0;
-  lab->uses = NULL;
+  lab->next_local = NULL;
 
-  lab->next = label_hash_table [hi];
-  label_hash_table [hi] = lab;
+  label_table [i] = lab;
+  label_count += 1;
+  if (2 * label_count > label_table_size)
+    grow_label_table ();
   return lab;			/* <-- return if created */
 }
 
 
-/* Record that the label named NAME refers to ADDRESS.	If RESOLVE_USES is
-   true, resolve all references to it.  Return the label structure. */
+/* Remove the label LAB from the hash table, shifting back the labels
+   that probed past its slot so that lookups still find them. */
+
+static void
+remove_label (label *lab)
+{
+  int mask = label_table_size - 1;
+  int i = find_slot (lab->name);
+  int j;
+
+  if (label_table [i] != lab)
+    return;
+  label_table [i] = NULL;
+  label_count -= 1;
+  for (j = (i + 1) & mask; label_table [j] != NULL; j = (j + 1) & mask)
+    {
+      int home = (int) (hash_name (label_table [j]->name) & mask);
+
+      /* Move the label at J to the hole at I unless its home lies
+	 cyclically within (I, J]. */
+      if ((j > i && (home <= i || home > j))
+	  || (j < i && (home <= i && home > j)))
+	{
+	  label_table [i] = label_table [j];
+	  label_table [j] = NULL;
+	  i = j;
+	}
+    }
+}
+
+
+/* Record that the label named NAME refers to ADDRESS.	Return the label
+   structure. */
 
 label *
-record_label (char *name, mem_addr address, int resolve_uses)
+record_label (char *name, mem_addr address)
 {
   label *l = lookup_label (name);
 
@@ -195,11 +257,6 @@ record_label (char *name, mem_addr address, int resolve_uses)
       l->addr = address;
     }
 
-  if (resolve_uses)
-    {
-      resolve_label_uses (l);
-    }
-
   if (!l->global_flag)
     {
       l->next_local = local_labels;
@@ -221,25 +278,35 @@ make_label_global (char *name)
 }
 
 
+/* Add a use of SYM by INST at ADDR to the fixups. */
+
+void
+record_fixup (label *sym, instruction *inst, mem_addr addr)
+{
+  if (fixup_count == fixup_size)
+    {
+      fixup_size = fixup_size == 0 ? 1024 : 2 * fixup_size;
+      fixups = (label_use *) realloc (fixups, fixup_size * sizeof (label_use));
+      if (fixups == NULL)
+	fatal_error ("Out of memory at request for %d bytes.\n",
+		     fixup_size * (int) sizeof (label_use));
+    }
+  fixups [fixup_count].sym = sym;
+  fixups [fixup_count].inst = inst;
+  fixups [fixup_count].addr = addr;
+  fixup_count += 1;
+}
+
+
 /* Record that an INSTRUCTION uses the as-yet undefined SYMBOL. */
 
 void
 record_inst_uses_symbol (instruction *inst, label *sym)
 {
-  label_use *u = (label_use *) xmalloc (sizeof (label_use));
-
   if (data_dir)			/* Want to free up original instruction */
-    {
-      u->inst = copy_inst (inst);
-      u->addr = current_data_pc ();
-    }
+    record_fixup (sym, copy_inst (inst), current_data_pc ());
   else
-    {
-      u->inst = inst;
-      u->addr = current_text_pc ();
-    }
-  u->next = sym->uses;
-  sym->uses = u;
+    record_fixup (sym, inst, current_text_pc ());
 }
 
 
@@ -248,36 +315,42 @@ record_inst_uses_symbol (instruction *inst, label *sym)
 void
 record_data_uses_symbol (mem_addr location, label *sym)
 {
-  label_use *u = (label_use *) xmalloc (sizeof (label_use));
-
-  u->inst = NULL;
-  u->addr = location;
-  u->next = sym->uses;
-  sym->uses = u;
+  record_fixup (sym, NULL, location);
 }
 
 
-/* Given a newly-defined LABEL, resolve the previously encountered
-   instructions and data locations that refer to the label. */
+/* Resolve the recorded uses of labels that are now defined, at the end
+   of a file.  Uses of labels that are still undefined (perhaps global
+   labels that a later file defines) are kept for the next time.
+
+   The uses are resolved newest first, as a load or store's fixup may
+   adjust the offset of the LUI before it, which must then be resolved
+   after it. */
 
 void
-resolve_label_uses (label *sym)
+resolve_label_uses ()
 {
-  label_use *use;
-  label_use *next_use;
+  int i;
+  int kept = 0;
 
-  for (use = sym->uses; use != NULL; use = next_use)
+  for (i = fixup_count - 1; i >= 0; i --)
     {
-      resolve_a_label_sub (sym, use->inst, use->addr);
+      label_use *use = &fixups [i];
+
+      if (!SYMBOL_IS_DEFINED (use->sym) && !use->sym->const_flag)
+	continue;
+      resolve_a_label_sub (use->sym, use->inst, use->addr);
       if (use->inst != NULL && use->addr >= DATA_BOT && use->addr < stack_bot)
 	{
 	  set_mem_word (use->addr, inst_encode (use->inst));
 	  free_inst (use->inst);
 	}
-      next_use = use->next;
-      free (use);
+      use->sym = NULL;
     }
-  sym->uses = NULL;
+  for (i = 0; i < fixup_count; i ++)
+    if (fixups [i].sym != NULL)
+      fixups [kept ++] = fixups [i];
+  fixup_count = kept;
 }
 
 
@@ -403,35 +476,45 @@ resolve_a_label_sub (label *sym, instruction *inst, mem_addr pc)
 void
 flush_local_labels (int issue_undef_warnings)
 {
-  label *l;
+  label *l, *last = NULL;
 
   for (l = local_labels; l != NULL; l = l->next_local)
     {
-      int hi;
-      label *entry, *lab, *p;
-
-      get_hash (l->name, &hi, &entry);
-
-      for (lab = label_hash_table [hi], p = NULL;
-	   lab;
-	   p = lab, lab = lab->next)
-	if (lab == entry)
-	  {
-	    if (p == NULL)
-	      label_hash_table [hi] = lab->next;
-	    else
-	      p->next = lab->next;
-	    if (issue_undef_warnings && entry->addr == 0 && !entry->const_flag)
-	      error ("Warning: local symbol %s was not defined\n",
-		     entry->name);
-	    /* Can't free label since IMM_EXPR's still reference it */
-	    break;
-	  }
+      remove_label (l);
+      if (issue_undef_warnings && l->addr == 0 && !l->const_flag)
+	error ("Warning: local symbol %s was not defined\n", l->name);
+      /* Can't free label since IMM_EXPR's still reference it */
+      last = l;
+    }
+  if (last != NULL)
+    {
+      /* Keep them, so map_symbols can still report them. */
+      last->next_local = flushed_labels;
+      flushed_labels = local_labels;
     }
   local_labels = NULL;
 }
 
 
+/* Return a new label with NAME on the list of local labels of files
+   already read.  Used when restoring a snapshot. */
+
+label *
+record_flushed_label (char *name)
+{
+  label *lab = (label *) xmalloc (sizeof (label));
+
+  lab->name = str_copy (name);
+  lab->addr = 0;
+  lab->global_flag = 0;
+  lab->const_flag = 0;
+  lab->gp_flag = 0;
+  lab->next_local = flushed_labels;
+  flushed_labels = lab;
+  return (lab);
+}
+
+
 /* Return the address of SYMBOL or 0 if it is undefined. */
 
 mem_addr
@@ -454,13 +537,43 @@ print_symbols ()
   int i;
   label *l;
 
-  for (i = 0; i < LABEL_HASH_TABLE_SIZE; i ++)
-    for (l = label_hash_table [i]; l != NULL; l = l->next)
+  for (i = 0; i < label_table_size; i ++)
+    if ((l = label_table [i]) != NULL)
       write_output (message_out, "%s%s at 0x%08x\n",
 		    l->global_flag ? "g\t" : "\t", l->name, l->addr);
 }
 
 
+/* Call FN on every label in the table, and on the local labels of
+   files already read, passing ARG along. */
+
+void
+map_symbols (void (*fn) (label *, void *), void *arg)
+{
+  int i;
+  label *l;
+
+  for (i = 0; i < label_table_size; i ++)
+    if ((l = label_table [i]) != NULL)
+      fn (l, arg);
+  for (l = flushed_labels; l != NULL; l = l->next_local)
+    fn (l, arg);
+}
+
+
+/* Call FN on each use of a label that is not yet resolved, oldest
+   first, passing ARG along. */
+
+void
+map_label_uses (void (*fn) (label_use *, void *), void *arg)
+{
+  int i;
+
+  for (i = 0; i < fixup_count; i ++)
+    fn (&fixups [i], arg);
+}
+
+
 /* Print all undefined symbols in the table. */
 
 void
@@ -469,9 +582,8 @@ print_undefined_symbols ()
   int i;
   label *l;
 
-  for (i = 0; i < LABEL_HASH_TABLE_SIZE; i ++)
-    for (l = label_hash_table [i]; l != NULL; l = l->next)
-      if (l->addr == 0)
+  for (i = 0; i < label_table_size; i ++)
+    if ((l = label_table [i]) != NULL && l->addr == 0)
 	write_output (message_out, "%s\n", l->name);
 }
 
@@ -490,9 +602,8 @@ undefined_symbol_string ()
   int i;
   label *l;
 
-  for (i = 0; i < LABEL_HASH_TABLE_SIZE; i ++)
-    for (l = label_hash_table[i]; l != NULL; l = l->next)
-      if (l->addr == 0)
+  for (i = 0; i < label_table_size; i ++)
+    if ((l = label_table [i]) != NULL && l->addr == 0)
       {
 	int name_length = (int)strlen(l->name);
 	int after_length = string_length + name_length + 2;
@@ -31,11 +31,14 @@
 */
 
 
+/* A use of a label that was not yet defined, to be fixed up at the end
+   of the file. */
+
 typedef struct lab_use
 {
+  struct lab *sym;		/* The label used */
   instruction *inst;		/* NULL => Data, not code */
   mem_addr addr;
-  struct lab_use *next;
 } label_use;
 
 
@@ -48,10 +51,8 @@ typedef struct lab
   unsigned global_flag : 1;	/* Non-zero => declared global */
   unsigned gp_flag : 1;		/* Non-zero => referenced off gp */
   unsigned const_flag : 1;	/* Non-zero => constant value (in addr) */
-  struct lab *next;		/* Hash table link */
   struct lab *next_local;	/* Link in list of local labels */
-  label_use *uses;		/* List of instructions that reference */
-} label;			/* label that has not yet been defined */
+} label;
 
 
 #define SYMBOL_IS_DEFINED(SYM) ((SYM)->addr != 0)
@@ -63,14 +64,18 @@ typedef struct lab
 mem_addr find_symbol_address (char *symbol);
 void flush_local_labels (int issue_undef_warnings);
 void initialize_symbol_table ();
+void map_label_uses (void (*fn) (label_use *, void *), void *arg);
+void map_symbols (void (*fn) (label *, void *), void *arg);
 label *label_is_defined (char *name);
 label *lookup_label (char *name);
 label *make_label_global (char *name);
 void print_symbols ();
 void print_undefined_symbols ();
-label *record_label (char *name, mem_addr address, int resolve_uses);
+label *record_flushed_label (char *name);
+label *record_label (char *name, mem_addr address);
 void record_data_uses_symbol (mem_addr location, label *sym);
+void record_fixup (label *sym, instruction *inst, mem_addr addr);
 void record_inst_uses_symbol (instruction *inst, label *sym);
 char *undefined_symbol_string ();
 void resolve_a_label (label *sym, instruction *inst);
-void resolve_label_uses (label *sym);
+void resolve_label_uses ();
@@ -51,6 +51,13 @@
 #include "mem.h"
 #include "sym-tbl.h"
 #include "syscall.h"
+#include "run.h"
+#include "timing.h"
+
+
+/* Exported variables: */
+
+long long spim_syscalls = 0;	/* Syscalls the program has made */
 
 
 #ifdef _WIN32
@@ -117,6 +124,7 @@ do_syscall ()
      use than the real syscall and are portable to non-MIPS operating
      systems. */
 
+  spim_syscalls += 1;
   switch (R[REG_V0])
     {
     case PRINT_INT_SYSCALL:
@@ -249,6 +257,35 @@ do_syscall ()
 	break;
       }
 
+    case READ_COUNTER_SYSCALL:
+      {
+	long long count;
+
+	switch (R[REG_A0])
+	  {
+	  case INSTRUCTIONS_COUNTER:
+	    count = spim_syscall_steps;
+	    break;
+
+	  case CYCLES_COUNTER:
+	    /* Without a timing model, assume one cycle per instruction. */
+	    count = spim_timing != NULL ? spim_timing->cycle : spim_syscall_steps;
+	    break;
+
+	  case SYSCALLS_COUNTER:
+	    count = spim_syscalls;
+	    break;
+
+	  default:
+	    run_error ("Unknown counter: %d\n", R[REG_A0]);
+	    count = 0;
+	    break;
+	  }
+	R[REG_RES] = (reg_word) count;		/* Low word */
+	R[REG_RES + 1] = (reg_word) (count >> 32); /* High word, in $v1 */
+	break;
+      }
+
     default:
       run_error ("Unknown system call: %d\n", R[REG_V0]);
       break;
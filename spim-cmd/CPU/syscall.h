@@ -31,6 +31,11 @@
 */
 
 
+/* Exported variables. */
+
+extern long long spim_syscalls;	/* Syscalls the program has made */
+
+
 /* Exported functions. */
 
 int do_syscall ();
@@ -60,3 +65,11 @@ void handle_exception ();
 
 #define EXIT2_SYSCALL		17
 
+#define READ_COUNTER_SYSCALL	18
+
+/* Counters READ_COUNTER_SYSCALL reads (its $a0): */
+
+#define INSTRUCTIONS_COUNTER	0	/* Instructions executed */
+#define CYCLES_COUNTER		1	/* Estimated cycles taken */
+#define SYSCALLS_COUNTER	2	/* Syscalls made, including this one */
+
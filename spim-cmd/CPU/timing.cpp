@@ -0,0 +1,488 @@
+/* SPIM S20 MIPS simulator.
+   Cycle-approximate timing model of a five-stage pipeline.
+   See timing.h for what is modeled. */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spim.h"
+#include "string-stream.h"
+#include "spim-utils.h"
+#include "inst.h"
+#include "reg.h"
+#include "mem.h"
+#include "parser_yacc.h"
+#include "timing.h"
+
+
+/* Exported variables: */
+
+timing_model *spim_timing = NULL; /* Pipeline being modeled, or NULL */
+
+
+/* Type of each opcode, from which the model finds the registers an
+   instruction reads and writes. */
+
+static name_val_val op_type_tbl [] = {
+#undef OP
+#define OP(NAME, I_OPCODE, TYPE, A_OPCODE) {NAME, I_OPCODE, TYPE},
+#include "op.h"
+};
+
+
+/* Defaults, roughly those of the classic R3000 pipeline. */
+
+#define DEFAULT_PREDICTOR_BITS	10
+#define DEFAULT_LOAD_LATENCY	1
+#define DEFAULT_MULT_LATENCY	5
+#define DEFAULT_DIV_LATENCY	35
+#define DEFAULT_MISPREDICT	2
+#define DEFAULT_TAKEN		1
+
+/* Cycles between the first instruction's fetch and its issue, and
+   after the last one issues, until it writes back. */
+
+#define PIPELINE_FILL		4
+
+
+/* Local functions: */
+
+static int branch_penalty (int penalty);
+static bool parse_latencies (timing_model *timing, char *spec);
+static bool parse_predictor (timing_model *timing, char *spec);
+static void print_ratio (char *buf, long long num, long long denom);
+static void resolve_branch (timing_model *timing);
+static void wait_for (timing_model *timing, int reg, long long *issue);
+
+
+
+/* Set the predictor of TIMING from SPEC, "bimodal" or "gshare",
+   optionally followed by ":BITS", the log2 of its number of counters.
+   Return false if SPEC is not valid. */
+
+static bool
+parse_predictor (timing_model *timing, char *spec)
+{
+  char *bits;
+
+  timing->gshare = false;
+  timing->predictor_bits = DEFAULT_PREDICTOR_BITS;
+  if (spec == NULL)
+    return (true);
+  if (strncmp (spec, "bimodal", 7) == 0)
+    bits = spec + 7;
+  else if (strncmp (spec, "gshare", 6) == 0)
+    {
+      timing->gshare = true;
+      bits = spec + 6;
+    }
+  else
+    return (false);
+
+  if (*bits == '\0')
+    return (true);
+  if (*bits != ':' || sscanf (bits + 1, "%d", &timing->predictor_bits) != 1)
+    return (false);
+  return (1 <= timing->predictor_bits && timing->predictor_bits <= 24);
+}
+
+
+/* Set the latencies of TIMING from SPEC, a comma-separated list of
+   NAME=CYCLES, where NAME is load, mult, div, mispredict, or taken.
+   Return false if SPEC is not valid. */
+
+static bool
+parse_latencies (timing_model *timing, char *spec)
+{
+  timing->load_latency = DEFAULT_LOAD_LATENCY;
+  timing->mult_latency = DEFAULT_MULT_LATENCY;
+  timing->div_latency = DEFAULT_DIV_LATENCY;
+  timing->mispredict_penalty = DEFAULT_MISPREDICT;
+  timing->taken_penalty = DEFAULT_TAKEN;
+  if (spec == NULL)
+    return (true);
+
+  while (*spec != '\0')
+    {
+      char name[16];
+      int cycles, length;
+
+      if (sscanf (spec, "%15[a-z]=%d%n", name, &cycles, &length) != 2
+	  || cycles < 0)
+	return (false);
+      if (streq (name, "load"))
+	timing->load_latency = cycles;
+      else if (streq (name, "mult"))
+	timing->mult_latency = cycles;
+      else if (streq (name, "div"))
+	timing->div_latency = cycles;
+      else if (streq (name, "mispredict"))
+	timing->mispredict_penalty = cycles;
+      else if (streq (name, "taken"))
+	timing->taken_penalty = cycles;
+      else
+	return (false);
+      spec += length;
+      if (*spec == ',')
+	spec += 1;
+      else if (*spec != '\0')
+	return (false);
+    }
+  return (true);
+}
+
+
+/* Return a model of the pipeline with the branch predictor described by
+   PREDICTOR_SPEC (see parse_predictor) and latencies described by
+   LATENCY_SPEC (see parse_latencies).  A NULL spec takes the defaults.
+   Return NULL if either spec is not valid. */
+
+timing_model *
+timing_create (char *predictor_spec, char *latency_spec)
+{
+  timing_model *timing = (timing_model *) zmalloc (sizeof (timing_model));
+  int n = sizeof (op_type_tbl) / sizeof (name_val_val);
+  int i;
+
+  if (!parse_predictor (timing, predictor_spec))
+    {
+      error ("Bad branch predictor: %s (want bimodal[:BITS] or gshare[:BITS])\n",
+	     predictor_spec);
+      free (timing);
+      return (NULL);
+    }
+  if (!parse_latencies (timing, latency_spec))
+    {
+      error ("Bad latencies: %s (want NAME=CYCLES,... with NAME one of load, mult, div, mispredict, taken)\n",
+	     latency_spec);
+      free (timing);
+      return (NULL);
+    }
+
+  /* Counters start weakly taken. */
+  timing->counters = (unsigned char *) xmalloc (1 << timing->predictor_bits);
+  memset (timing->counters, 2, 1 << timing->predictor_bits);
+
+  for (i = 0; i < n; i ++)
+    if (op_type_tbl[i].value1 >= timing->op_count)
+      timing->op_count = op_type_tbl[i].value1 + 1;
+  timing->op_types = (unsigned char *) zmalloc (timing->op_count);
+  for (i = 0; i < n; i ++)
+    if (op_type_tbl[i].value1 >= 0)
+      timing->op_types [op_type_tbl[i].value1] = (unsigned char) op_type_tbl[i].value2;
+  return (timing);
+}
+
+
+void
+timing_free (timing_model *timing)
+{
+  if (timing == NULL)
+    return;
+  free (timing->counters);
+  free (timing->op_types);
+  free (timing);
+}
+
+
+/* Return PENALTY, less the cycle a branch delay slot fills. */
+
+static int
+branch_penalty (int penalty)
+{
+  if (delayed_branches)
+    penalty -= 1;
+  return (penalty < 0 ? 0 : penalty);
+}
+
+
+/* Delay *ISSUE until the value of register REG is ready, charging the
+   stall to what produced the value. */
+
+static void
+wait_for (timing_model *timing, int reg, long long *issue)
+{
+  if (reg <= 0 || timing->ready[reg] <= *issue)
+    return;
+  if (timing->ready_after_load[reg])
+    timing->load_stalls += timing->ready[reg] - *issue;
+  else
+    timing->muldiv_stalls += timing->ready[reg] - *issue;
+  *issue = timing->ready[reg];
+}
+
+
+/* The branch at TIMING->branch_pc is resolved, as PC now holds the
+   instruction after it (and its delay slot).  Train the predictor and
+   charge any cycles lost. */
+
+static void
+resolve_branch (timing_model *timing)
+{
+  mem_addr next = timing->branch_pc + (delayed_branches ? 2 : 1) * BYTES_PER_WORD;
+  bool taken = (PC != next);
+  unsigned char *counter = &timing->counters [timing->branch_slot];
+  int lost;
+
+  if (taken && *counter < 3)
+    *counter += 1;
+  else if (!taken && *counter > 0)
+    *counter -= 1;
+  timing->history = (timing->history << 1) | taken;
+
+  if (taken != timing->branch_predicted)
+    {
+      timing->mispredicts += 1;
+      lost = branch_penalty (timing->mispredict_penalty);
+      timing->mispredict_stalls += lost;
+    }
+  else if (taken)
+    {
+      lost = branch_penalty (timing->taken_penalty);
+      timing->taken_stalls += lost;
+    }
+  else
+    lost = 0;
+  timing->cycle += lost;
+  timing->branch_pc = 0;
+}
+
+
+/* Account for the instruction INST at PC, which is about to execute. */
+
+void
+timing_step (inst_code *inst)
+{
+  timing_model *timing = spim_timing;
+  int opcode = OPCODE (inst);
+  int type = opcode < timing->op_count ? timing->op_types [opcode] : 0;
+  int src1 = 0, src2 = 0, dest = 0;
+  int latency = 1;
+  bool is_load = false, is_muldiv = false, is_branch = false, is_jump = false;
+  long long issue;
+
+  if (timing->branch_pc != 0 && --timing->branch_countdown == 0)
+    resolve_branch (timing);
+
+  switch (type)
+    {
+    case R3_TYPE_INST:
+    case R3sh_TYPE_INST:
+      src1 = RS (inst);
+      src2 = RT (inst);
+      dest = RD (inst);
+      if (opcode == Y_MUL_OP)
+	latency = timing->mult_latency;
+      break;
+
+    case R2sh_TYPE_INST:
+    case R2td_TYPE_INST:
+      src1 = RT (inst);
+      dest = RD (inst);
+      break;
+
+    case R2ds_TYPE_INST:	/* jalr */
+      src1 = RS (inst);
+      dest = RD (inst);
+      is_jump = true;
+      break;
+
+    case R2st_TYPE_INST:
+      src1 = RS (inst);
+      src2 = RT (inst);
+      switch (opcode)
+	{
+	case Y_MULT_OP:
+	case Y_MULTU_OP:
+	case Y_MADD_OP:
+	case Y_MADDU_OP:
+	case Y_MSUB_OP:
+	case Y_MSUBU_OP:
+	  is_muldiv = true;
+	  latency = timing->mult_latency;
+	  break;
+
+	case Y_DIV_OP:
+	case Y_DIVU_OP:
+	  is_muldiv = true;
+	  latency = timing->div_latency;
+	  break;
+
+	default:
+	  break;
+	}
+      break;
+
+    case R1s_TYPE_INST:
+      src1 = RS (inst);
+      if (opcode == Y_MTHI_OP || opcode == Y_MTLO_OP)
+	dest = TIMING_HILO;
+      else
+	is_jump = true;		/* jr */
+      break;
+
+    case R1d_TYPE_INST:		/* mfhi, mflo */
+      src1 = TIMING_HILO;
+      dest = RD (inst);
+      break;
+
+    case MOVC_TYPE_INST:
+      src1 = RS (inst);
+      dest = RD (inst);
+      break;
+
+    case I2_TYPE_INST:
+      src1 = RS (inst);
+      dest = RT (inst);
+      break;
+
+    case I1t_TYPE_INST:		/* lui */
+      dest = RT (inst);
+      break;
+
+    case I1s_TYPE_INST:		/* Trap on immediate */
+      src1 = RS (inst);
+      break;
+
+    case I2a_TYPE_INST:
+      src1 = BASE (inst);
+      switch (opcode)
+	{
+	case Y_SB_OP:
+	case Y_SH_OP:
+	case Y_SW_OP:
+	case Y_SWL_OP:
+	case Y_SWR_OP:
+	case Y_SC_OP:
+	  src2 = RT (inst);
+	  break;
+
+	case Y_LDC2_OP:
+	case Y_LWC2_OP:
+	case Y_SDC2_OP:
+	case Y_SWC2_OP:
+	  break;
+
+	default:
+	  dest = RT (inst);
+	  is_load = true;
+	  latency = 1 + timing->load_latency;
+	  break;
+	}
+      break;
+
+    case FP_I2a_TYPE_INST:
+      src1 = BASE (inst);
+      break;
+
+    case B1_TYPE_INST:
+      src1 = RS (inst);
+      is_branch = true;
+      if (opcode == Y_BGEZAL_OP || opcode == Y_BGEZALL_OP
+	  || opcode == Y_BLTZAL_OP || opcode == Y_BLTZALL_OP)
+	dest = 31;		/* Links, taken or not. */
+      break;
+
+    case B2_TYPE_INST:
+      src1 = RS (inst);
+      src2 = RT (inst);
+      is_branch = true;
+      break;
+
+    case BC_TYPE_INST:
+      is_branch = true;
+      break;
+
+    case J_TYPE_INST:
+      is_jump = true;
+      if (opcode == Y_JAL_OP)
+	dest = 31;
+      break;
+
+    default:
+      break;
+    }
+
+  issue = timing->cycle + 1;
+  wait_for (timing, src1, &issue);
+  wait_for (timing, src2, &issue);
+  if (is_muldiv)
+    {
+      /* The multiply/divide unit is not pipelined. */
+      wait_for (timing, TIMING_HILO, &issue);
+      timing->ready [TIMING_HILO] = issue + latency;
+      timing->ready_after_load [TIMING_HILO] = false;
+    }
+  else if (dest != 0)
+    {
+      timing->ready [dest] = issue + latency;
+      timing->ready_after_load [dest] = is_load;
+    }
+  timing->cycle = issue;
+  timing->instructions += 1;
+
+  if (is_branch)
+    {
+      uint32 slot = PC >> 2;
+
+      if (timing->gshare)
+	slot ^= timing->history;
+      slot &= (1 << timing->predictor_bits) - 1;
+      timing->branches += 1;
+      timing->branch_pc = PC;
+      timing->branch_countdown = delayed_branches ? 2 : 1;
+      timing->branch_slot = slot;
+      timing->branch_predicted = (timing->counters [slot] >= 2);
+    }
+  else if (is_jump)
+    {
+      int lost = branch_penalty (timing->taken_penalty);
+
+      timing->taken_stalls += lost;
+      timing->cycle += lost;
+    }
+}
+
+
+
+/* Reporting. */
+
+static void
+print_ratio (char *buf, long long num, long long denom)
+{
+  if (denom == 0)
+    strcpy (buf, "-");
+  else
+    sprintf (buf, "%.4f", (double) num / (double) denom);
+}
+
+
+/* Report, on standard error, the estimated cycles and CPI, the cycles
+   lost to each kind of stall, and the predictor's accuracy, as lines of
+   fields separated by tabs, each table after a line naming its
+   fields. */
+
+void
+timing_report (timing_model *timing)
+{
+  long long cycles = timing->instructions == 0 ? 0 : timing->cycle + PIPELINE_FILL;
+  char cpi[32], accuracy[32];
+
+  print_ratio (cpi, cycles, timing->instructions);
+  error ("timing\tcycles\tinstructions\tcpi\n");
+  error ("pipeline\t%lld\t%lld\t%s\n", cycles, timing->instructions, cpi);
+
+  error ("stall\tcycles\n");
+  error ("load_use\t%lld\n", timing->load_stalls);
+  error ("muldiv\t%lld\n", timing->muldiv_stalls);
+  error ("mispredict\t%lld\n", timing->mispredict_stalls);
+  error ("taken\t%lld\n", timing->taken_stalls);
+  error ("fill\t%d\n", timing->instructions == 0 ? 0 : PIPELINE_FILL);
+
+  print_ratio (accuracy, timing->branches - timing->mispredicts, timing->branches);
+  error ("predictor\tbits\tbranches\tmispredicts\taccuracy\n");
+  error ("%s\t%d\t%lld\t%lld\t%s\n", timing->gshare ? "gshare" : "bimodal",
+	 timing->predictor_bits, timing->branches, timing->mispredicts, accuracy);
+}
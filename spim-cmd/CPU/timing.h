@@ -0,0 +1,83 @@
+/* SPIM S20 MIPS simulator.
+   Cycle-approximate timing model of a five-stage pipeline.
+
+   The model estimates the cycles a classic in-order pipeline (fetch,
+   decode, execute, memory, write back) with full forwarding would take
+   to run the instructions spim executes.  An instruction normally
+   issues one cycle after the one before it, and later when:
+
+   - it reads a register that a load just before it writes (the
+     load-use stall, `load' extra cycles);
+   - it reads a register written by mul, or reads hi or lo (or starts
+     another multiply or divide) before a mult or div finishes (`mult'
+     and `div' cycles after it issues);
+   - it follows a conditional branch whose direction was mispredicted
+     (`mispredict' cycles), or any taken branch or jump, whose target
+     is known only in decode (`taken' cycles).
+
+   With delayed branches, the delay slot fills one of those cycles.
+   Conditional branches are predicted by a table of 2-bit saturating
+   counters indexed either by the branch's address (bimodal) or by its
+   address xor the recent branch history (gshare).  Floating point
+   registers, coprocessor 0, and the memory system are not modeled; see
+   cache.h for a model of the caches.
+
+   run_spim reports each instruction to the model in spim_timing before
+   it executes. */
+
+
+#ifndef TIMING_H
+#define TIMING_H
+
+/* Pseudo-register standing for hi and lo in the model's scoreboard. */
+
+#define TIMING_HILO		32
+
+
+typedef struct timing_model
+{
+  /* Parameters: */
+  int load_latency;		/* Extra cycles before a load's value is ready */
+  int mult_latency;		/* Cycles before a multiply's result is ready */
+  int div_latency;		/* Cycles before a divide's result is ready */
+  int mispredict_penalty;	/* Cycles lost to a mispredicted branch */
+  int taken_penalty;		/* Cycles lost to a taken branch or jump */
+  bool gshare;			/* => index predictor by pc xor history */
+  int predictor_bits;		/* log2 (entries in predictor) */
+
+  /* State: */
+  unsigned char *counters;	/* 2-bit counters, 1 << predictor_bits */
+  uint32 history;		/* Recent branch outcomes, 1 => taken */
+  unsigned char *op_types;	/* op.h type of each opcode */
+  int op_count;
+  long long ready[TIMING_HILO + 1]; /* Cycle each register's value is ready */
+  bool ready_after_load[TIMING_HILO + 1]; /* => register last written by load */
+  long long cycle;		/* Cycle the last instruction issued */
+  mem_addr branch_pc;		/* Branch awaiting its outcome, or 0 */
+  int branch_countdown;		/* Instructions until it is known */
+  int branch_slot;		/* Predictor counter it used */
+  bool branch_predicted;	/* => predicted taken */
+
+  /* Counts: */
+  long long instructions;
+  long long branches, mispredicts;
+  long long load_stalls;	/* Cycles lost to each cause */
+  long long muldiv_stalls;
+  long long mispredict_stalls;
+  long long taken_stalls;
+} timing_model;
+
+
+/* Exported variables: */
+
+extern timing_model *spim_timing; /* Pipeline being modeled, or NULL */
+
+
+/* Exported functions: */
+
+timing_model *timing_create (char *predictor_spec, char *latency_spec);
+void timing_free (timing_model *timing);
+void timing_report (timing_model *timing);
+void timing_step (inst_code *inst);
+
+#endif
@@ -0,0 +1,241 @@
+/* SPIM S20 MIPS simulator.
+   In-process interface for SPIM simulator (see spim-embed.h).
+
+   This file stands in for spim.cpp when the simulator is linked into
+   another program: it defines the variables and IO hooks that the CPU
+   code expects from its front end, but keeps the program's console in
+   memory rather than on the terminal.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+
+#include "spim.h"
+#include "string-stream.h"
+#include "spim-utils.h"
+#include "inst.h"
+#include "reg.h"
+#include "mem.h"
+#include "sym-tbl.h"
+#include "spim-embed.h"
+
+
+/* Exported Variables: */
+
+bool bare_machine;		/* => simulate bare machine */
+bool delayed_branches;		/* => simulate delayed branches */
+bool delayed_loads;		/* => simulate delayed loads */
+bool accept_pseudo_insts;	/* => parse pseudo instructions  */
+bool quiet;			/* => no warning messages */
+char *exception_file_name = DEFAULT_EXCEPTION_HANDLER;
+port message_out, console_out, console_in;
+bool mapped_io;			/* => activate memory-mapped IO */
+int spim_return_value;		/* Value returned when spim exits */
+
+
+/* Local variables: */
+
+static jmp_buf embed_run_env;	/* Target of run_error */
+static char *exception_file = NULL;
+
+static const char *input_buf;	/* Program's console input */
+static size_t input_len;
+static size_t input_pos;
+
+static char *output_buf = NULL;	/* Program's console output */
+static size_t output_len = 0;
+
+
+/* Start a new, empty console output buffer. */
+
+static void
+reset_console ()
+{
+  if (console_out.f != NULL)
+    fclose (console_out.f);
+  free (output_buf);
+  output_buf = NULL;
+  output_len = 0;
+  console_out.f = open_memstream (&output_buf, &output_len);
+  if (console_out.f == NULL)
+    fatal_error ("Cannot allocate console buffer\n");
+}
+
+
+void
+spim_embed_initialize (const char *exception_file_name, int text_size)
+{
+  bare_machine = false;
+  delayed_branches = false;
+  delayed_loads = false;
+  accept_pseudo_insts = true;
+  quiet = true;
+  mapped_io = false;
+  spim_return_value = 0;
+  if (text_size > 0)
+    initial_text_size = text_size;
+
+  message_out.f = stderr;
+  console_in.i = 0;
+  reset_console ();
+
+  free (exception_file);
+  exception_file = exception_file_name == NULL ? NULL : str_copy ((char *) exception_file_name);
+}
+
+
+bool
+spim_embed_load (const char *file_name)
+{
+  initialize_world (exception_file, false);
+  if (!read_assembly_file ((char *) file_name))
+    return (false);
+  initialize_run_stack (0, NULL);
+  return (true);
+}
+
+
+bool
+spim_embed_run (const char *input, size_t len)
+{
+  bool continuable;
+
+  input_buf = input;
+  input_len = len;
+  input_pos = 0;
+  spim_return_value = 0;
+
+  reset_console ();
+
+  if (setjmp (embed_run_env))
+    {
+      fflush (console_out.f);
+      return (false);
+    }
+  run_program (find_symbol_address (DEFAULT_RUN_LOCATION), DEFAULT_RUN_STEPS,
+	       false, false, &continuable);
+  fflush (console_out.f);
+  return (true);
+}
+
+
+const char *
+spim_embed_output (size_t *len)
+{
+  fflush (console_out.f);
+  if (len != NULL)
+    *len = output_len;
+  return (output_buf);
+}
+
+
+int
+spim_embed_return_value ()
+{
+  return (spim_return_value);
+}
+
+
+
+/* Print an error message. */
+
+void
+error (char *fmt, ...)
+{
+  va_list args;
+
+  va_start (args, fmt);
+  vfprintf (stderr, fmt, args);
+  va_end (args);
+}
+
+
+/* Print the error message then exit. */
+
+void
+fatal_error (char *fmt, ...)
+{
+  va_list args;
+
+  va_start (args, fmt);
+  vfprintf (stderr, fmt, args);
+  va_end (args);
+  exit (-1);
+}
+
+
+/* Print an error message and abandon the current run. */
+
+void
+run_error (char *fmt, ...)
+{
+  va_list args;
+
+  va_start (args, fmt);
+  vfprintf (stderr, fmt, args);
+  va_end (args);
+  longjmp (embed_run_env, 1);
+}
+
+
+
+/* IO facilities: */
+
+void
+write_output (port fp, char *fmt, ...)
+{
+  va_list args;
+  FILE *f = fp.f != 0 ? fp.f : stdout;
+
+  va_start (args, fmt);
+  vfprintf (f, fmt, args);
+  va_end (args);
+}
+
+
+/* Simulate the semantics of fgets (not gets) on the input buffer. */
+
+void
+read_input (char *str, int str_size)
+{
+  char *ptr = str;
+
+  while (1 < str_size && input_pos < input_len)	/* Reserve space for null */
+    {
+      char c = input_buf[input_pos++];
+
+      *ptr ++ = c;
+      str_size -= 1;
+
+      if (c == '\n')
+	break;
+    }
+
+  if (0 < str_size)
+    *ptr = '\0';		/* Null terminate input */
+}
+
+
+int
+console_input_available ()
+{
+  return (input_pos < input_len);
+}
+
+
+char
+get_console_char ()
+{
+  return (input_pos < input_len ? input_buf[input_pos++] : '\0');
+}
+
+
+void
+put_console_char (char c)
+{
+  putc (c, console_out.f);
+}
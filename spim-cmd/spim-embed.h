@@ -0,0 +1,50 @@
+/* SPIM S20 MIPS simulator.
+   Interface for running SPIM inside another program.
+
+   The terminal interface (spim.cpp) owns the console and the command
+   loop.  This interface instead provides the same front-end hooks
+   (write_output, read_input, run_error, ...) with the program's console
+   routed through memory: input comes from a caller-supplied buffer and
+   output accumulates in a buffer the caller can inspect after the run.
+   It is used by the DwiSlpy benchmark and test harnesses, which link
+   the CPU objects (libspim.a) together with spim-embed.o instead of
+   spim.o.  A harness that runs one program many times can load it
+   once, take_snapshot, and restore_snapshot (CPU/snapshot.h) before
+   each later run instead of assembling it again.
+*/
+
+
+#ifndef SPIM_EMBED_H
+#define SPIM_EMBED_H
+
+#include <stddef.h>
+
+
+/* Set the simulator's flags to spim's defaults and remember the file
+   holding the exception handler (NULL => do not load one).  TEXT_SIZE,
+   if positive, overrides the size of the text segment (as -stext does
+   for spim). */
+
+void spim_embed_initialize (const char *exception_file, int text_size);
+
+/* Reinitialize memory and registers, load the exception handler, and
+   assemble FILE_NAME.  Return false if the file cannot be read. */
+
+bool spim_embed_load (const char *file_name);
+
+/* Run the loaded program from __start, feeding it INPUT as its console
+   input.  Return true if the program ran to completion (as opposed to
+   stopping on a run-time error). */
+
+bool spim_embed_run (const char *input, size_t input_len);
+
+/* The console output written by the last run.  The buffer is owned by
+   the interface and is valid until the next run. */
+
+const char *spim_embed_output (size_t *len);
+
+/* The value the program passed to exit (0 for the plain exit syscall). */
+
+int spim_embed_return_value ();
+
+#endif
@@ -39,6 +39,7 @@
 #include <setjmp.h>
 #include <signal.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
 
 
 #ifdef RS
@@ -79,6 +80,13 @@
 #include "scanner.h"
 #include "parser_yacc.h"
 #include "data.h"
+#include "run.h"
+#include "trace-ring.h"
+#include "syscall.h"
+#include "snapshot.h"
+#include "cache.h"
+#include "timing.h"
+#include "profile.h"
 
 
 /* Internal functions: */
@@ -98,8 +106,20 @@ static int str_prefix (char *s1, char *s2, int min_match);
 static void top_level ();
 static int read_token ();
 static bool write_assembled_code(char* program_name);
+static void name_label_in_trace (label *l, void *ring);
+static void dump_binary_seg (FILE *fp, mem_addr from, mem_addr to, bool text);
 static void dump_data_seg (bool kernel_also);
 static void dump_text_seg (bool kernel_also);
+static FILE *open_dump_file (char *name);
+static char *read_whole_file (char *file_name, size_t *len);
+static int run_batch (char *manifest_name);
+static const char *run_batch_entry (spim_snapshot *base, char *program,
+				    char *input, char *expected);
+static bool run_loaded_program (bool *continuable);
+static void nearer_label (label *l, void *arg);
+static void report_run_limit ();
+static int run_steps ();
+static bool stopped_at_limit (bool continuable);
 
 
 /* Exported Variables: */
@@ -134,6 +154,30 @@ static int program_argc;
 static char** program_argv;
 static bool dump_user_segments = false;
 static bool dump_all_segments = false;
+static bool dump_binary = false; /* => dumps are binary images */
+static char *trace_file_name = NULL;
+static char *snapshot_file_name = NULL;
+static char *batch_file_name = NULL;
+static int max_run_steps = 0;	/* => stop a run after this many steps */
+static int max_run_ms = 0;	/* => stop a run after this many milliseconds */
+static char *l1i_spec = NULL;	/* Instruction cache to model, or NULL */
+static char *l1d_spec = NULL;	/* Data cache to model, or NULL */
+static bool timing_on = false;	/* => model the pipeline's timing */
+static char *predictor_spec = NULL; /* Its branch predictor, or NULL */
+static char *latency_spec = NULL; /* Its latencies, or NULL */
+static char *profile_file_name = NULL; /* Where to write a profile, or NULL */
+static int profile_interval = PROFILE_DEFAULT_INTERVAL;
+
+
+/* Value spim exits with when a run is stopped at a limit (as timeout(1)
+   does). */
+
+#define LIMIT_EXIT_VALUE 124
+
+
+/* Bytes of output buffered for the files that -dump writes. */
+
+#define DUMP_BUFFER_SIZE (1 << 20)
 
 
 
@@ -278,12 +322,67 @@ main (int argc, char **argv)
 	  assembly_file_loaded = read_assembly_file (argv[++i]) || assembly_file_loaded;
 	  break;
 	}
+      else if (streq (argv [i], "-restore")
+	       && i + 1 < argc)
+	{
+	  spim_snapshot *snap;
+
+	  program_argc = argc - (i + 1);
+	  program_argv = &argv[i + 1]; /* Everything following is argv */
+
+	  snap = read_snapshot (argv[++i]);
+	  if (snap == NULL || !restore_snapshot (snap))
+	    fatal_error ("Cannot restore snapshot: %s\n", argv[i]);
+	  free_snapshot (snap);
+	  assembly_file_loaded = true;
+	  break;
+	}
+      else if (streq (argv [i], "-max_steps")
+	       && i + 1 < argc)
+	{ max_run_steps = atoi (argv[++i]); }
+      else if (streq (argv [i], "-max_ms")
+	       && i + 1 < argc)
+	{ max_run_ms = atoi (argv[++i]); }
+      else if (streq (argv [i], "-l1i")
+	       && i + 1 < argc)
+	{ l1i_spec = argv[++i]; }
+      else if (streq (argv [i], "-l1d")
+	       && i + 1 < argc)
+	{ l1d_spec = argv[++i]; }
+      else if (streq (argv [i], "-timing"))
+	{ timing_on = true; }
+      else if (streq (argv [i], "-predictor")
+	       && i + 1 < argc)
+	{ timing_on = true; predictor_spec = argv[++i]; }
+      else if (streq (argv [i], "-latency")
+	       && i + 1 < argc)
+	{ timing_on = true; latency_spec = argv[++i]; }
+      else if (streq (argv [i], "-batch")
+	       && i + 1 < argc)
+	{ batch_file_name = argv[++i]; }
+      else if (streq (argv [i], "-snapshot")
+	       && i + 1 < argc)
+	{ snapshot_file_name = argv[++i]; }
       else if (streq (argv [i], "-assemble"))
 	{ assemble = true; }
       else if (streq (argv [i], "-dump"))
         { dump_user_segments = true; }
       else if (streq (argv [i], "-full_dump"))
         { dump_all_segments = true; }
+      else if (streq (argv [i], "-dump_binary"))
+        { dump_binary = true; }
+      else if (streq (argv [i], "-trace")
+	       && i + 1 < argc)
+	{ trace_file_name = argv[++i]; }
+      else if (streq (argv [i], "-trace_interval")
+	       && i + 1 < argc)
+	{ spim_trace_interval = atoi (argv[++i]); }
+      else if (streq (argv [i], "-profile")
+	       && i + 1 < argc)
+	{ profile_file_name = argv[++i]; }
+      else if (streq (argv [i], "-profile_interval")
+	       && i + 1 < argc)
+	{ profile_interval = atoi (argv[++i]); }
       else
 	{
 	  error ("\nUnknown argument: %s (ignored)\n", argv[i]);
@@ -306,12 +405,30 @@ main (int argc, char **argv)
 	-mapped_io		Enable memory-mapped IO\n\
 	-nomapped_io		Do not enable memory-mapped IO (default)\n\
 	-file <file> <args>	Assembly code file and arguments to program\n\
+	-snapshot <file>	Write a snapshot of the loaded program to file, do not run it\n\
+	-restore <file> <args>	Run the program in a snapshot file, with arguments\n\
+	-batch <manifest>	Run and check each program listed in manifest\n\
+	-max_steps <n>		Stop a program after it executes n instructions\n\
+	-max_ms <n>		Stop a program after it runs for n milliseconds\n\
+	-l1i <size:assoc:line>	Model an instruction cache and report its misses\n\
+	-l1d <size:assoc:line>	Model a data cache and report its misses\n\
+	-timing			Estimate the cycles a 5-stage pipeline takes, and report its CPI\n\
+	-predictor <kind[:bits]> Predict branches by bimodal (default) or gshare counters\n\
+	-latency <name=n,...>	Set timing latencies: load, mult, div, mispredict, taken\n\
 	-assemble		Write assembled code to standard output\n\
 	-dump			Write user data and text segments into files\n\
-	-full_dump		Write user and kernel data and text into files.\n");
+	-full_dump		Write user and kernel data and text into files.\n\
+	-dump_binary		Make -dump and -full_dump write binary images (text.bin, data.bin)\n\
+	-trace <file>		Write a trace of PC samples and syscalls to file\n\
+	-trace_interval <n>	Sample the PC every n instructions (default 1000)\n\
+	-profile <file>		Write folded call stacks sampled as the program runs to file\n\
+	-profile_interval <n>	Sample the call stack about every n instructions (default 1000)\n");
     }
 
 
+  if (batch_file_name != NULL)
+    return (run_batch (batch_file_name));
+
   if (!assembly_file_loaded)
     {
       initialize_world (load_exception_handler ? exception_file_name : NULL, true);
@@ -324,6 +441,17 @@ main (int argc, char **argv)
        {
          return write_assembled_code (program_argv[0]);
        }
+     else if (snapshot_file_name != NULL)
+       {
+         spim_snapshot *snap = take_snapshot ();
+
+         if (!write_snapshot (snap, snapshot_file_name))
+           {
+             error ("Cannot write snapshot file %s\n", snapshot_file_name);
+             spim_return_value = 1;
+           }
+         free_snapshot (snap);
+       }
      else if (dump_user_segments)
        {
          dump_data_seg (false);
@@ -337,8 +465,27 @@ main (int argc, char **argv)
      else
        {
          bool continuable;
-         console_to_program ();
+         trace_ring ring;
+         if (trace_file_name != NULL)
+           {
+             if (spim_trace_interval < 1)
+               spim_trace_interval = 1;
+             if (!trace_open (&ring, TRACE_DEFAULT_EVENTS))
+               fatal_error ("Cannot allocate trace\n");
+             spim_trace = &ring;
+           }
          initialize_run_stack (program_argc, program_argv);
+         if (l1i_spec != NULL || l1d_spec != NULL)
+           {
+             if ((spim_cache = cache_create (l1i_spec, l1d_spec)) == NULL)
+               return (1);
+           }
+         if (timing_on
+             && (spim_timing = timing_create (predictor_spec, latency_spec)) == NULL)
+           return (1);
+         if (profile_file_name != NULL)
+           spim_profile = profile_create (profile_interval);
+         console_to_program ();
          if (!setjmp (spim_top_level_env))
            {
              char *undefs = undefined_symbol_string ();
@@ -349,9 +496,47 @@ main (int argc, char **argv)
                  write_output (message_out, "\n");
                  free (undefs);
                }
-             run_program (find_symbol_address (DEFAULT_RUN_LOCATION), DEFAULT_RUN_STEPS, false, false, &continuable);
+             spim_steps = 0;
+             spim_syscalls = 0;
+             set_run_time_limit (max_run_ms);
+             run_program (find_symbol_address (DEFAULT_RUN_LOCATION), run_steps (), false, false, &continuable);
+             if (stopped_at_limit (continuable))
+               report_run_limit ();
            }
          console_to_spim ();
+         if (spim_trace != NULL)
+           {
+             spim_trace = NULL;
+             map_symbols (name_label_in_trace, &ring);
+             if (!trace_write (&ring, trace_file_name))
+               error ("Cannot write trace file %s\n", trace_file_name);
+             trace_close (&ring);
+           }
+         if (spim_cache != NULL)
+           {
+             cache_model *cache = spim_cache;
+
+             spim_cache = NULL;
+             cache_report (cache);
+             cache_free (cache);
+           }
+         if (spim_timing != NULL)
+           {
+             timing_model *timing = spim_timing;
+
+             spim_timing = NULL;
+             timing_report (timing);
+             timing_free (timing);
+           }
+         if (spim_profile != NULL)
+           {
+             profile_model *profile = spim_profile;
+
+             spim_profile = NULL;
+             if (!profile_write (profile, profile_file_name))
+               error ("Cannot write profile file %s\n", profile_file_name);
+             profile_free (profile);
+           }
        }
     }
 
@@ -393,6 +578,268 @@ control_c_seen (int /*arg*/)
 }
 
 
+/* Batch mode.
+
+   Each line of the manifest names a program, the file to use as its
+   console input, and the file holding its expected console output,
+   separated by blanks; "-" stands for no file (no input, or nothing to
+   check).  Blank lines and lines starting with # are skipped.  The
+   exception handler is assembled once, and a snapshot of the machine
+   taken then is restored before each program is loaded, so every
+   program starts from a fresh memory image without a new process.
+
+   One line is written to standard output for each program:
+
+	<program> TAB <status> TAB <exit value> TAB <microseconds>
+
+   where status is "pass" or "fail" (output compared with the expected
+   file), "ran" (nothing to compare against), "error" (the run stopped
+   on a run-time error), "limit" (the run was stopped by -max_steps or
+   -max_ms, see report_run_limit), "noload" (the program could not be
+   read), or
+   "noinput" (the input file could not be opened).  spim exits with 0
+   if every program passed or ran. */
+
+static int
+run_batch (char *manifest_name)
+{
+  FILE *manifest = fopen (manifest_name, "r");
+  char line[4096];
+  spim_snapshot *base;
+  int programs = 0, bad = 0;
+
+  if (manifest == NULL)
+    {
+      error ("Cannot read batch manifest %s\n", manifest_name);
+      return (1);
+    }
+
+  initialize_world (load_exception_handler ? exception_file_name : NULL, false);
+  base = take_snapshot ();
+
+  while (fgets (line, sizeof (line), manifest) != NULL)
+    {
+      char *program = strtok (line, " \t\r\n");
+      char *input = strtok (NULL, " \t\r\n");
+      char *expected = strtok (NULL, " \t\r\n");
+      const char *status;
+      struct timeval start, end;
+
+      if (program == NULL || program[0] == '#')
+	continue;
+      if (input != NULL && streq (input, "-"))
+	input = NULL;
+      if (expected != NULL && streq (expected, "-"))
+	expected = NULL;
+
+      gettimeofday (&start, NULL);
+      status = run_batch_entry (base, program, input, expected);
+      gettimeofday (&end, NULL);
+
+      programs += 1;
+      if (!streq (status, "pass") && !streq (status, "ran"))
+	bad += 1;
+      write_output (message_out, "%s\t%s\t%d\t%ld\n", program, status,
+		    spim_return_value,
+		    (long) ((end.tv_sec - start.tv_sec) * 1000000
+			    + (end.tv_usec - start.tv_usec)));
+    }
+
+  fclose (manifest);
+  free_snapshot (base);
+  error ("%d programs, %d passed or ran, %d did not\n",
+	 programs, programs - bad, bad);
+  return (bad == 0 ? 0 : 1);
+}
+
+
+/* Load PROGRAM into a machine restored from BASE and run it, with its
+   console reading from the file INPUT and writing into memory.  If
+   EXPECTED is not NULL, compare the output with that file.  Return the
+   program's status (see run_batch). */
+
+static const char *
+run_batch_entry (spim_snapshot *base, char *program, char *input,
+		 char *expected)
+{
+  char *output = NULL;
+  size_t output_len = 0;
+  char *want;
+  size_t want_len;
+  FILE *saved_out = console_out.f;
+  int saved_in = console_in.i;
+  bool completed, continuable = false;
+  const char *status;
+
+  spim_return_value = 0;
+  console_in.i = open (input == NULL ? "/dev/null" : input, O_RDONLY);
+  if ((int) console_in.i < 0)
+    {
+      console_in.i = saved_in;
+      return ("noinput");
+    }
+
+  restore_snapshot (base);
+  if (!read_assembly_file (program))
+    {
+      close (console_in.i);
+      console_in.i = saved_in;
+      return ("noload");
+    }
+  initialize_run_stack (1, &program);
+
+  console_out.f = open_memstream (&output, &output_len);
+  completed = run_loaded_program (&continuable);
+  fclose (console_out.f);
+  console_out.f = saved_out;
+  close (console_in.i);
+  console_in.i = saved_in;
+
+  if (!completed)
+    status = "error";
+  else if (stopped_at_limit (continuable))
+    {
+      status = "limit";
+      report_run_limit ();
+    }
+  else if (expected == NULL)
+    status = "ran";
+  else if ((want = read_whole_file (expected, &want_len)) == NULL)
+    status = "fail";
+  else
+    {
+      status = (want_len == output_len && memcmp (want, output, want_len) == 0)
+	? "pass" : "fail";
+      free (want);
+    }
+  free (output);
+  return (status);
+}
+
+
+/* Run the program loaded into memory from its start, within the run
+   limits, and set CONTINUABLE as run_program does.  Return false if it
+   stopped on a run-time error. */
+
+static bool
+run_loaded_program (bool *continuable)
+{
+  if (setjmp (spim_top_level_env))
+    return (false);
+  spim_steps = 0;
+  spim_syscalls = 0;
+  set_run_time_limit (max_run_ms);
+  run_program (find_symbol_address (DEFAULT_RUN_LOCATION), run_steps (),
+	       false, false, continuable);
+  return (true);
+}
+
+
+/* Limits on a run (-max_steps and -max_ms).
+
+   The step limit is the number of steps given to run_program, and the
+   time limit is checked by run_spim every CHECK_INTERVAL steps, so
+   neither costs anything per instruction. */
+
+static int
+run_steps ()
+{
+  return (max_run_steps > 0 ? max_run_steps : DEFAULT_RUN_STEPS);
+}
+
+
+/* Return true if the run that just returned CONTINUABLE was stopped by
+   one of the limits, rather than by the program exiting. */
+
+static bool
+stopped_at_limit (bool continuable)
+{
+  return (spim_timed_out
+	  || (continuable && max_run_steps > 0 && spim_steps >= max_run_steps));
+}
+
+
+/* The label nearest below an address in the same text segment. */
+
+typedef struct
+{
+  mem_addr addr;
+  label *nearest;
+} label_search;
+
+
+static void
+nearer_label (label *l, void *arg)
+{
+  label_search *search = (label_search *) arg;
+  bool kernel = (search->addr >= K_TEXT_BOT);
+
+  if (SYMBOL_IS_DEFINED (l)
+      && (mem_addr) l->addr <= search->addr
+      && ((mem_addr) l->addr >= K_TEXT_BOT) == kernel
+      && (mem_addr) l->addr >= TEXT_BOT
+      && (search->nearest == NULL || l->addr > search->nearest->addr))
+    search->nearest = l;
+}
+
+
+/* Report, on standard error, why a run stopped at a limit and the state
+   it stopped in, one "key TAB value" line each: the limit, the number
+   of instructions executed, the PC, the nearest label below the PC
+   (as label+offset), and the general, HI and LO registers.  Set spim's
+   exit value to LIMIT_EXIT_VALUE. */
+
+static void
+report_run_limit ()
+{
+  label_search search;
+  int i;
+
+  search.addr = PC;
+  search.nearest = NULL;
+  map_symbols (nearer_label, &search);
+
+  error ("limit\t%s\n", spim_timed_out ? "max_ms" : "max_steps");
+  error ("steps\t%lld\n", spim_steps);
+  error ("pc\t0x%08x\n", PC);
+  if (search.nearest != NULL)
+    error ("label\t%s+%d\n", search.nearest->name,
+	   (int) (PC - search.nearest->addr));
+  else
+    error ("label\t-\n");
+  for (i = 0; i < R_LENGTH; i ++)
+    error ("%s\t0x%08x\n", int_reg_names[i], R[i]);
+  error ("hi\t0x%08x\n", HI);
+  error ("lo\t0x%08x\n", LO);
+  spim_return_value = LIMIT_EXIT_VALUE;
+}
+
+
+/* Return the contents of the file FILE_NAME, and its length in LEN, or
+   NULL if it cannot be read. */
+
+static char *
+read_whole_file (char *file_name, size_t *len)
+{
+  FILE *f = fopen (file_name, "rb");
+  char *buf;
+  long size;
+
+  if (f == NULL)
+    return (NULL);
+  if (fseek (f, 0, SEEK_END) != 0 || (size = ftell (f)) < 0)
+    {
+      fclose (f);
+      return (NULL);
+    }
+  rewind (f);
+  buf = (char *) xmalloc (size + 1);
+  *len = fread (buf, 1, size, f);
+  fclose (f);
+  return (buf);
+}
+
+
 /* SPIM commands */
 
 enum {
@@ -414,7 +861,9 @@ enum {
   DELETE_BKPT_CMD,
   LIST_BKPT_CMD,
   DUMPNATIVE_TEXT_CMD,
-  DUMP_TEXT_CMD
+  DUMP_TEXT_CMD,
+  SNAPSHOT_CMD,
+  RESTORE_CMD
 };
 
 
@@ -423,6 +872,18 @@ enum {
    previous one.  Return true if the command was to redo the previous
    command. */
 
+/* Name a defined label by its address, so that the PC samples in the
+   trace can be attributed to code.  A name there is no memory for is
+   left out, and its samples are shown by address. */
+
+static void
+name_label_in_trace (label *l, void *ring)
+{
+  if (SYMBOL_IS_DEFINED (l))
+    trace_name ((trace_ring *) ring, (uint32_t) l->addr, l->name);
+}
+
+
 static bool
 parse_spim_command (bool redo)
 {
@@ -638,6 +1099,10 @@ parse_spim_command (bool redo)
       write_output (message_out, "list -- List all breakpoints\n");
       write_output (message_out, "dump [ \"FILE\" ] -- Dump binary code to spim.dump or FILE in network byte order\n");
       write_output (message_out, "dumpnative [ \"FILE\" ] -- Dump binary code to spim.dump or FILE in host byte order\n");
+      write_output (message_out,
+		    "snapshot \"FILE\" -- Save the memory, registers, and symbols to FILE\n");
+      write_output (message_out,
+		    "restore \"FILE\" -- Restore the state saved by snapshot in FILE\n");
       write_output (message_out,
 		    ". -- Rest of line is assembly instruction to execute\n");
       write_output (message_out, "<cr> -- Newline reexecutes previous command\n");
@@ -729,6 +1194,35 @@ parse_spim_command (bool redo)
         return (0);
       }
 
+    case SNAPSHOT_CMD:
+    case RESTORE_CMD:
+      {
+	int token = (redo ? prev_token : read_token ());
+	spim_snapshot *snap;
+
+	if (!redo) flush_to_newline ();
+	if (token != Y_STR)
+	  {
+	    error ("Must supply a snapshot file name\n");
+	    return (0);
+	  }
+	if (cmd == SNAPSHOT_CMD)
+	  {
+	    snap = take_snapshot ();
+	    if (!write_snapshot (snap, (char *) yylval.p))
+	      error ("Cannot write snapshot file %s\n", (char *) yylval.p);
+	  }
+	else
+	  {
+	    snap = read_snapshot ((char *) yylval.p);
+	    if (snap == NULL || !restore_snapshot (snap))
+	      error ("Cannot restore snapshot file %s\n", (char *) yylval.p);
+	  }
+	free_snapshot (snap);
+	prev_cmd = NOP_CMD;
+	return (0);
+      }
+
     default:
       while (read_token () != Y_NL) ;
       error ("Unknown spim command\n");
@@ -783,6 +1277,10 @@ read_assembly_command ()
     return (DUMPNATIVE_TEXT_CMD);
   else if (str_prefix ((char *) yylval.p, "dump", 4))
     return (DUMP_TEXT_CMD);
+  else if (str_prefix ((char *) yylval.p, "snapshot", 4))
+    return (SNAPSHOT_CMD);
+  else if (str_prefix ((char *) yylval.p, "restore", 4))
+    return (RESTORE_CMD);
   else if (*(char *) yylval.p == '?')
     return (HELP_CMD);
   else if (*(char *) yylval.p == '.')
@@ -1219,17 +1717,87 @@ read_token ()
 }
 
 
+/* Open the file NAME for a dump, with a large buffer.  Return NULL if
+   it cannot be opened. */
+
+static FILE *
+open_dump_file (char *name)
+{
+  FILE *fp = fopen (name, "wb");
+
+  if (fp == NULL)
+    {
+      perror (name);
+      return (NULL);
+    }
+  setvbuf (fp, NULL, _IOFBF, DUMP_BUFFER_SIZE);
+  return (fp);
+}
+
+
+/* Write to FP a binary image of memory FROM...TO: its address and its
+   length in bytes, then its words, all in network byte order.  Text is
+   written as the encoding of each instruction, as the dump command
+   does. */
+
+static void
+dump_binary_seg (FILE *fp, mem_addr from, mem_addr to, bool text)
+{
+  uint32 words[1024];
+  int n = 0;
+  mem_addr addr;
+
+  from = ROUND_DOWN (from, BYTES_PER_WORD);
+  to = ROUND_UP (to, BYTES_PER_WORD);
+  words[0] = htonl (from);
+  words[1] = htonl (to > from ? to - from : 0);
+  (void)fwrite (words, sizeof (uint32), 2, fp);
+
+  for (addr = from; addr < to; addr += BYTES_PER_WORD)
+    {
+      words[n++] = htonl ((uint32) (text
+				    ? inst_encode (read_mem_inst (addr))
+				    : read_mem_word (addr)));
+      if (n == 1024)
+	{
+	  (void)fwrite (words, sizeof (uint32), n, fp);
+	  n = 0;
+	}
+    }
+  (void)fwrite (words, sizeof (uint32), n, fp);
+}
+
+
 /* 
- * Writes the contents of the (user and optionally kernel) data segment into data.asm file. 
- * If data.asm already exists, it's replaced.
+ * Writes the contents of the (user and optionally kernel) data segment into data.asm file
+ * (or with -dump_binary, the data, stack, and kernel data segments into data.bin).
+ * If the file already exists, it's replaced.  Output is written as it is formatted.
  */
 
 static void
 dump_data_seg(bool kernel_also)
 {
   static str_stream ss;
-  ss_clear (&ss);
+  FILE *fp;
+
+  if (dump_binary)
+    {
+      if ((fp = open_dump_file ("data.bin")) == NULL)
+	return;
+      dump_binary_seg (fp, DATA_BOT, data_top, false);
+      if (kernel_also)
+	{
+	  dump_binary_seg (fp, R[29], STACK_TOP, false);
+	  dump_binary_seg (fp, K_DATA_BOT, k_data_top, false);
+	}
+      fclose (fp);
+      return;
+    }
 
+  if ((fp = open_dump_file ("data.asm")) == NULL)
+    return;
+  ss_clear (&ss);
+  ss_sink (&ss, fp);
   if (kernel_also) 
     {
       format_data_segs (&ss);
@@ -1239,25 +1807,44 @@ dump_data_seg(bool kernel_also)
       ss_printf (&ss, "\tDATA\n");
       format_mem (&ss, DATA_BOT, data_top);
     }
-  
-  FILE *fp;
-  fp = fopen ("data.asm", "w");
-  fprintf (fp, "%s", ss_to_string (&ss));
+  ss_sink (&ss, NULL);
   fclose (fp);
 }
 
 
 /* 
- * Writes the contents of the (user and optionally kernel) text segment in text.asm file. 
- * If data.asm already exists, it's replaced.
+ * Writes the contents of the (user and optionally kernel) text segment in text.asm file
+ * (or with -dump_binary, text.bin).
+ * If the file already exists, it's replaced.  Output is written as it is formatted.
  */
 
 static void
 dump_text_seg(bool kernel_also)
 {
   static str_stream ss;
-  ss_clear (&ss);
+  FILE *fp;
 
+  if (dump_binary)
+    {
+      /* Only the instructions assembled so far, not the whole segments. */
+      if ((fp = open_dump_file ("text.bin")) == NULL)
+	return;
+      user_kernel_text_segment (false);
+      dump_binary_seg (fp, TEXT_BOT, current_text_pc (), true);
+      if (kernel_also)
+	{
+	  user_kernel_text_segment (true);
+	  dump_binary_seg (fp, K_TEXT_BOT, current_text_pc (), true);
+	  user_kernel_text_segment (false);
+	}
+      fclose (fp);
+      return;
+    }
+
+  if ((fp = open_dump_file ("text.asm")) == NULL)
+    return;
+  ss_clear (&ss);
+  ss_sink (&ss, fp);
   if (kernel_also)
     {
       format_insts (&ss, TEXT_BOT, text_top);
@@ -1269,9 +1856,6 @@ dump_text_seg(bool kernel_also)
       ss_printf (&ss, "\n\tUSER TEXT SEGMENT\n");
       format_insts (&ss, TEXT_BOT, text_top);
     }
-  
-  FILE *fp;
-  fp = fopen ("text.asm", "w");
-  fprintf (fp, "%s", ss_to_string (&ss));
+  ss_sink (&ss, NULL);
   fclose (fp);
 }
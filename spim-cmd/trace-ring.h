@@ -0,0 +1,235 @@
+/* SPIM S20 MIPS simulator.
+   Binary execution trace, kept in a preallocated ring buffer.
+
+   Each event is a fixed 16-byte record: a timestamp, a kind, and one
+   argument.  Recording one is a timestamp read and three stores into
+   the ring, so tracing can be left on for long runs; once the ring is
+   full the oldest events are overwritten.  A ring has a single writer
+   and needs no locks (give each writing thread its own ring).
+
+   The trace is written to a file when the run ends, as
+
+	header		(struct trace_header)
+	events		(struct trace_event, oldest first)
+	names		(count of them, then for each its id, its length,
+			 and its characters, all as uint32 but the characters)
+
+   Names give meaning to event arguments: the interpreter names each
+   def by its source line, and spim names each text label by its
+   address.  The dwislpy-trace-decode tool prints a trace file.
+
+   This file is used both by spim (run.cpp, spim.cpp) and by the
+   DwiSlpy interpreter, so it is self-contained. */
+
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+#define TRACE_MAGIC "DWTRACE1"
+#define TRACE_DEFAULT_EVENTS (1 << 20)
+
+
+/* Kinds of events.  ARG is given for each. */
+
+enum trace_kind
+{
+  /* From the DwiSlpy interpreter: */
+  TRACE_CALL = 1,		/* Entered the def on line ARG */
+  TRACE_RETURN = 2,		/* Left the def on line ARG */
+  TRACE_LOOP = 3,		/* Began an iteration of the while on line ARG */
+  TRACE_INPUT = 4,		/* Read input for the input() on line ARG */
+  TRACE_PRINT = 5,		/* Printed for the print on line ARG */
+
+  /* From spim: */
+  TRACE_PC = 16,		/* Sampled the PC, which was ARG */
+  TRACE_SYSCALL = 17		/* Made syscall number ARG */
+};
+
+
+typedef struct trace_event
+{
+  uint64_t time;		/* In ticks, see trace_header */
+  uint32_t kind;
+  uint32_t arg;
+} trace_event;
+
+
+typedef struct trace_header
+{
+  char magic[8];		/* TRACE_MAGIC */
+  uint64_t ticks_per_sec;	/* Rate of the event timestamps */
+  uint64_t capacity;		/* Size of the ring */
+  uint64_t written;		/* Events recorded, including overwritten ones */
+  uint64_t count;		/* Events in the file */
+} trace_header;
+
+
+typedef struct trace_ring
+{
+  trace_event *events;
+  uint64_t mask;		/* Capacity - 1 (capacity is a power of 2) */
+  uint64_t head;		/* Events recorded so far */
+  uint64_t start_ticks;		/* For calibrating the tick rate */
+  uint64_t start_ns;
+  char *names;			/* Packed name records, see above */
+  size_t names_len;
+  size_t names_size;
+  uint32_t name_count;
+} trace_ring;
+
+
+
+/* The time now in nanoseconds, from the monotonic clock. */
+
+static inline uint64_t
+trace_clock_ns ()
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+
+/* The timestamp for an event: the cycle counter where there is one, as
+   it is much cheaper to read than the clock. */
+
+static inline uint64_t
+trace_ticks ()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return (__rdtsc ());
+#else
+  return (trace_clock_ns ());
+#endif
+}
+
+
+/* Make RING hold the last EVENTS events (rounded up to a power of 2).
+   The ring is touched here so that recording never takes a page
+   fault.  Return false if it cannot be allocated. */
+
+static inline bool
+trace_open (trace_ring *ring, uint64_t events)
+{
+  uint64_t capacity = 1;
+
+  while (capacity < events)
+    capacity <<= 1;
+  memset (ring, 0, sizeof (*ring));
+  ring->events = (trace_event *) malloc (capacity * sizeof (trace_event));
+  if (ring->events == NULL)
+    return (false);
+  memset (ring->events, 0, capacity * sizeof (trace_event));
+  ring->mask = capacity - 1;
+  ring->start_ticks = trace_ticks ();
+  ring->start_ns = trace_clock_ns ();
+  return (true);
+}
+
+
+static inline void
+trace_close (trace_ring *ring)
+{
+  free (ring->events);
+  free (ring->names);
+  memset (ring, 0, sizeof (*ring));
+}
+
+
+/* Record an event. */
+
+static inline void
+trace_record (trace_ring *ring, uint32_t kind, uint32_t arg)
+{
+  trace_event *e = &ring->events[ring->head & ring->mask];
+
+  e->time = trace_ticks ();
+  e->kind = kind;
+  e->arg = arg;
+  ring->head += 1;
+}
+
+
+/* Give the name NAME to the argument value ID.  Return false, leaving
+   the name out, if there is no memory for it. */
+
+static inline bool
+trace_name (trace_ring *ring, uint32_t id, const char *name)
+{
+  uint32_t len = (uint32_t) strlen (name);
+  size_t need = ring->names_len + 2 * sizeof (uint32_t) + len;
+
+  if (need > ring->names_size)
+    {
+      char *names = (char *) realloc (ring->names, need * 2);
+
+      if (names == NULL)
+	return (false);
+      ring->names = names;
+      ring->names_size = need * 2;
+    }
+  memcpy (ring->names + ring->names_len, &id, sizeof (id));
+  memcpy (ring->names + ring->names_len + sizeof (id), &len, sizeof (len));
+  memcpy (ring->names + ring->names_len + 2 * sizeof (id), name, len);
+  ring->names_len = need;
+  ring->name_count += 1;
+  return (true);
+}
+
+
+/* Write the trace in RING to the file FILE_NAME.  Return false if the
+   file cannot be written. */
+
+static inline bool
+trace_write (trace_ring *ring, const char *file_name)
+{
+  FILE *f = fopen (file_name, "wb");
+  trace_header h;
+  uint64_t capacity = ring->mask + 1;
+  uint64_t first;
+  uint64_t elapsed_ns = trace_clock_ns () - ring->start_ns;
+  uint64_t elapsed_ticks = trace_ticks () - ring->start_ticks;
+  bool ok;
+
+  if (f == NULL)
+    return (false);
+
+  memcpy (h.magic, TRACE_MAGIC, sizeof (h.magic));
+  h.ticks_per_sec = elapsed_ns == 0 ? 1000000000
+    : (uint64_t) ((double) elapsed_ticks * 1e9 / elapsed_ns);
+  h.capacity = capacity;
+  h.written = ring->head;
+  h.count = ring->head < capacity ? ring->head : capacity;
+  fwrite (&h, sizeof (h), 1, f);
+
+  /* The oldest event is at the head once the ring has wrapped. */
+  first = ring->head - h.count;
+  if ((first & ring->mask) + h.count <= capacity)
+    fwrite (&ring->events[first & ring->mask], sizeof (trace_event), h.count, f);
+  else
+    {
+      uint64_t part = capacity - (first & ring->mask);
+      fwrite (&ring->events[first & ring->mask], sizeof (trace_event), part, f);
+      fwrite (&ring->events[0], sizeof (trace_event), h.count - part, f);
+    }
+
+  fwrite (&ring->name_count, sizeof (ring->name_count), 1, f);
+  if (ring->names_len > 0)
+    fwrite (ring->names, 1, ring->names_len, f);
+
+  ok = !ferror (f);
+  fclose (f);
+  return (ok);
+}
+
+#endif